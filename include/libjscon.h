@@ -24,7 +24,9 @@
 #define JSCON_PUBLIC_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include <stdarg.h>
 
 
 #define DEBUG_MODE 1
@@ -48,10 +50,173 @@ enum jscon_type {
 };
 
 
+/* what an allocation is made for, given to jscon_allocator_t */
+enum jscon_alloc_category {
+    JSCON_ALLOC_NODE = 0,   /* items, composites and their branch lists */
+    JSCON_ALLOC_KEY,        /* item keys */
+    JSCON_ALLOC_STRING,     /* string values */
+    JSCON_ALLOC_HASHTABLE,  /* composites key lookup */
+    JSCON_ALLOC_ARENA,      /* jscon_parser_t memory, holds its items */
+    JSCON_ALLOC_OTHER,      /* parsers, plans and tapes */
+    JSCON_ALLOC_NUM_CATEGORY
+};
+
+/* JSCON ALLOCATOR
+ * every allocation made by jscon goes through these callbacks
+ *      alloc_cb: like malloc(), category tells what its for
+ *      realloc_cb: like realloc()
+ *      free_cb: like free(), ptr may be NULL
+ *      context: user data given to the callbacks */
+typedef struct jscon_allocator_s {
+    void* (*alloc_cb)(void *context, size_t size, enum jscon_alloc_category category);
+    void* (*realloc_cb)(void *context, void *ptr, size_t size, enum jscon_alloc_category category);
+    void (*free_cb)(void *context, void *ptr);
+    void *context;
+} jscon_allocator_t;
+
+/* JSCON ALLOCATION STATISTICS
+ * tallied by jscon_counting_allocator(), indexed by category
+ *      count: allocations made
+ *      bytes: bytes allocated, in total
+ *      in_use: bytes allocated and not yet freed */
+typedef struct jscon_alloc_stats_s {
+    size_t count[JSCON_ALLOC_NUM_CATEGORY];
+    size_t bytes[JSCON_ALLOC_NUM_CATEGORY];
+    size_t in_use[JSCON_ALLOC_NUM_CATEGORY];
+} jscon_alloc_stats_t;
+
+
+/* struct member datatypes for jscon_decode_struct() and
+ * jscon_encode_struct() */
+enum jscon_field_type {
+    JSCON_FIELD_NONE = 0,
+    JSCON_FIELD_CHAR,       /* char */
+    JSCON_FIELD_STRING,     /* char[size] */
+    JSCON_FIELD_INT,        /* int */
+    JSCON_FIELD_LONG,       /* long */
+    JSCON_FIELD_LLONG,      /* long long */
+    JSCON_FIELD_FLOAT,      /* float */
+    JSCON_FIELD_DOUBLE,     /* double */
+    JSCON_FIELD_BOOLEAN,    /* bool */
+    JSCON_FIELD_STRUCT,     /* struct, described by nested */
+};
+
+/* JSCON FIELD DESCRIPTOR
+ * describes how a struct member maps to a json key, a struct is
+ * described by an array of fields terminated by a NULL key entry
+ *      key: json key of the member
+ *      type: member datatype
+ *      offset: offsetof() the member
+ *      size: sizeof() the member, checked against type
+ *      nested: descriptor of member if type is JSCON_FIELD_STRUCT */
+typedef struct jscon_field_s {
+    const char *key;
+    enum jscon_field_type type;
+    size_t offset;
+    size_t size;
+    const struct jscon_field_s *nested;
+} jscon_field_t;
+
+#define JSCON_FIELD(key, type, st, member) \
+    { (key), (type), offsetof(st, member), sizeof(((st*)0)->member), NULL }
+#define JSCON_FIELD_NESTED(key, nested, st, member) \
+    { (key), JSCON_FIELD_STRUCT, offsetof(st, member), sizeof(((st*)0)->member), (nested) }
+
+
+/* JSCON LAZY CURSOR
+ * a position at a json text, its value is only decoded when
+ * requested, and no jscon_item_t is created. cursors are meant to be
+ * kept on the stack, their members shouldn't be accessed directly
+ *      start: first char of the value (NULL if not found)
+ *      next: position of last element returned by jscon_arr_next() */
+typedef struct jscon_value_s {
+    char *start;
+    char *next;
+} jscon_value_t;
+
+/* JSCON LAZY DOCUMENT
+ * buffer: the json text, which must outlive every cursor pointing to it
+ * root: cursor to the json text root value */
+typedef struct jscon_doc_s {
+    char *buffer;
+    jscon_value_t root;
+} jscon_doc_t;
+
+
+/* JSCON SAX EVENTS
+ * callbacks fired by jscon_sax_parse() as the json text is read, any
+ * of them may be NULL. keys and strings point to the json text and
+ * aren't nul terminated. returning false stops parsing */
+typedef struct jscon_sax_s {
+    bool (*on_object_begin)(void *context);
+    bool (*on_object_end)(void *context);
+    bool (*on_array_begin)(void *context);
+    bool (*on_array_end)(void *context);
+    bool (*on_key)(void *context, const char *key, size_t len);
+    bool (*on_string)(void *context, const char *string, size_t len);
+    bool (*on_integer)(void *context, long long i_number);
+    bool (*on_double)(void *context, double d_number);
+    bool (*on_boolean)(void *context, bool boolean);
+    bool (*on_null)(void *context);
+} jscon_sax_t;
+
+
 /* forwarding, definition at jscon-common.h */
 typedef struct jscon_item_s jscon_item_t;
 /* jscon_parser() callback */
 typedef jscon_item_t* (jscon_cb)(jscon_item_t*);
+/* forwarding, definition at jscon-scanf.c */
+typedef struct jscon_scanf_plan_s jscon_scanf_plan_t;
+/* forwarding, definition at jscon-printf.c */
+typedef struct jscon_printf_plan_s jscon_printf_plan_t;
+/* forwarding, definition at jscon-tape.c */
+typedef struct jscon_tape_s jscon_tape_t;
+/* forwarding, definition at jscon-parser.c */
+typedef struct jscon_parser_s jscon_parser_t;
+/* forwarding, definition at jscon-intern.c */
+typedef struct jscon_intern_s jscon_intern_t;
+/* forwarding, definition at jscon-query.c */
+typedef struct jscon_query_s jscon_query_t;
+/* jscon_query_exec() callback, returning false stops the query */
+typedef bool (jscon_query_cb)(jscon_item_t *item, void *context);
+/* forwarding, definition at jscon-index.c */
+typedef struct jscon_index_s jscon_index_t;
+/* forwarding, definition at jscon-store.c */
+typedef struct jscon_store_s jscon_store_t;
+typedef struct jscon_version_s jscon_version_t;
+
+/* order in which jscon_iter_t walks a tree */
+enum jscon_iter_order {
+    JSCON_ITER_PREORDER,    /* items before their branches */
+    JSCON_ITER_POSTORDER,   /* branches before their items */
+    JSCON_ITER_COMPOSITE,   /* objects and arrays only, in preorder */
+};
+
+/* nesting depth an iterator walks before its stack goes to the heap */
+#define JSCON_ITER_STACK 32
+
+/* JSCON ITERATOR
+ * tree walk state held by the caller, the tree is only read from, so
+ * any amount of iterators may walk the same tree at once. iterators
+ * are meant to be kept on the stack, their members shouldn't be
+ * accessed directly
+ *      order: the walk order
+ *      root: item yet to be returned first, on preorder walks
+ *      depth: amount of frames in use
+ *      capacity: amount of frames heap_stack holds
+ *      heap_stack: frames of walks deeper than JSCON_ITER_STACK
+ *      stack: item being walked and its next branch, per depth */
+typedef struct jscon_iter_s {
+    enum jscon_iter_order order;
+    const jscon_item_t *root;
+    size_t depth;
+    size_t capacity;
+    struct jscon_iter_frame_s *heap_stack;
+    struct jscon_iter_frame_s {
+        const jscon_item_t *item;
+        size_t branch;
+    } stack[JSCON_ITER_STACK];
+} jscon_iter_t;
 
 
 /* JSCON INIT */
@@ -64,6 +229,12 @@ jscon_item_t *jscon_double(const char *key, double d_number);
 jscon_item_t *jscon_number(const char *key, double d_number);
 jscon_item_t *jscon_string(const char *key, char *string);
 
+/* JSCON ALLOCATORS
+ * install before any jscon allocation is made, the allocator
+ * must stay valid while any of its memory is in use */
+const jscon_allocator_t* jscon_set_allocator(const jscon_allocator_t *new_allocator);
+jscon_allocator_t jscon_counting_allocator(jscon_alloc_stats_t *stats);
+
 /* JSCON DESTRUCTORS
  * clean up jscon item and global allocated keys */
 void jscon_destroy(jscon_item_t *item);
@@ -72,11 +243,87 @@ void jscon_destroy(jscon_item_t *item);
  * parse buffer and returns a jscon item */
 jscon_item_t* jscon_parse(char *buffer);
 jscon_cb* jscon_parse_cb(jscon_cb *new_cb);
+/* reusable parser context, items parsed with it are read-only
+    and live until its next reset. while it parses, every jscon
+    allocation made at the same thread (including by its callback)
+    comes from its memory, and freeing any of it is a no-op, so it is
+    only released at the next reset */
+jscon_parser_t* jscon_parser_init();
+void jscon_parser_destroy(jscon_parser_t *parser);
+void jscon_parser_reset(jscon_parser_t *parser);
+jscon_cb* jscon_parser_set_cb(jscon_parser_t *parser, jscon_cb *new_cb);
+void jscon_parser_set_max_depth(jscon_parser_t *parser, size_t max_depth);
+jscon_item_t* jscon_parser_parse(jscon_parser_t *parser, char *buffer);
+void jscon_parser_set_allocator(jscon_parser_t *parser, const jscon_allocator_t *allocator);
+void jscon_parser_set_intern(jscon_parser_t *parser, jscon_intern_t *intern);
+/* pool of keys shared by parsed items, is_shared makes it thread-safe */
+jscon_intern_t* jscon_intern_init(bool is_shared);
+void jscon_intern_destroy(jscon_intern_t *intern);
+const char* jscon_intern(jscon_intern_t *intern, const char *key);
+size_t jscon_intern_size(jscon_intern_t *intern);
+/* fire events as json values are read, no item is created */
+bool jscon_sax_parse(char *buffer, const jscon_sax_t *sax, void *context);
 /* only parse json values from given parameters */
 void jscon_scanf(char *buffer, char *format, ...);
+void jscon_vscanf(char *buffer, char *format, va_list ap);
+jscon_scanf_plan_t* jscon_scanf_compile(char *format);
+void jscon_scanf_exec(const jscon_scanf_plan_t *plan, char *buffer, ...);
+void jscon_scanf_destroy(jscon_scanf_plan_t *plan);
+/* fill struct from json object, as described by desc */
+size_t jscon_decode_struct(const jscon_field_t *desc, char *buffer, void *p_struct);
  
+/* JSCON LAZY DECODING
+ * walk through json text, decoding values only when requested */
+jscon_value_t* jscon_doc_init(jscon_doc_t *doc, char *buffer);
+bool jscon_obj_find_field(const jscon_value_t *object, const char *key, jscon_value_t *p_field);
+bool jscon_arr_next(jscon_value_t *array, jscon_value_t *p_element);
+enum jscon_type jscon_value_get_type(const jscon_value_t *value);
+bool jscon_value_get_boolean(const jscon_value_t *value);
+char* jscon_value_get_string(const jscon_value_t *value, size_t *p_len);
+double jscon_value_get_double(const jscon_value_t *value);
+long long jscon_value_get_integer(const jscon_value_t *value);
+jscon_item_t* jscon_value_parse(const jscon_value_t *value);
+
+/* JSCON TAPE
+ * read-only flat document, values are referred to by their tape
+ * index. root is always at 0, and 0 is returned for not found */
+jscon_tape_t* jscon_tape_parse(char *buffer);
+jscon_tape_t* jscon_freeze(const jscon_item_t *root);
+void jscon_tape_destroy(jscon_tape_t *tape);
+size_t jscon_tape_size(const jscon_tape_t *tape, size_t index);
+size_t jscon_tape_iter_next(const jscon_tape_t *tape, size_t index);
+size_t jscon_tape_get_branch(const jscon_tape_t *tape, size_t index, const char *key);
+size_t jscon_tape_get_byindex(const jscon_tape_t *tape, size_t index, size_t branch);
+enum jscon_type jscon_tape_get_type(const jscon_tape_t *tape, size_t index);
+char* jscon_tape_get_key(const jscon_tape_t *tape, size_t index);
+bool jscon_tape_get_boolean(const jscon_tape_t *tape, size_t index);
+char* jscon_tape_get_string(const jscon_tape_t *tape, size_t index);
+double jscon_tape_get_double(const jscon_tape_t *tape, size_t index);
+long long jscon_tape_get_integer(const jscon_tape_t *tape, size_t index);
+
+/* JSCON STORE
+ * tree edited by a single writer, and published as versions which
+ * readers acquire without locking. versions are frozen tapes, each
+ * publish freezes the whole tree and costs O(document) */
+jscon_store_t* jscon_store_init(jscon_item_t *root);
+void jscon_store_destroy(jscon_store_t *store);
+jscon_item_t* jscon_store_get_root(jscon_store_t *store);
+size_t jscon_store_publish(jscon_store_t *store);
+jscon_version_t* jscon_store_acquire(jscon_store_t *store);
+void jscon_version_release(jscon_version_t *version);
+const jscon_tape_t* jscon_version_get_tape(const jscon_version_t *version);
+size_t jscon_version_get_number(const jscon_version_t *version);
+
 /* JSCON ENCODING */
 char* jscon_stringify(jscon_item_t *root, enum jscon_type type);
+/* only encode json values from given parameters */
+size_t jscon_snprintf(char *buffer, size_t size, char *format, ...);
+size_t jscon_vsnprintf(char *buffer, size_t size, char *format, va_list ap);
+jscon_printf_plan_t* jscon_printf_compile(char *format);
+size_t jscon_printf_exec(const jscon_printf_plan_t *plan, char *buffer, size_t size, ...);
+void jscon_printf_destroy(jscon_printf_plan_t *plan);
+/* encode struct to json object, as described by desc */
+size_t jscon_encode_struct(const jscon_field_t *desc, const void *p_struct, char *buffer, size_t size);
 
 /* JSCON UTILITIES */
 size_t jscon_size(const jscon_item_t* item);
@@ -85,6 +332,10 @@ jscon_item_t* jscon_dettach(jscon_item_t *item);
 void jscon_delete(jscon_item_t *item, const char *key);
 jscon_item_t* jscon_iter_composite_r(jscon_item_t *item, jscon_item_t **p_current_item);
 jscon_item_t* jscon_iter_next(jscon_item_t* item);
+/* walks without writing to the tree, safe to share between threads */
+void jscon_iter_init(jscon_iter_t *iter, const jscon_item_t *root, enum jscon_iter_order order);
+jscon_item_t* jscon_iter_step(jscon_iter_t *iter);
+void jscon_iter_destroy(jscon_iter_t *iter);
 jscon_item_t* jscon_clone(jscon_item_t *item);
 char* jscon_typeof(const jscon_item_t* item);
 char* jscon_strdup(const jscon_item_t* item);
@@ -94,6 +345,28 @@ int jscon_keycmp(const jscon_item_t* item, const char *key);
 int jscon_doublecmp(const jscon_item_t* item, const double d_number);
 int jscon_intcmp(const jscon_item_t* item, const long long i_number);
 
+/* JSCON QUERIES
+ * compiled JSONPath ("$.store.book[*].author") or JSON Pointer
+ * ("/store/book/0/author") queries, reusable across documents */
+jscon_query_t* jscon_query_compile(const char *query);
+size_t jscon_query_exec(const jscon_query_t *query, jscon_item_t *root, jscon_query_cb *cb, void *context);
+jscon_item_t* jscon_query_first(const jscon_query_t *query, jscon_item_t *root);
+void jscon_query_destroy(jscon_query_t *query);
+jscon_item_t* jscon_get_pointer(jscon_item_t *root, const char *pointer);
+/* every object member with key, through an index kept at root */
+jscon_item_t* const* jscon_find_all(jscon_item_t *root, const char *key, size_t *p_count);
+/* array of objects elements by the value of one of their fields */
+jscon_index_t* jscon_index_by(jscon_item_t *array, const char *field);
+jscon_item_t* jscon_index_lookup(const jscon_index_t *index, const char *string);
+jscon_item_t* jscon_index_lookup_integer(const jscon_index_t *index, long long i_number);
+/* compare items by content, and list what differs as a JSON Patch */
+uint64_t jscon_hash(const jscon_item_t *item);
+bool jscon_equal(const jscon_item_t *a, const jscon_item_t *b);
+jscon_item_t* jscon_diff(jscon_item_t *a, jscon_item_t *b);
+/* modify a tree in place, as told by a JSON Patch or Merge Patch */
+bool jscon_patch(jscon_item_t **p_root, jscon_item_t *patch);
+void jscon_merge_patch(jscon_item_t **p_root, jscon_item_t *patch);
+
 /* JSCON GETTERS */
 jscon_item_t* jscon_get_root(jscon_item_t* item);
 jscon_item_t* jscon_get_branch(jscon_item_t *item, const char *key);
@@ -107,6 +380,9 @@ bool jscon_get_boolean(const jscon_item_t* item);
 char* jscon_get_string(const jscon_item_t* item);
 double jscon_get_double(const jscon_item_t* item);
 long long jscon_get_integer(const jscon_item_t* item);
+/* parsed arrays of numbers only, without an item per element */
+const long long* jscon_get_int_array(const jscon_item_t *item, size_t *p_size);
+const double* jscon_get_double_array(const jscon_item_t *item, size_t *p_size);
 
 /* JSCON SETTERS */
 bool jscon_set_boolean(jscon_item_t* item, bool boolean);
@@ -25,12 +25,17 @@
 #include <string.h>
 #include <assert.h>
 
-#include "hashtable.h"
+#include <libjscon.h>
+#include "jscon-common.h"
+
+/* memory goes through the jscon allocation functions, so that it
+    comes from the installed jscon_allocator_t, or from a jscon_parser_t
+    arena while parsing with it */
 
 hashtable_t*
 hashtable_init()
 {
-    hashtable_t *new_hashtable = calloc(1, sizeof *new_hashtable);
+    hashtable_t *new_hashtable = Jscon_calloc(1, sizeof *new_hashtable, JSCON_ALLOC_HASHTABLE);
     assert(NULL != new_hashtable);
 
     return new_hashtable;
@@ -49,14 +54,14 @@ hashtable_destroy(hashtable_t *hashtable)
             entry_prev = entry;
             entry = entry->next;
 
-            free(entry_prev);
+            Jscon_free(entry_prev);
             entry_prev = NULL;
         }
     }
-    free(hashtable->bucket);
+    Jscon_free(hashtable->bucket);
     hashtable->bucket = NULL;
     
-    free(hashtable);
+    Jscon_free(hashtable);
     hashtable = NULL;
 }
 
@@ -79,7 +84,7 @@ _hashtable_genhash(const char *key, const size_t num_bucket)
 static hashtable_entry_t*
 _hashtable_pair(const char *key, const void *value)
 {
-    hashtable_entry_t *new_entry = calloc(1, sizeof *new_entry);
+    hashtable_entry_t *new_entry = Jscon_calloc(1, sizeof *new_entry, JSCON_ALLOC_HASHTABLE);
     assert(NULL != new_entry);
 
     new_entry->key = (char*)key;
@@ -93,7 +98,7 @@ hashtable_build(hashtable_t *hashtable, const size_t num_index)
 {
     hashtable->num_bucket = num_index;
 
-    hashtable->bucket = calloc(1, hashtable->num_bucket * sizeof *hashtable->bucket);
+    hashtable->bucket = Jscon_calloc(1, hashtable->num_bucket * sizeof *hashtable->bucket, JSCON_ALLOC_HASHTABLE);
     assert(NULL != hashtable->bucket);
 }
 
@@ -106,7 +111,7 @@ _hashtable_get_entry(hashtable_t *hashtable, const char *key)
 
     hashtable_entry_t *entry = hashtable->bucket[slot];
     while (NULL != entry){ //try to find key and return it
-        if (0 == strcmp(entry->key, key)){
+        if (entry->key == key || 0 == strcmp(entry->key, key)){
             return entry;
         }
         entry = entry->next;
@@ -135,7 +140,7 @@ hashtable_set(hashtable_t *hashtable, const char *key, const void *value)
 
     hashtable_entry_t *entry_prev;
     while (NULL != entry){
-        if (0 == strcmp(entry->key, key)){
+        if (entry->key == key || 0 == strcmp(entry->key, key)){
             return entry->value;
         }
         entry_prev = entry;
@@ -157,7 +162,7 @@ hashtable_remove(hashtable_t *hashtable, const char *key)
     hashtable_entry_t *entry = hashtable->bucket[slot];
     hashtable_entry_t *entry_prev = NULL;
     while (NULL != entry){
-        if (0 == strcmp(entry->key, key)){
+        if (entry->key == key || 0 == strcmp(entry->key, key)){
             if (NULL != entry_prev){
                 entry_prev->next = entry->next; 
             } else {
@@ -166,7 +171,7 @@ hashtable_remove(hashtable_t *hashtable, const char *key)
 
             entry->key = NULL;
 
-            free(entry);
+            Jscon_free(entry);
             entry = NULL;
             return;
         }
@@ -178,7 +183,7 @@ hashtable_remove(hashtable_t *hashtable, const char *key)
 dictionary_t*
 dictionary_init()
 {
-    dictionary_t *new_dictionary = calloc(1, sizeof *new_dictionary);
+    dictionary_t *new_dictionary = Jscon_calloc(1, sizeof *new_dictionary, JSCON_ALLOC_HASHTABLE);
     assert(NULL != new_dictionary);
 
     return new_dictionary;
@@ -198,7 +203,7 @@ dictionary_destroy(dictionary_t *dictionary)
             entry_prev = entry;
             entry = entry->next;
 
-            free(entry_prev->key);
+            Jscon_free(entry_prev->key);
             entry_prev->key = NULL;
 
             //free value if its tagged for freeing
@@ -206,24 +211,24 @@ dictionary_destroy(dictionary_t *dictionary)
                 (*entry_prev->free_cb)(entry_prev->value);
             }
 
-            free(entry_prev);
+            Jscon_free(entry_prev);
             entry_prev = NULL;
         }
     }
-    free(dictionary->bucket);
+    Jscon_free(dictionary->bucket);
     dictionary->bucket = NULL;
     
-    free(dictionary);
+    Jscon_free(dictionary);
     dictionary = NULL;
 }
 
 static dictionary_entry_t*
 _dictionary_pair(const char *key, const void *value, void (*free_cb)(void*))
 {
-    dictionary_entry_t *new_entry = calloc(1, sizeof *new_entry);
+    dictionary_entry_t *new_entry = Jscon_calloc(1, sizeof *new_entry, JSCON_ALLOC_HASHTABLE);
     assert(NULL != new_entry);
 
-    char *set_key = strndup(key, strlen(key));
+    char *set_key = Jscon_strndup(key, strlen(key), JSCON_ALLOC_KEY);
     assert(NULL != set_key);
 
     new_entry->key = set_key;
@@ -286,7 +291,7 @@ dictionary_remove(dictionary_t *dictionary, const char *key)
                 dictionary->bucket[slot] = entry->next; 
             }
 
-            free(entry->key);
+            Jscon_free(entry->key);
             entry->key = NULL;
 
             //free value if its tagged for freeing
@@ -294,7 +299,7 @@ dictionary_remove(dictionary_t *dictionary, const char *key)
                 (*entry->free_cb)(entry->value);
             }
 
-            free(entry);
+            Jscon_free(entry);
             entry = NULL;
 
             --dictionary->len;
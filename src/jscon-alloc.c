@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <libjscon.h>
+#include "jscon-common.h"
+
+#include "debug.h"
+
+
+static void*
+_jscon_libc_alloc(void *context, size_t size, enum jscon_alloc_category category)
+{
+    (void)context;
+    (void)category;
+    return malloc(size);
+}
+
+static void*
+_jscon_libc_realloc(void *context, void *ptr, size_t size, enum jscon_alloc_category category)
+{
+    (void)context;
+    (void)category;
+    return realloc(ptr, size);
+}
+
+static void
+_jscon_libc_free(void *context, void *ptr)
+{
+    (void)context;
+    free(ptr);
+}
+
+static const jscon_allocator_t _jscon_libc_allocator = {
+    .alloc_cb = &_jscon_libc_alloc,
+    .realloc_cb = &_jscon_libc_realloc,
+    .free_cb = &_jscon_libc_free,
+};
+
+/* allocator used by every thread, when not parsing with a jscon_parser_t */
+static const jscon_allocator_t *_jscon_allocator = &_jscon_libc_allocator;
+
+/* installs new_allocator for every allocation, or restores the libc
+    one if NULL. returns the allocator previously installed */
+const jscon_allocator_t*
+jscon_set_allocator(const jscon_allocator_t *new_allocator)
+{
+    const jscon_allocator_t *prev = _jscon_allocator;
+    _jscon_allocator = (NULL != new_allocator) ? new_allocator : &_jscon_libc_allocator;
+
+    return prev;
+}
+
+/* COUNTING ALLOCATOR HEADER
+ * kept before each block, so that its size and category are known
+ * when it is freed. sized to keep the block aligned as malloc's */
+union jscon_counting_header_u {
+    struct {
+        size_t size;
+        enum jscon_alloc_category category;
+    } info;
+    max_align_t align;
+};
+
+static void
+_jscon_counting_add(jscon_alloc_stats_t *stats, enum jscon_alloc_category category, size_t size)
+{
+    __atomic_add_fetch(&stats->count[category], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->bytes[category], size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->in_use[category], size, __ATOMIC_RELAXED);
+}
+
+static void*
+_jscon_counting_alloc(void *context, size_t size, enum jscon_alloc_category category)
+{
+    if (size > SIZE_MAX - sizeof(union jscon_counting_header_u)) return NULL;
+
+    union jscon_counting_header_u *header = malloc(sizeof *header + size);
+    if (NULL == header) return NULL;
+
+    header->info.size = size;
+    header->info.category = category;
+    _jscon_counting_add(context, category, size);
+
+    return header + 1;
+}
+
+static void
+_jscon_counting_free(void *context, void *ptr)
+{
+    if (NULL == ptr) return;
+
+    jscon_alloc_stats_t *stats = context;
+    union jscon_counting_header_u *header = (union jscon_counting_header_u*)ptr - 1;
+
+    __atomic_sub_fetch(&stats->in_use[header->info.category], header->info.size, __ATOMIC_RELAXED);
+    free(header);
+}
+
+/* a resized block is counted as a new allocation of its new size, at
+    the category it is resized for */
+static void*
+_jscon_counting_realloc(void *context, void *ptr, size_t size, enum jscon_alloc_category category)
+{
+    if (NULL == ptr){
+        return _jscon_counting_alloc(context, size, category);
+    }
+
+    jscon_alloc_stats_t *stats = context;
+    union jscon_counting_header_u *header = (union jscon_counting_header_u*)ptr - 1;
+    const size_t old_size = header->info.size;
+
+    if (size > SIZE_MAX - sizeof *header) return NULL;
+    header = realloc(header, sizeof *header + size);
+    if (NULL == header) return NULL;
+
+    __atomic_sub_fetch(&stats->in_use[header->info.category], old_size, __ATOMIC_RELAXED);
+    header->info.size = size;
+    header->info.category = category;
+    _jscon_counting_add(stats, category, size);
+
+    return header + 1;
+}
+
+/* returns a libc based allocator that tallies every allocation
+    by category at stats, which must outlive the allocator */
+jscon_allocator_t
+jscon_counting_allocator(jscon_alloc_stats_t *stats)
+{
+    jscon_allocator_t allocator = {
+        .alloc_cb = &_jscon_counting_alloc,
+        .realloc_cb = &_jscon_counting_realloc,
+        .free_cb = &_jscon_counting_free,
+        .context = stats,
+    };
+
+    return allocator;
+}
+
+/* chunks start at 64KB, and double in size as more are needed */
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGN 16
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN-1) & ~(size_t)(ARENA_ALIGN-1))
+#define ARENA_HEADER ARENA_ROUND(sizeof(struct jscon_arena_chunk_s))
+
+/* arena taking over allocations at the current thread, if any */
+static __thread struct jscon_arena_s *_jscon_arena;
+
+/* arena chunks come from the allocator given to its parser, if any */
+static const jscon_allocator_t*
+_jscon_arena_allocator(struct jscon_arena_s *arena){
+    return (NULL != arena->allocator) ? arena->allocator : _jscon_allocator;
+}
+
+static struct jscon_arena_chunk_s*
+_jscon_arena_chunk_init(struct jscon_arena_s *arena, size_t size)
+{
+    const jscon_allocator_t *allocator = _jscon_arena_allocator(arena);
+
+    struct jscon_arena_chunk_s *new_chunk = (*allocator->alloc_cb)(allocator->context, ARENA_HEADER + size, JSCON_ALLOC_ARENA);
+    DEBUG_ASSERT(NULL != new_chunk, "Out of memory");
+    new_chunk->size = size;
+
+    return new_chunk;
+}
+
+static void
+_jscon_arena_chunk_destroy(struct jscon_arena_s *arena, struct jscon_arena_chunk_s *chunk)
+{
+    const jscon_allocator_t *allocator = _jscon_arena_allocator(arena);
+    (*allocator->free_cb)(allocator->context, chunk);
+}
+
+static void*
+_jscon_arena_alloc(struct jscon_arena_s *arena, size_t size)
+{
+    size = ARENA_ROUND(size);
+
+    struct jscon_arena_chunk_s *chunk = arena->chunk;
+    if (NULL == chunk || arena->offset + size > chunk->size){
+        size_t chunk_size = (NULL != chunk) ? 2 * chunk->size : ARENA_CHUNK_SIZE;
+        while (chunk_size < size){
+            chunk_size *= 2;
+        }
+
+        chunk = _jscon_arena_chunk_init(arena, chunk_size);
+        chunk->next = arena->chunk;
+
+        arena->chunk = chunk;
+        arena->offset = 0;
+    }
+
+    void *ptr = (char*)chunk + ARENA_HEADER + arena->offset;
+    arena->offset += size;
+
+    return ptr;
+}
+
+/* installs arena for the current thread, returns the previous one */
+struct jscon_arena_s*
+Jscon_arena_swap(struct jscon_arena_s *arena)
+{
+    struct jscon_arena_s *prev = _jscon_arena;
+    _jscon_arena = arena;
+
+    return prev;
+}
+
+/* releases every allocation at once. chunks are merged into a single
+    one of their combined size, so that the next parse of a similar
+    document needs no allocation at all */
+void
+Jscon_arena_reset(struct jscon_arena_s *arena)
+{
+    struct jscon_arena_chunk_s *chunk = arena->chunk;
+    if (NULL != chunk && NULL != chunk->next){
+        size_t total = 0;
+        while (NULL != chunk){
+            struct jscon_arena_chunk_s *next = chunk->next;
+            total += chunk->size;
+            _jscon_arena_chunk_destroy(arena, chunk);
+            chunk = next;
+        }
+
+        arena->chunk = _jscon_arena_chunk_init(arena, total);
+        arena->chunk->next = NULL;
+    }
+
+    arena->offset = 0;
+}
+
+void
+Jscon_arena_destroy(struct jscon_arena_s *arena)
+{
+    struct jscon_arena_chunk_s *chunk = arena->chunk;
+    while (NULL != chunk){
+        struct jscon_arena_chunk_s *next = chunk->next;
+        _jscon_arena_chunk_destroy(arena, chunk);
+        chunk = next;
+    }
+
+    arena->chunk = NULL;
+    arena->offset = 0;
+}
+
+void*
+Jscon_malloc(size_t size, enum jscon_alloc_category category)
+{
+    if (NULL != _jscon_arena){
+        return _jscon_arena_alloc(_jscon_arena, size);
+    }
+    return (*_jscon_allocator->alloc_cb)(_jscon_allocator->context, size, category);
+}
+
+void*
+Jscon_calloc(size_t num, size_t size, enum jscon_alloc_category category)
+{
+    if (0 != size && num > SIZE_MAX / size) return NULL; //overflow
+
+    void *ptr = Jscon_malloc(num * size, category);
+    if (NULL == ptr) return NULL;
+
+    return memset(ptr, 0, num * size);
+}
+
+void*
+Jscon_realloc(void *ptr, size_t size, enum jscon_alloc_category category)
+{
+    DEBUG_ASSERT(NULL == _jscon_arena, "Arena memory can't be reallocated");
+    return (*_jscon_allocator->realloc_cb)(_jscon_allocator->context, ptr, size, category);
+}
+
+char*
+Jscon_strndup(const char *str, size_t len, enum jscon_alloc_category category)
+{
+    char *new_str = Jscon_malloc(len + 1, category);
+    if (NULL == new_str) return NULL;
+
+    memcpy(new_str, str, len);
+    new_str[len] = '\0';
+
+    return new_str;
+}
+
+/* arena memory is only released at reset, so memory freed by a parse
+    callback while a jscon_parser_t is parsing isn't released until then */
+void
+Jscon_free(void *ptr)
+{
+    if (NULL == _jscon_arena){
+        (*_jscon_allocator->free_cb)(_jscon_allocator->context, ptr);
+    }
+}
+
@@ -25,6 +25,11 @@
 #include <stdarg.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include <libjscon.h>
 #include "jscon-common.h"
@@ -33,21 +38,190 @@
 #include "debug.h"
 
 
-/* reentrant hashtable linking function */
+/* FNV-1a */
+uint64_t
+Jscon_strhash(const char *str, size_t len)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i=0; i < len; ++i){
+        hash ^= (unsigned char)str[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/* create item with key and string copied to its inline_buf, either
+    may be NULL. the type is left for the caller to set */
+jscon_item_t*
+Jscon_item_init(const char *key, size_t key_len, const char *string, size_t string_len)
+{
+    size_t inline_size = 0;
+    if (NULL != key) inline_size += key_len+1;
+    if (NULL != string) inline_size += string_len+1;
+
+    jscon_item_t *new_item = Jscon_malloc(sizeof *new_item + inline_size, JSCON_ALLOC_NODE);
+    if (NULL == new_item) return NULL;
+
+    memset(new_item, 0, sizeof *new_item);
+
+    char *inline_buf = new_item->inline_buf;
+    if (NULL != key){
+        new_item->key = memcpy(inline_buf, key, key_len);
+        new_item->key[key_len] = '\0';
+        new_item->flags |= JSCON_ITEM_INLINE_KEY;
+        inline_buf += key_len+1;
+    }
+    if (NULL != string){
+        new_item->string = memcpy(inline_buf, string, string_len);
+        new_item->string[string_len] = '\0';
+        new_item->flags |= JSCON_ITEM_INLINE_STRING;
+    }
+
+    return new_item;
+}
+
+/* copy key of given len to item, replacing its current one */
+char*
+Jscon_item_set_key(jscon_item_t *item, const char *key, size_t len)
+{
+    char *new_key = Jscon_strndup(key, len, JSCON_ALLOC_KEY);
+    if (NULL == new_key) return NULL;
+
+    Jscon_item_free_key(item);
+    return item->key = new_key;
+}
+
+/* copy string of given len to item, replacing its current one. an
+    inline string is overwritten if the new one fits in its place */
+char*
+Jscon_item_set_string(jscon_item_t *item, const char *string, size_t len)
+{
+    if ((item->flags & JSCON_ITEM_INLINE_STRING) && len <= strlen(item->string)){
+        memmove(item->string, string, len);
+        item->string[len] = '\0';
+        return item->string;
+    }
+
+    //allocate first, as string may be the current one
+    char *new_string = Jscon_strndup(string, len, JSCON_ALLOC_STRING);
+    if (NULL == new_string) return NULL;
+
+    Jscon_item_free_string(item);
+    return item->string = new_string;
+}
+
+void
+Jscon_item_free_key(jscon_item_t *item)
+{
+    if (!(item->flags & JSCON_ITEM_INLINE_KEY)){
+        Jscon_free(item->key);
+    }
+    item->key = NULL;
+    item->flags &= ~JSCON_ITEM_INLINE_KEY;
+}
+
+/* item must be of string type, or have its string unset */
+void
+Jscon_item_free_string(jscon_item_t *item)
+{
+    if (!(item->flags & JSCON_ITEM_INLINE_STRING)){
+        Jscon_free(item->string);
+    }
+    item->string = NULL;
+    item->flags &= ~JSCON_ITEM_INLINE_STRING;
+}
+
+/* key index size for capacity, kept between 1/3 and 2/3 full */
+static size_t
+_jscon_composite_num_slot(size_t capacity)
+{
+    size_t num_slot = 2;
+    while (num_slot < capacity + capacity/2){
+        num_slot <<= 1;
+    }
+
+    return num_slot;
+}
+
+/* create composite with room for capacity branches */
+jscon_composite_t*
+Jscon_composite_init(size_t capacity)
+{
+    const size_t num_slot = _jscon_composite_num_slot(capacity);
+
+    jscon_composite_t *new_comp = Jscon_calloc(1, sizeof *new_comp
+                                                  + capacity * sizeof *new_comp->branch
+                                                  + num_slot * sizeof(uint32_t), JSCON_ALLOC_NODE);
+    if (NULL == new_comp) return NULL;
+
+    new_comp->capacity = capacity;
+    new_comp->num_slot = num_slot;
+
+    return new_comp;
+}
+
+/* grow item composite to fit capacity branches, its key index is
+    remade as it moves along with the branches, unless stale */
+bool
+Jscon_composite_reserve(jscon_item_t *item, size_t capacity)
+{
+    DEBUG_ASSERT(IS_COMPOSITE(item), "Item is not an Object or Array");
+
+    jscon_composite_t *comp = item->comp;
+    if (capacity <= comp->capacity) return true;
+
+    const size_t num_slot = _jscon_composite_num_slot(capacity);
+
+    comp = Jscon_realloc(comp, sizeof *comp
+                               + capacity * sizeof *comp->branch
+                               + num_slot * sizeof(uint32_t), JSCON_ALLOC_NODE);
+    if (NULL == comp) return false;
+
+    comp->capacity = capacity;
+    comp->num_slot = num_slot;
+    item->comp = comp;
+
+    if (!comp->stale){
+        Jscon_composite_build(item);
+    }
+
+    return true;
+}
+
+/* reentrant composite linking function */
 void
-Jscon_composite_link_r(jscon_item_t *item, jscon_composite_t **p_last_accessed_comp)
+Jscon_composite_link_r(jscon_item_t *item, jscon_item_t **p_last_accessed)
 {
     DEBUG_ASSERT(IS_COMPOSITE(item), "Item is not an Object or Array");
 
-    jscon_composite_t *last_accessed_comp = *p_last_accessed_comp;
-    if (NULL != last_accessed_comp){
-        last_accessed_comp->next = item->comp; //item is not root
-        item->comp->prev = last_accessed_comp;
+    jscon_item_t *last_accessed = *p_last_accessed;
+    if (NULL != last_accessed){
+        last_accessed->comp->next = item; //item is not root
+        item->comp->prev = last_accessed;
     }
 
-    last_accessed_comp = item->comp;
+    *p_last_accessed = item;
+}
+
+/* returns the key index slot where key is, or the empty slot where
+    it would be inserted */
+static uint32_t*
+_jscon_composite_find(const jscon_composite_t *comp, const char *key)
+{
+    uint32_t *slot = COMPOSITE_SLOT(comp);
+    const size_t mask = comp->num_slot-1;
+
+    size_t index = Jscon_strhash(key, strlen(key)) & mask;
+    while (0 != slot[index]){
+        const char *branch_key = comp->branch[slot[index]-1]->key;
+        if (branch_key == key || STREQ(branch_key, key)){
+            break;
+        }
+        index = (index+1) & mask;
+    }
 
-    *p_last_accessed_comp = last_accessed_comp;
+    return &slot[index];
 }
 
 void
@@ -55,127 +229,629 @@ Jscon_composite_build(jscon_item_t *item)
 {
     DEBUG_ASSERT(IS_COMPOSITE(item), "Item is not an Object or Array");
 
-    hashtable_build(item->comp->hashtable, 2 + (1.3 * item->comp->num_branch)); //30% size increase to account for future expansions, and a default bucket size of 2
+    jscon_composite_t *comp = item->comp;
+    memset(COMPOSITE_SLOT(comp), 0, comp->num_slot * sizeof(uint32_t));
 
-    item->comp->p_item = item;
+    for (size_t i=0; i < comp->num_branch; ++i){
+        *_jscon_composite_find(comp, comp->branch[i]->key) = i+1;
+    }
+    comp->stale = false;
+}
+
+/* packed elements are looked up by their key position, which must be
+    a plain decimal, as array keys are */
+static jscon_item_t*
+_jscon_composite_get_packed(const char *key, const jscon_item_t *item)
+{
+    if (!isdigit(*key) || ('0' == *key && '\0' != key[1])) return NULL;
 
-    for (size_t i=0; i < item->comp->num_branch; ++i){
-        Jscon_composite_set(item->comp->branch[i]->key, item->comp->branch[i]);
+    size_t index = 0;
+    for ( ; isdigit(*key); ++key){
+        if (index > (SIZE_MAX - 9) / 10) return NULL;
+        index = 10 * index + (*key - '0');
     }
+    if ('\0' != *key) return NULL;
+
+    return Jscon_array_element(item, index);
 }
 
 jscon_item_t*
-Jscon_composite_get(const char *key, jscon_item_t *item)
+Jscon_composite_get(const char *key, const jscon_item_t *item)
 {
     if (!IS_COMPOSITE(item)) return NULL;
 
+    if (IS_PACKED(item)){
+        return _jscon_composite_get_packed(key, item);
+    }
+
     jscon_composite_t *comp = item->comp;
-    return hashtable_get(comp->hashtable, key);
+    if (comp->stale){
+        for (size_t i = comp->num_branch; i > 0; --i){
+            if (STREQ(key, comp->branch[i-1]->key)){
+                return comp->branch[i-1];
+            }
+        }
+        return NULL;
+    }
+
+    uint32_t *slot = _jscon_composite_find(comp, key);
+
+    return (0 != *slot) ? comp->branch[*slot-1] : NULL;
 }
 
+/* index item by key at its parent, a branch already indexed with the
+    same key is replaced. item must be at its parent branches, the
+    search starts from the last one */
 jscon_item_t*
 Jscon_composite_set(const char *key, jscon_item_t *item)
 {
-    DEBUG_ASSERT(!IS_ROOT(item), "Can't add to parent hashtable if Item is root");
+    DEBUG_ASSERT(!IS_ROOT(item), "Can't index Item at parent if Item is root");
 
     jscon_composite_t *comp = item->parent->comp;
-    return hashtable_set(comp->hashtable, key, item);
-}
+    if (comp->stale) return item; //indexed once remade
 
-/* remake hashtable on functions that deal with increasing branches */
-void
-Jscon_composite_remake(jscon_item_t *item)
-{
-    hashtable_destroy(item->comp->hashtable);
+    size_t index = comp->num_branch;
+    while (index > 0 && comp->branch[index-1] != item){
+        --index;
+    }
+    DEBUG_ASSERT(0 != index, "Item is not referenced by parent");
 
-    item->comp->hashtable = hashtable_init();
-    DEBUG_ASSERT(NULL != item->comp->hashtable, "Out of memory");
+    *_jscon_composite_find(comp, key) = index;
+
+    return item;
+}
 
+/* remake key index on functions that reorder branches */
+void
+Jscon_composite_remake(jscon_item_t *item){
     Jscon_composite_build(item);
 }
 
 jscon_composite_t*
 Jscon_decode_composite(char **p_buffer, size_t n_branch){
-    jscon_composite_t *new_comp = calloc(1, sizeof *new_comp);
+    jscon_composite_t *new_comp = Jscon_composite_init(1+n_branch);
     DEBUG_ASSERT(NULL != new_comp, "Out of memory");
 
-    new_comp->hashtable = hashtable_init(); 
-    DEBUG_ASSERT(NULL != new_comp->hashtable, "Out of memory");
-
-    new_comp->branch = malloc((1+n_branch) * sizeof(jscon_item_t*));
-    DEBUG_ASSERT(NULL != new_comp->branch, "Out of memory");
-
     ++*p_buffer; //skips composite's '{' or '[' delim
 
     return new_comp;
 }
 
+/* STRUCTURAL CHARACTERS BLOCK
+ * bitmasks of the structural characters found in a 64 bytes block of
+ * text, where bit N is set if the char at position N of the block
+ * is a match. skipping string and composites with it takes one bit
+ * scan per structural char, instead of one branch per byte */
+struct jscon_block_s {
+    uint64_t quote; //'"'
+    uint64_t escape; //'\\'
+    uint64_t open; //'{' or '['
+    uint64_t close; //'}' or ']'
+    uint64_t end; //'\0'
+};
+
+#if defined(__SSE2__)
+
+/* compare each of the 64 chars against c, and return the matches bitmask */
+static inline uint64_t
+_jscon_block_cmpeq(const __m128i chunk[4], char c)
+{
+    __m128i match = _mm_set1_epi8(c);
+
+    uint64_t mask = 0;
+    for (int i=0; i < 4; ++i){
+        mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk[i], match)) << (16*i);
+    }
+    return mask;
+}
+
+/* base must be 64 bytes aligned, so that the loads never cross a page
+    boundary, even though they may read past the nul terminator. chars
+    before pos are loaded as well, they're ignored by the caller */
+__attribute__((no_sanitize_address))
+static inline void
+_jscon_block_load(const char *base, size_t pos, struct jscon_block_s *block)
+{
+    (void)pos;
+
+    __m128i chunk[4];
+    for (int i=0; i < 4; ++i){
+        chunk[i] = _mm_load_si128((const __m128i*)(base + 16*i));
+    }
+
+    block->quote = _jscon_block_cmpeq(chunk, '\"');
+    block->escape = _jscon_block_cmpeq(chunk, '\\');
+    block->open = _jscon_block_cmpeq(chunk, '{') | _jscon_block_cmpeq(chunk, '[');
+    block->close = _jscon_block_cmpeq(chunk, '}') | _jscon_block_cmpeq(chunk, ']');
+    block->end = _jscon_block_cmpeq(chunk, '\0');
+}
+
+#else /* portable fallback */
+
+/* plain C can't read outside of the text, so only the chars from pos
+    up to the nul char are loaded, the others are left unmatched */
+static inline void
+_jscon_block_load(const char *base, size_t pos, struct jscon_block_s *block)
+{
+    *block = (struct jscon_block_s){0};
+
+    for (size_t i=pos; i < 64; ++i){
+        uint64_t bit = (uint64_t)1 << i;
+        switch (base[i]){
+        case '\"': block->quote |= bit; break;
+        case '\\': block->escape |= bit; break;
+        case '{': case '[': block->open |= bit; break;
+        case '}': case ']': block->close |= bit; break;
+        case '\0': block->end |= bit; return;
+        default: break;
+        }
+    }
+}
+
+#endif
+
+/* skips a string or a composite (including all of its nests) that
+    starts at buffer, and returns the position right after it. strings
+    are tracked so that any delim character inside them won't trigger
+    depth action */
+static char*
+_jscon_skip_structure(char *buffer, bool in_string)
+{
+    size_t depth = 0;
+
+    char *base = (char*)((uintptr_t)buffer & ~(uintptr_t)63);
+    size_t pos = buffer - base;
+
+    struct jscon_block_s block;
+    _jscon_block_load(base, pos, &block);
+    while (true){
+        if (pos >= 64){ //move on to next block
+            base += 64;
+            pos -= 64;
+            _jscon_block_load(base, pos, &block);
+        }
+
+        uint64_t mask = in_string
+                        ? (block.quote | block.escape | block.end)
+                        : (block.quote | block.open | block.close | block.end);
+        mask &= ~(uint64_t)0 << pos; //ignore chars already visited
+
+        if (0 == mask){
+            pos = 64;
+            continue;
+        }
+
+        pos = __builtin_ctzll(mask);
+        switch (base[pos]){
+        case '\\':
+            //skips escaped character, unless it is the nul char
+            pos += ('\0' == base[pos+1]) ? 1 : 2;
+            break;
+        case '\"':
+            if (in_string && 0 == depth){ //single string skip is done
+                return base + pos + 1;
+            }
+            in_string = !in_string;
+            ++pos;
+            break;
+        case '{':
+        case '[':
+            ++depth;
+            ++pos;
+            break;
+        case '}':
+        case ']':
+            ++pos;
+            if (0 == --depth) return base + pos;
+            break;
+        default: /* '\0' */
+            DEBUG_ERR("Bad formatting");
+            return base + pos;
+        }
+    }
+}
+
+/* buffer must be at the opening double quotes of a string */
 char*
-Jscon_decode_string(char **p_buffer)
+Jscon_skip_string(char *buffer)
 {
-    char *start = *p_buffer;
-    DEBUG_ASSERT('\"' == *start, "Not a string"); //makes sure a string is given
+    DEBUG_ASSERT('\"' == *buffer, "Not a string");
+    return _jscon_skip_structure(buffer + 1, true);
+}
 
-    char *end = ++start;
-    while (('\0' != *end) && ('\"' != *end)){
-        if ('\\' == *end++){ //skips escaped characters
-            ++end;
+/* buffer must be at the opening delim of an object or array */
+char*
+Jscon_skip_composite(char *buffer)
+{
+    DEBUG_ASSERT('{' == *buffer || '[' == *buffer, "Not an Object or Array");
+    return _jscon_skip_structure(buffer, false);
+}
+
+/* skips any json value, returns the position right after it */
+char*
+Jscon_skip_value(char *buffer)
+{
+    switch (*buffer){
+    case '{':/*OBJECT DETECTED*/
+    case '[':/*ARRAY DETECTED*/
+        return Jscon_skip_composite(buffer);
+    case '\"':/*STRING DETECTED*/
+        return Jscon_skip_string(buffer);
+    default:
+        //consume characters while not end of primitive
+        while ('\0' != *buffer && ',' != *buffer
+                && '}' != *buffer && ']' != *buffer
+                && !IS_BLANK_CHAR(*buffer))
+        {
+            ++buffer;
         }
+        return buffer;
     }
-    DEBUG_ASSERT('\"' == *end, "Not a string"); //makes sure end of string exists
+}
 
-    *p_buffer = end + 1; //skips double quotes buffer position
+/* decode string at buffer, instead of an allocated copy the string
+    position at buffer is returned, along with its length */
+char*
+Jscon_decode_string_inplace(char **p_buffer, size_t *p_len)
+{
+    char *start = *p_buffer;
+    char *end = Jscon_skip_string(start); //position after closing quotes
 
-    char *set_str = strndup(start, end-start);
-    DEBUG_ASSERT(NULL != set_str, "Out of memory");
+    *p_buffer = end; //skips double quotes buffer position
+    *p_len = end - start - 2;
 
-    return set_str;
+    return start + 1;
 }
 
-double
-Jscon_decode_double(char **p_buffer)
+/* powers of ten that are exactly representable as a double */
+static const double _jscon_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* decodes a number in a single pass, by accumulating its significant
+    digits and exponent. whenever the digits and the power of ten are
+    both exact as doubles, the conversion is a single multiplication or
+    division, only the remaining cases are left for strtod().
+    returns true if the number has no fraction or exponent part and fits
+    a long long, in which case p_i_number is set as well */
+bool
+Jscon_decode_number(char **p_buffer, long long *p_i_number, double *p_d_number)
 {
     char *start = *p_buffer;
     char *end = start;
 
     /* 1st STEP: check for a minus sign and skip it */
-    if ('-' == *end){
+    bool negative = ('-' == *end);
+    if (negative){
         ++end; //skips minus sign
     }
 
-    /* 2nd STEP: skips until a non digit char found */
-    DEBUG_ASSERT(isdigit(*end), "Not a number"); //interrupt if char isn't digit
-    while (isdigit(*++end))
-        continue; //skips while char is digit
+    /* 2nd STEP: accumulate integer digits */
+    DEBUG_ASSERT(IS_DIGIT(*end), "Not a number"); //interrupt if char isn't digit
+    uint64_t mantissa = 0;
+    int num_digits = 0; //significant digits accumulated
+    int exp10 = 0;
+    bool truncated = false; //digits didn't fit mantissa
+    for ( ; IS_DIGIT(*end); ++end){
+        if (num_digits < 19){
+            mantissa = mantissa * 10 + (*end - '0');
+            num_digits += (0 != mantissa);
+        } else {
+            ++exp10;
+            truncated = true;
+        }
+    }
 
-    /* 3rd STEP: if non-digit char is not a comma then it must be
-        an integer*/
+    /* 3rd STEP: accumulate fraction digits */
+    bool is_integer = true;
     if ('.' == *end){
-        while (isdigit(*++end))
-            continue;
+        is_integer = false;
+        ++end; //skips '.'
+        DEBUG_ASSERT(IS_DIGIT(*end), "Not a number");
+        for ( ; IS_DIGIT(*end); ++end){
+            if (num_digits < 19){
+                mantissa = mantissa * 10 + (*end - '0');
+                num_digits += (0 != mantissa);
+                --exp10;
+            } else {
+                truncated = true;
+            }
+        }
     }
 
-    /* 4th STEP: if exponent found skips its tokens */
+    /* 4th STEP: if exponent found decode it */
     if (('e' == *end) || ('E' == *end)){
+        is_integer = false;
         ++end;
-        if (('+' == *end) || ('-' == *end)){ 
+
+        bool exp_negative = ('-' == *end);
+        if (('+' == *end) || ('-' == *end)){
             ++end;
         }
-        DEBUG_ASSERT(isdigit(*end), "Not a number");
-        while (isdigit(*++end))
-            continue;
+        DEBUG_ASSERT(IS_DIGIT(*end), "Not a number");
+
+        int exp = 0;
+        for ( ; IS_DIGIT(*end); ++end){
+            if (exp < 100000){
+                exp = exp * 10 + (*end - '0');
+            }
+        }
+        exp10 += exp_negative ? -exp : exp;
     }
 
-    /* 5th STEP: convert string to double and return its value */
-    char numstr[MAX_DIGITS];
-    strscpy(numstr, start, ((size_t)(end-start+1) < sizeof(numstr)) ? (size_t)(end-start+1) : sizeof(numstr));
+    *p_buffer = end; //skips entire length of number
 
-    double set_double;
-    sscanf(numstr,"%lf",&set_double);
+    /* 5th STEP: convert digits to its value */
+    if (is_integer && !truncated
+        && mantissa <= (uint64_t)LLONG_MAX + negative)
+    {
+        *p_i_number = negative ? (long long)(0 - mantissa) : (long long)mantissa;
+        *p_d_number = (double)*p_i_number;
+        return true;
+    }
 
-    *p_buffer = end; //skips entire length of number
+    double d_number;
+    if (!truncated && mantissa <= ((uint64_t)1 << 53) && exp10 >= -22 && exp10 <= 22){
+        d_number = (double)mantissa;
+        if (exp10 < 0){
+            d_number /= _jscon_pow10[-exp10];
+        } else {
+            d_number *= _jscon_pow10[exp10];
+        }
+        if (negative){
+            d_number = -d_number;
+        }
+    } else {
+        d_number = strtod(start, NULL);
+    }
+
+    *p_d_number = d_number;
+    return false;
+}
+
+double
+Jscon_decode_double(char **p_buffer)
+{
+    long long i_number;
+    double d_number;
+    Jscon_decode_number(p_buffer, &i_number, &d_number);
+
+    return d_number;
+}
+
+/* NUMBER ARRAY BLOCK
+ * bitmasks of the chars in a 64 bytes block of text that may belong to
+ * an array of numbers, where bit N is set if the char at position N of
+ * the block is a match. finding out if an array holds only numbers, and
+ * how many, takes a few bit operations per block instead of a full
+ * parse of its elements */
+struct jscon_number_block_s {
+    uint64_t number; //digits, '-', '+', '.', 'e' or 'E'
+    uint64_t comma; //','
+    uint64_t blank; //' ', '\t', '\n' or '\r'
+};
+
+#if defined(__SSE2__)
+
+/* same as _jscon_block_load(), base must be 64 bytes aligned */
+__attribute__((no_sanitize_address))
+static inline void
+_jscon_number_block_load(const char *base, size_t pos, struct jscon_number_block_s *block)
+{
+    (void)pos;
+
+    __m128i chunk[4];
+    for (int i=0; i < 4; ++i){
+        chunk[i] = _mm_load_si128((const __m128i*)(base + 16*i));
+    }
+
+    uint64_t digit = 0;
+    for (int i=0; i < 4; ++i){
+        __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(chunk[i], _mm_set1_epi8('0'-1)),
+                                         _mm_cmplt_epi8(chunk[i], _mm_set1_epi8('9'+1)));
+        digit |= (uint64_t)(uint16_t)_mm_movemask_epi8(is_digit) << (16*i);
+    }
+
+    block->number = digit
+                    | _jscon_block_cmpeq(chunk, '-') | _jscon_block_cmpeq(chunk, '+')
+                    | _jscon_block_cmpeq(chunk, '.')
+                    | _jscon_block_cmpeq(chunk, 'e') | _jscon_block_cmpeq(chunk, 'E');
+    block->comma = _jscon_block_cmpeq(chunk, ',');
+    block->blank = _jscon_block_cmpeq(chunk, ' ') | _jscon_block_cmpeq(chunk, '\t')
+                   | _jscon_block_cmpeq(chunk, '\n') | _jscon_block_cmpeq(chunk, '\r');
+}
+
+#else /* portable fallback */
+
+/* same as _jscon_block_load(), the nul char and whatever follows it
+    are left unmatched */
+static inline void
+_jscon_number_block_load(const char *base, size_t pos, struct jscon_number_block_s *block)
+{
+    *block = (struct jscon_number_block_s){0};
+
+    for (size_t i=pos; i < 64 && '\0' != base[i]; ++i){
+        uint64_t bit = (uint64_t)1 << i;
+        switch (base[i]){
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+        case '-': case '+': case '.': case 'e': case 'E':
+            block->number |= bit;
+            break;
+        case ',': block->comma |= bit; break;
+        case ' ': case '\t': case '\n': case '\r': block->blank |= bit; break;
+        default: break;
+        }
+    }
+}
+
+#endif
+
+/* buffer must be at the opening delim of an array. if the array is made
+    of numbers only, the amount of them is returned and p_end is set to
+    its closing delim, otherwise 0 is returned */
+size_t
+Jscon_count_number_array(const char *buffer, const char **p_end)
+{
+    DEBUG_ASSERT('[' == *buffer, "Not an Array");
+    ++buffer; //skips '['
+
+    const char *base = (const char*)((uintptr_t)buffer & ~(uintptr_t)63);
+    size_t pos = buffer - base;
+
+    size_t num_comma = 0;
+    bool has_number = false;
+
+    struct jscon_number_block_s block;
+    while (true){
+        _jscon_number_block_load(base, pos, &block);
+
+        uint64_t mask = ~(uint64_t)0 << pos; //ignore chars already visited
+        uint64_t other = ~(block.number | block.comma | block.blank) & mask;
+        if (0 != other){ //only count up to the first char that isn't expected
+            mask &= (other & (0 - other)) - 1;
+        }
+
+        has_number |= (0 != (block.number & mask));
+        num_comma += __builtin_popcountll(block.comma & mask);
+
+        if (0 != other){
+            const char *end = base + __builtin_ctzll(other);
+            if (']' != *end || !has_number) return 0;
+
+            *p_end = end;
+            return num_comma + 1;
+        }
+
+        base += 64;
+        pos = 0;
+    }
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+/* amount of leading digits in the 8 chars of chunk. a char is a digit if
+    both its high nibble and the high nibble of it plus 6 equal 3 */
+static inline int
+_jscon_swar_num_digits(uint64_t chunk)
+{
+    uint64_t non_digit = ((chunk & 0xF0F0F0F0F0F0F0F0)
+                          | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+                         ^ 0x3333333333333333;
+
+    return (0 == non_digit) ? 8 : (__builtin_ctzll(non_digit) >> 3);
+}
+
+/* value of the 8 digits in chunk, combined in pairs, then in quads */
+static inline uint64_t
+_jscon_swar_parse8(uint64_t chunk)
+{
+    chunk = ((chunk & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+    chunk = ((chunk & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+    return ((chunk & 0x0000FFFF0000FFFF) * 42949672960001) >> 32;
+}
+
+#endif
+
+/* accumulates the digits starting at buffer into p_mantissa, 8 at a
+    time while they are known to lie before end. returns the position
+    right after the last digit */
+static inline char*
+_jscon_accumulate_digits(char *buffer, const char *end, uint64_t *p_mantissa)
+{
+    uint64_t mantissa = *p_mantissa;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (end - buffer >= 8){
+        uint64_t chunk;
+        memcpy(&chunk, buffer, sizeof chunk);
+        if (8 != _jscon_swar_num_digits(chunk)) break;
 
-    return set_double;
+        mantissa = mantissa * 100000000 + _jscon_swar_parse8(chunk);
+        buffer += 8;
+    }
+#else
+    (void)end;
+#endif
+
+    for ( ; IS_DIGIT(*buffer); ++buffer){
+        mantissa = mantissa * 10 + (*buffer - '0');
+    }
+
+    *p_mantissa = mantissa;
+    return buffer;
+}
+
+/* decodes the plain numbers (no exponent, up to 19 digits) most
+    numerical arrays are made of, giving the very same result as
+    Jscon_decode_double(). returns false for any other number, so that
+    it may be decoded by the former */
+static bool
+_jscon_decode_plain_number(char **p_buffer, const char *end, double *p_d_number)
+{
+    char *start = *p_buffer;
+    bool negative = ('-' == *start);
+    if (negative){
+        ++start; //skips minus sign
+    }
+
+    uint64_t mantissa = 0;
+    char *buffer = _jscon_accumulate_digits(start, end, &mantissa);
+    size_t num_digits = buffer - start;
+    if (0 == num_digits) return false;
+
+    size_t num_fraction = 0;
+    if ('.' == *buffer){
+        start = ++buffer; //skips '.'
+        buffer = _jscon_accumulate_digits(start, end, &mantissa);
+        num_fraction = buffer - start;
+        if (0 == num_fraction) return false;
+    }
+
+    if ('e' == *buffer || 'E' == *buffer) return false;
+    if (num_digits + num_fraction > 19) return false;
+
+    if (0 == num_fraction){
+        if (mantissa > (uint64_t)LLONG_MAX + negative) return false;
+
+        long long i_number = negative ? (long long)(0 - mantissa) : (long long)mantissa;
+        *p_d_number = (double)i_number;
+    }
+    else {
+        if (mantissa > ((uint64_t)1 << 53) || num_fraction > 22) return false;
+
+        double d_number = (double)mantissa / _jscon_pow10[num_fraction];
+        *p_d_number = negative ? -d_number : d_number;
+    }
+
+    *p_buffer = buffer;
+    return true;
+}
+
+/* decodes the num_element numbers of the array at buffer, as counted by
+    Jscon_count_number_array(). returns the position right after the
+    array, or NULL if they aren't laid out as comma separated numbers */
+char*
+Jscon_decode_number_array(char *buffer, const char *end, size_t num_element, double d_number[])
+{
+    DEBUG_ASSERT('[' == *buffer, "Not an Array");
+    ++buffer; //skips '['
+
+    for (size_t i=0; i < num_element; ++i){
+        CONSUME_BLANK_CHARS(buffer);
+        if (!IS_DIGIT(*buffer) && '-' != *buffer) return NULL;
+
+        if (!_jscon_decode_plain_number(&buffer, end, &d_number[i])){
+            d_number[i] = Jscon_decode_double(&buffer);
+        }
+
+        CONSUME_BLANK_CHARS(buffer);
+        if (*buffer != ((num_element-1 == i) ? ']' : ',')) return NULL;
+        ++buffer; //skips ',' or ']'
+    }
+
+    return buffer;
 }
 
 bool
@@ -193,3 +869,143 @@ void
 Jscon_decode_null(char **p_buffer){
     *p_buffer += 4; //skips length of "null"
 }
+
+/* converts the string specifier (ex: "lld") to its enum counterpart,
+    returns JSCON_SPECIFIER_NONE if unknown */
+enum jscon_specifier
+Jscon_specifier_decode(const char *specifier, size_t len)
+{
+    switch (len){
+    case 1:
+        switch (*specifier){
+        case 'c': return JSCON_SPECIFIER_CHAR;
+        case 's': return JSCON_SPECIFIER_STRING;
+        case 'd': return JSCON_SPECIFIER_INT;
+        case 'f': return JSCON_SPECIFIER_FLOAT;
+        case 'b': return JSCON_SPECIFIER_BOOLEAN;
+        default: return JSCON_SPECIFIER_NONE;
+        }
+    case 2:
+        if (STRNEQ(specifier, "ld", 2)) return JSCON_SPECIFIER_LONG;
+        if (STRNEQ(specifier, "lf", 2)) return JSCON_SPECIFIER_DOUBLE;
+        if (STRNEQ(specifier, "ji", 2)) return JSCON_SPECIFIER_ITEM;
+        return JSCON_SPECIFIER_NONE;
+    case 3:
+        if (STRNEQ(specifier, "lld", 3)) return JSCON_SPECIFIER_LLONG;
+        return JSCON_SPECIFIER_NONE;
+    default:
+        return JSCON_SPECIFIER_NONE;
+    }
+}
+
+/* converts integer to string and store it in p_str (must fit at least
+    MAX_DIGITS+4 chars), returns the string length */
+size_t
+Jscon_encode_integer(long long i_number, char *p_str)
+{
+    char tmp_str[24];
+    size_t len = 0;
+
+    /* work with the negative magnitude, so that LLONG_MIN can't overflow */
+    long long n = (i_number < 0) ? i_number : -i_number;
+    do {
+        tmp_str[len++] = '0' - (char)(n % 10);
+        n /= 10;
+    } while (0 != n);
+
+    size_t i = 0;
+    if (i_number < 0){
+        p_str[i++] = '-';
+    }
+    while (len){
+        p_str[i++] = tmp_str[--len];
+    }
+    p_str[i] = '\0';
+
+    return i;
+}
+
+/* converts double to string and store it in p_str */
+//@todo make this more readable
+void
+Jscon_encode_double(const double d_number, char *p_str, const int digits)
+{
+    if (DOUBLE_IS_INTEGER(d_number)){
+        sprintf(p_str,"%.lf",d_number); //convert integer to string
+        return;
+    }
+
+    int decimal=0, sign=0;
+    char *tmp_str = fcvt(d_number,digits-1,&decimal,&sign);
+
+    int i=0;
+    if (0 != sign){ //negative sign detected
+        p_str[i++] = '-';
+    }
+
+    if (IN_RANGE(decimal,-7,17)){
+        //print scientific notation
+        sprintf(p_str+i,"%c.%.7se%d",*tmp_str,tmp_str+1,decimal-1);
+        return;
+    }
+
+    char format[100];
+    if (0 < decimal){
+        sprintf(format,"%%.%ds.%%.7s",decimal);
+        sprintf(i + p_str, format, tmp_str, tmp_str + decimal);
+    } else if (0 > decimal) {
+        sprintf(format, "0.%0*d%%.7s", abs(decimal), 0);
+        sprintf(i + p_str, format, tmp_str);
+    } else {
+        sprintf(format,"0.%%.7s");
+        sprintf(i + p_str, format, tmp_str);
+    }
+}
+
+/* converts double to the shortest string that reads back as the same
+    double, and store it in p_str (must fit at least MAX_DOUBLE_LEN
+    chars), returns the string length. unlike Jscon_encode_double(),
+    no digit is lost and no static buffer is used */
+size_t
+Jscon_encode_double_exact(const double d_number, char *p_str)
+{
+    int len = 0;
+    for (int digits = MAX_DIGITS-2; digits <= MAX_DIGITS; ++digits){
+        len = snprintf(p_str, MAX_DOUBLE_LEN, "%.*g", digits, d_number);
+        if (strtod(p_str, NULL) == d_number) break;
+    }
+
+    return (size_t)len;
+}
+
+/* writes len chars of a C string as a quoted json string, '"', '\\'
+    and control characters are escaped */
+void
+Jscon_outbuf_string(struct jscon_outbuf_s *out, const char *string, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    Jscon_outbuf_putc(out, '\"');
+    for (size_t i=0; i < len; ++i){
+        const unsigned char c = (unsigned char)string[i];
+        switch (c){
+        case '\"':  Jscon_outbuf_write(out, "\\\"", 2); continue;
+        case '\\':  Jscon_outbuf_write(out, "\\\\", 2); continue;
+        case '\b':  Jscon_outbuf_write(out, "\\b", 2); continue;
+        case '\f':  Jscon_outbuf_write(out, "\\f", 2); continue;
+        case '\n':  Jscon_outbuf_write(out, "\\n", 2); continue;
+        case '\r':  Jscon_outbuf_write(out, "\\r", 2); continue;
+        case '\t':  Jscon_outbuf_write(out, "\\t", 2); continue;
+        default:
+            break;
+        }
+
+        if (c < 0x20){
+            char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+            Jscon_outbuf_write(out, escaped, sizeof escaped);
+        } else {
+            Jscon_outbuf_putc(out, (char)c);
+        }
+    }
+    Jscon_outbuf_putc(out, '\"');
+}
@@ -24,6 +24,8 @@
 #define JSCON_COMMON_H_
 
 #include <limits.h>
+#include <string.h>
+#include <stdint.h>
 
 //#include <libjscon.h> (implicit)
 #include "hashtable.h"
@@ -31,17 +33,21 @@
 #define JSCON_VERSION "0.0"
 
 #define MAX_DIGITS 17
+#define MAX_DOUBLE_LEN 32 //enough for "%.17g" of any double
+#define MAX_DEPTH 1024 //composite nesting limit for jscon_sax_parse()
 
 #define STRLT(s,t) (strcmp(s,t) < 0)
 #define STREQ(s,t) (0 == strcmp(s,t))
 #define STRNEQ(s,t,n) (0 == strncmp(s,t,n))
 
+#define IS_DIGIT(c) ((unsigned)((c) - '0') < 10)
+
 #define IN_RANGE(n,lo,hi) (((n) > (lo)) && ((n) < (hi)))
 
 #define DOUBLE_IS_INTEGER(d) \
     ((d) <= LLONG_MIN || (d) >= LLONG_MAX || (d) == (long long)(d))
 
-#define IS_BLANK_CHAR(c) (isspace(c) || iscntrl(c))
+#define IS_BLANK_CHAR(c) ('\0' != (c) && (isspace(c) || iscntrl(c)))
 #define CONSUME_BLANK_CHARS(str) for( ; IS_BLANK_CHAR(*str) ; ++str)
 
 #define IS_COMPOSITE(item) ((item) && jscon_typecmp(item, JSCON_OBJECT|JSCON_ARRAY))
@@ -56,43 +62,82 @@
 /* JSCON COMPOSITE STRUCTURE
  * if jscon_item type is of composite type (object or array) it will
  * include a jscon_composite_t struct with the following attributes:
- *      branch: for sorting through object's properties/array elements
  *      num_branch: amount of enumerable properties/elements contained
  *      last_accessed_branch: simulate stack trace by storing the last
  *              accessed branch address. this is used for movement 
  *              functions that require state to be preserved between 
  *              calls, while also adhering to tree traversal rules. 
  *              (check public.c jscon_iter_next() for example)
- *      hashtable: easy reference to its key-value pairs
- *      p_item: reference to the item the composite is part of
- *      next: points to next composite
- *      prev: points to previous composite */
+ *      capacity: amount of branches that fit before it must be grown
+ *      num_slot: size of the key index, always a power of two
+ *      next: points to next composite item, in preorder
+ *      prev: points to previous composite item, in preorder
+ *      keyindex: items of the whole tree by key, only set at root
+ *              once jscon_find_all() is called
+ *      index: field indexes of an array, by jscon_index_by()
+ *      hash: cached content hash, 0 if not computed (check
+ *              jscon-diff.c)
+ *      stale: key index doesn't match branches, until remade. keys
+ *              are looked up linearly meanwhile
+ *      packed: JSCON_INTEGER or JSCON_DOUBLE if the array elements
+ *              are packed numbers rather than items, 0 otherwise.
+ *              num_packed of them are stored in place of branch, and
+ *              num_branch is 0 (check jscon-packed.c)
+ *      element: items of the packed elements, each made the first time
+ *              it's read as an item (NULL until then), while the packed
+ *              numbers are kept
+ *              (check Jscon_array_element())
+ *      branch: for sorting through object's properties/array elements,
+ *              followed by the key index (check COMPOSITE_SLOT())
+ * a composite takes a single allocation, the key index is an open
+ * addressing table of branch positions (+1, 0 if empty) */
 typedef struct jscon_composite_s {
-    struct jscon_item_s **branch;
     size_t num_branch;
     size_t last_accessed_branch;
+    size_t capacity;
+    size_t num_slot;
+
+    struct jscon_item_s *next;
+    struct jscon_item_s *prev;
+
+    struct jscon_keyindex_s *keyindex;
+    struct jscon_index_s *index;
+    uint64_t hash;
+    bool stale;
+    enum jscon_type packed;
+    size_t num_packed;
+    struct jscon_item_s **element;
 
-    struct hashtable_s *hashtable;
-    struct jscon_item_s *p_item;
-    struct jscon_composite_s *next;
-    struct jscon_composite_s *prev;
+    struct jscon_item_s *branch[];
 } jscon_composite_t;
 
+#define COMPOSITE_SLOT(comp) ((uint32_t*)((comp)->branch + (comp)->capacity))
+#define PACKED_INTEGER(comp) ((long long*)(void*)(comp)->branch)
+#define PACKED_DOUBLE(comp) ((double*)(void*)(comp)->branch)
 
-void Jscon_composite_link_r(struct jscon_item_s *item, jscon_composite_t **last_accessed_comp);
+jscon_composite_t* Jscon_composite_init(size_t capacity);
+bool Jscon_composite_reserve(struct jscon_item_s *item, size_t capacity);
+void Jscon_composite_link_r(struct jscon_item_s *item, struct jscon_item_s **p_last_accessed);
 void Jscon_composite_build(struct jscon_item_s *item);
-struct jscon_item_s* Jscon_composite_get(const char *key, struct jscon_item_s *item);
+struct jscon_item_s* Jscon_composite_get(const char *key, const struct jscon_item_s *item);
 struct jscon_item_s* Jscon_composite_set(const char *key, struct jscon_item_s *item);
-void Jscon_composite_remake(jscon_item_t *item);
+void Jscon_composite_remake(struct jscon_item_s *item);
 
 
 /* JSCON ITEM STRUCTURE
  * key: item's jscon key (NULL if root)
  * parent: object or array that its part of (NULL if root)
  * type: item's jscon datatype (check enum jscon_type_e for flags) 
+ * flags: item's memory ownership (check JSCON_ITEM_* flags)
  * union {string, d_number, i_number, boolean, comp}:
  *      string,d_number,i_number,boolean: item literal value, denoted 
- *      by its type.  */
+ *      by its type.
+ * inline_buf: key and string copied along with the item, key comes
+ *      first. key and string point to it when flagged as inline, so
+ *      they can be read the same either way
+ * the fixed part is a 32 bytes header on 64-bit targets (8 value,
+ *      4 type, 4 flags, 8 key, 8 parent), inline_buf follows it in
+ *      the same allocation */
 typedef struct jscon_item_s {
     union {
         char *string;
@@ -102,19 +147,182 @@ typedef struct jscon_item_s {
         jscon_composite_t *comp;
     };
     enum jscon_type type;
+    unsigned int flags; //type and flags take 8 bytes together
 
     char *key;
     struct jscon_item_s *parent;
+
+    char inline_buf[];
 } jscon_item_t;
 
+/* item memory is owned by a jscon_parser_t arena, it is released all at
+    once by jscon_parser_reset(), and can't be modified meanwhile */
+#define JSCON_ITEM_ARENA (1 << 0)
+
+/* item key or string is kept at inline_buf, and not allocated */
+#define JSCON_ITEM_INLINE_KEY (1 << 1)
+#define JSCON_ITEM_INLINE_STRING (1 << 2)
+
+#define IS_READONLY(item) ((item)->flags & JSCON_ITEM_ARENA)
+#define IS_PACKED(item) (JSCON_ARRAY == (item)->type && 0 != (item)->comp->packed)
+
+/* JSCON ARENA
+ * bump allocator owned by a jscon_parser_t, memory is never released
+ * individually, but recycled as a whole at reset. chunks are kept in
+ * a list from newest to oldest */
+struct jscon_arena_chunk_s {
+    struct jscon_arena_chunk_s *next;
+    size_t size; //usable bytes, after header
+};
+
+struct jscon_arena_s {
+    struct jscon_arena_chunk_s *chunk; //current chunk
+    size_t offset; //bytes used at current chunk
+    const jscon_allocator_t *allocator; //chunks source, NULL for global
+};
+
+/* FORMAT SPECIFIERS
+ * conversion specifiers shared by jscon_scanf() and jscon_printf()
+ * family of functions, as in "%specifier[key]" */
+enum jscon_specifier {
+    JSCON_SPECIFIER_NONE = 0,
+    JSCON_SPECIFIER_CHAR,       /* %c   char   */
+    JSCON_SPECIFIER_STRING,     /* %s   char*  */
+    JSCON_SPECIFIER_INT,        /* %d   int    */
+    JSCON_SPECIFIER_LONG,       /* %ld  long   */
+    JSCON_SPECIFIER_LLONG,      /* %lld long long */
+    JSCON_SPECIFIER_FLOAT,      /* %f   float  */
+    JSCON_SPECIFIER_DOUBLE,     /* %lf  double */
+    JSCON_SPECIFIER_BOOLEAN,    /* %b   bool   */
+    JSCON_SPECIFIER_ITEM,       /* %ji  jscon_item_t* */
+};
+
+/* JSCON OUTPUT BUFFER
+ * bounded writer for encoders that serialize straight into caller
+ * memory. it behaves like snprintf: at most size-1 chars are written,
+ * the buffer is always nul terminated (if size > 0) and offset counts
+ * every char that would have been written, so that a NULL buffer of
+ * size 0 can be used for measuring the output length */
+struct jscon_outbuf_s {
+    char *base;
+    size_t size;
+    size_t offset;
+};
+
+static inline void
+Jscon_outbuf_putc(struct jscon_outbuf_s *out, char c)
+{
+    if (out->offset + 1 < out->size){
+        out->base[out->offset] = c;
+    }
+    ++out->offset;
+}
+
+static inline void
+Jscon_outbuf_write(struct jscon_outbuf_s *out, const char *str, size_t len)
+{
+    if (out->offset + len < out->size){
+        memcpy(out->base + out->offset, str, len);
+    } else if (out->offset + 1 < out->size){
+        memcpy(out->base + out->offset, str, out->size - out->offset - 1);
+    }
+    out->offset += len;
+}
+
+/* nul terminate buffer at current (or last available) position */
+static inline void
+Jscon_outbuf_end(struct jscon_outbuf_s *out)
+{
+    if (0 == out->size) return;
+
+    out->base[(out->offset < out->size) ? out->offset : out->size-1] = '\0';
+}
+
+/*
+ * jscon-alloc.c
+ */
+/* every allocation goes through these, so that the installed
+    jscon_allocator_t, or a jscon_parser_t arena for the duration
+    of a parse, may take over */
+void* Jscon_malloc(size_t size, enum jscon_alloc_category category);
+void* Jscon_calloc(size_t num, size_t size, enum jscon_alloc_category category);
+void* Jscon_realloc(void *ptr, size_t size, enum jscon_alloc_category category);
+char* Jscon_strndup(const char *str, size_t len, enum jscon_alloc_category category);
+void Jscon_free(void *ptr);
+
+struct jscon_arena_s* Jscon_arena_swap(struct jscon_arena_s *arena);
+void Jscon_arena_reset(struct jscon_arena_s *arena);
+void Jscon_arena_destroy(struct jscon_arena_s *arena);
+
+/*
+ * jscon-intern.c
+ */
+char* Jscon_intern_key(jscon_intern_t *intern, const char *key, size_t len);
+
+/*
+ * jscon-public.c
+ */
+jscon_item_t* Jscon_branch_insert(jscon_item_t *item, jscon_item_t *new_branch, size_t index);
+jscon_item_t* Jscon_branch_remove(jscon_item_t *item);
+jscon_item_t* Jscon_item_copy(jscon_item_t *item, const char *key);
+
+/*
+ * jscon-packed.c
+ */
+jscon_composite_t* Jscon_packed_decode(char **p_buffer);
+jscon_composite_t* Jscon_packed_copy(const jscon_composite_t *comp);
+void Jscon_packed_destroy(jscon_composite_t *comp);
+jscon_item_t* Jscon_array_element(const jscon_item_t *item, size_t index);
+void Jscon_array_unpack(jscon_item_t *item);
+
+/*
+ * jscon-diff.c
+ */
+void Jscon_hash_invalidate(jscon_item_t *item);
+
+/*
+ * jscon-index.c
+ */
+void Jscon_index_link(jscon_item_t *element);
+void Jscon_index_unlink(jscon_item_t *element);
+void Jscon_index_destroy(struct jscon_index_s *index);
+
+/*
+ * jscon-keyindex.c
+ */
+struct jscon_keyindex_s* Jscon_keyindex_get(jscon_item_t *item);
+void Jscon_keyindex_add(struct jscon_keyindex_s *keyindex, jscon_item_t *item);
+void Jscon_keyindex_remove(struct jscon_keyindex_s *keyindex, jscon_item_t *item);
+void Jscon_keyindex_destroy(struct jscon_keyindex_s *keyindex);
+
 /*
  * jscon-common.c
  */
-char* Jscon_decode_string(char **p_buffer);
+uint64_t Jscon_strhash(const char *str, size_t len);
+
+jscon_item_t* Jscon_item_init(const char *key, size_t key_len, const char *string, size_t string_len);
+char* Jscon_item_set_key(jscon_item_t *item, const char *key, size_t len);
+char* Jscon_item_set_string(jscon_item_t *item, const char *string, size_t len);
+void Jscon_item_free_key(jscon_item_t *item);
+void Jscon_item_free_string(jscon_item_t *item);
+
+char* Jscon_decode_string_inplace(char **p_buffer, size_t *p_len);
+char* Jscon_skip_string(char *buffer);
+char* Jscon_skip_composite(char *buffer);
+char* Jscon_skip_value(char *buffer);
 double Jscon_decode_double(char **p_buffer);
+bool Jscon_decode_number(char **p_buffer, long long *p_i_number, double *p_d_number);
+size_t Jscon_count_number_array(const char *buffer, const char **p_end);
+char* Jscon_decode_number_array(char *buffer, const char *end, size_t num_element, double d_number[]);
 bool Jscon_decode_boolean(char **p_buffer);
 void Jscon_decode_null(char **p_buffer);
 jscon_composite_t* Jscon_decode_composite(char **p_buffer, size_t n_branch);
 
+enum jscon_specifier Jscon_specifier_decode(const char *specifier, size_t len);
+size_t Jscon_encode_integer(long long i_number, char *p_str);
+void Jscon_encode_double(const double d_number, char *p_str, const int digits);
+size_t Jscon_encode_double_exact(const double d_number, char *p_str);
+void Jscon_outbuf_string(struct jscon_outbuf_s *out, const char *string, size_t len);
+
 
 #endif
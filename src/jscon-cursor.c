@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <libjscon.h>
+
+#include "jscon-common.h"
+#include "debug.h"
+
+
+/* sets cursor to value found at buffer */
+static void
+_jscon_value_set(jscon_value_t *value, char *buffer)
+{
+    CONSUME_BLANK_CHARS(buffer);
+
+    value->start = ('\0' != *buffer) ? buffer : NULL;
+    value->next = NULL;
+}
+
+/* nothing is decoded until requested, returns the root value cursor */
+jscon_value_t*
+jscon_doc_init(jscon_doc_t *doc, char *buffer)
+{
+    DEBUG_ASSERT(NULL != buffer, "Missing JSON text");
+
+    doc->buffer = buffer;
+    _jscon_value_set(&doc->root, buffer);
+
+    return &doc->root;
+}
+
+/* walks through object members until key is found, every other member
+    is skipped without being decoded */
+bool
+jscon_obj_find_field(const jscon_value_t *object, const char *key, jscon_value_t *p_field)
+{
+    p_field->start = NULL;
+    p_field->next = NULL;
+
+    if (NULL == object || NULL == object->start) return false;
+
+    DEBUG_ASSERT('{' == *object->start, "Value type is not a Object");
+
+    size_t key_len = strlen(key);
+    char *buffer = object->start + 1; //skips '{'
+    while (true){
+        CONSUME_BLANK_CHARS(buffer);
+        switch (*buffer){
+        case '}':/*OBJECT WRAPPER DETECTED*/
+            return false;
+        case ',':/*NEXT PROPERTY TOKEN*/
+            ++buffer;
+            break;
+        case '\"':/*KEY STRING DETECTED*/
+         {
+            /* key is matched in place, no copy is made */
+            size_t len;
+            char *found = Jscon_decode_string_inplace(&buffer, &len);
+
+            CONSUME_BLANK_CHARS(buffer);
+            DEBUG_ASSERT(':' == *buffer, "Missing ':' token after key"); //check for key's assign token 
+            ++buffer; //consume ':'
+            CONSUME_BLANK_CHARS(buffer);
+
+            if (len == key_len && 0 == memcmp(found, key, len)){
+                _jscon_value_set(p_field, buffer);
+                return true;
+            }
+
+            buffer = Jscon_skip_value(buffer);
+            break;
+         }
+        default:
+            DEBUG_ERR("Invalid '%c' token", *buffer);
+            return false;
+        }
+    }
+}
+
+/* fetches the next array element, returns false once there are no
+    elements left. the array cursor keeps the iteration state */
+bool
+jscon_arr_next(jscon_value_t *array, jscon_value_t *p_element)
+{
+    p_element->start = NULL;
+    p_element->next = NULL;
+
+    if (NULL == array || NULL == array->start) return false;
+
+    DEBUG_ASSERT('[' == *array->start, "Value type is not a Array");
+
+    char *buffer;
+    if (NULL == array->next){ //first element
+        buffer = array->start + 1; //skips '['
+    } else { //skips last element returned
+        buffer = Jscon_skip_value(array->next);
+    }
+
+    CONSUME_BLANK_CHARS(buffer);
+    if (',' == *buffer){
+        ++buffer;
+        CONSUME_BLANK_CHARS(buffer);
+    }
+
+    /* array end is kept, so that further calls also return false */
+    array->next = buffer;
+    switch (*buffer){
+    case ']':/*ARRAY WRAPPER DETECTED*/
+        return false;
+    case '\0':
+        DEBUG_ERR("Bad formatting");
+        return false;
+    default:
+        _jscon_value_set(p_element, buffer);
+        return true;
+    }
+}
+
+enum jscon_type
+jscon_value_get_type(const jscon_value_t *value)
+{
+    if (NULL == value || NULL == value->start) return JSCON_UNDEFINED;
+
+    char *buffer = value->start;
+    switch (*buffer){
+    case '{':
+        return JSCON_OBJECT;
+    case '[':
+        return JSCON_ARRAY;
+    case '\"':
+        return JSCON_STRING;
+    case 't':
+    case 'f':
+        return JSCON_BOOLEAN;
+    case 'n':
+        return JSCON_NULL;
+    default:
+        if (!IS_DIGIT(*buffer) && '-' != *buffer) return JSCON_UNDEFINED;
+
+        /* a number with fraction or exponent is still an integer if
+            its value is, same as jscon_parse() */
+        for (++buffer; IS_DIGIT(*buffer); ++buffer)
+            continue;
+        if ('.' == *buffer || 'e' == *buffer || 'E' == *buffer){
+            buffer = value->start;
+            long long i_number;
+            double d_number;
+            if (Jscon_decode_number(&buffer, &i_number, &d_number)
+                || DOUBLE_IS_INTEGER(d_number))
+            {
+                return JSCON_INTEGER;
+            }
+            return JSCON_DOUBLE;
+        }
+        return JSCON_INTEGER;
+    }
+}
+
+bool
+jscon_value_get_boolean(const jscon_value_t *value)
+{
+    enum jscon_type type = jscon_value_get_type(value);
+    if (JSCON_UNDEFINED == type || JSCON_NULL == type) return false;
+
+    DEBUG_ASSERT(JSCON_BOOLEAN == type, "Value type is not a Boolean");
+
+    char *buffer = value->start;
+    return Jscon_decode_boolean(&buffer);
+}
+
+/* the string isn't copied, nor nul terminated, its length is stored
+    at p_len instead */
+char*
+jscon_value_get_string(const jscon_value_t *value, size_t *p_len)
+{
+    enum jscon_type type = jscon_value_get_type(value);
+    if (JSCON_UNDEFINED == type || JSCON_NULL == type){
+        if (NULL != p_len) *p_len = 0;
+        return NULL;
+    }
+
+    DEBUG_ASSERT(JSCON_STRING == type, "Value type is not a String");
+
+    char *buffer = value->start;
+    size_t len;
+    char *string = Jscon_decode_string_inplace(&buffer, &len);
+    if (NULL != p_len) *p_len = len;
+
+    return string;
+}
+
+/* integers are converted to double */
+double
+jscon_value_get_double(const jscon_value_t *value)
+{
+    enum jscon_type type = jscon_value_get_type(value);
+    if (JSCON_UNDEFINED == type || JSCON_NULL == type) return 0.0;
+
+    DEBUG_ASSERT(JSCON_NUMBER & type, "Value type is not a Number");
+
+    char *buffer = value->start;
+    long long i_number;
+    double d_number;
+    Jscon_decode_number(&buffer, &i_number, &d_number);
+
+    return d_number;
+}
+
+long long
+jscon_value_get_integer(const jscon_value_t *value)
+{
+    enum jscon_type type = jscon_value_get_type(value);
+    if (JSCON_UNDEFINED == type || JSCON_NULL == type) return 0;
+
+    DEBUG_ASSERT(JSCON_NUMBER & type, "Value type is not a Number");
+
+    char *buffer = value->start;
+    long long i_number;
+    double d_number;
+    if (Jscon_decode_number(&buffer, &i_number, &d_number)){
+        return i_number;
+    }
+
+    DEBUG_ASSERT(DOUBLE_IS_INTEGER(d_number), "Value type is not a Integer");
+    return (long long)d_number;
+}
+
+/* materializes value as a jscon_item_t, for when the whole subtree
+    is needed */
+jscon_item_t*
+jscon_value_parse(const jscon_value_t *value)
+{
+    if (NULL == value || NULL == value->start) return NULL;
+
+    return jscon_parse(value->start);
+}
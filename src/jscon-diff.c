@@ -0,0 +1,469 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <libjscon.h>
+#include "jscon-common.h"
+
+#include "debug.h"
+
+
+/* JSCON DIFF UTILITY STRUCTURE
+ * patch: JSON Patch being built, an array of operations
+ * path: JSON Pointer of the items being compared
+ * path_len: path length, without its nul terminator
+ * path_size: path allocated size */
+struct jscon_utils_s {
+    jscon_item_t *patch;
+    char *path;
+    size_t path_len;
+    size_t path_size;
+};
+
+/* seeds that keep different types of equal bits apart */
+#define HASH_NULL     UINT64_C(0x6a09e667f3bcc908)
+#define HASH_BOOLEAN  UINT64_C(0xbb67ae8584caa73b)
+#define HASH_NUMBER   UINT64_C(0x3c6ef372fe94f82b)
+#define HASH_STRING   UINT64_C(0xa54ff53a5f1d36f1)
+#define HASH_OBJECT   UINT64_C(0x510e527fade682d1)
+#define HASH_ARRAY    UINT64_C(0x9b05688c2b3e6c1f)
+
+static inline uint64_t
+_jscon_hash_mix(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+/* integers and integral doubles of same value hash alike, as JSON
+    makes no distinction between them */
+static inline uint64_t
+_jscon_hash_integer(long long i_number){
+    return _jscon_hash_mix(HASH_NUMBER ^ (uint64_t)i_number);
+}
+
+static uint64_t
+_jscon_hash_double(double d_number)
+{
+    if (d_number == trunc(d_number) && fabs(d_number) < 0x1p63){
+        return _jscon_hash_integer((long long)d_number);
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &d_number, sizeof bits);
+    return _jscon_hash_mix(HASH_NUMBER ^ bits);
+}
+
+static uint64_t
+_jscon_hash_number(const jscon_item_t *item)
+{
+    return (JSCON_INTEGER == item->type)
+            ? _jscon_hash_integer(item->i_number)
+            : _jscon_hash_double(item->d_number);
+}
+
+static uint64_t _jscon_hash(const jscon_item_t *item);
+
+/* members are summed, so that objects hash alike regardless of their
+    members order */
+static uint64_t
+_jscon_hash_object(const jscon_item_t *item)
+{
+    uint64_t hash = HASH_OBJECT + item->comp->num_branch;
+    for (size_t i=0; i < item->comp->num_branch; ++i){
+        const jscon_item_t *branch = item->comp->branch[i];
+        const uint64_t key_hash = Jscon_strhash(branch->key, strlen(branch->key));
+
+        hash += _jscon_hash_mix(key_hash ^ _jscon_hash(branch));
+    }
+
+    return _jscon_hash_mix(hash);
+}
+
+static uint64_t
+_jscon_hash_array(const jscon_item_t *item)
+{
+    /* packed elements hash the same as they would once unpacked */
+    const jscon_composite_t *comp = item->comp;
+    if (IS_PACKED(item)){
+        uint64_t hash = HASH_ARRAY + comp->num_packed;
+        for (size_t i=0; i < comp->num_packed; ++i){
+            hash = _jscon_hash_mix(hash ^ ((JSCON_INTEGER == comp->packed)
+                                            ? _jscon_hash_integer(PACKED_INTEGER(comp)[i])
+                                            : _jscon_hash_double(PACKED_DOUBLE(comp)[i])));
+        }
+        return hash;
+    }
+
+    uint64_t hash = HASH_ARRAY + item->comp->num_branch;
+    for (size_t i=0; i < item->comp->num_branch; ++i){
+        hash = _jscon_hash_mix(hash ^ _jscon_hash(item->comp->branch[i]));
+    }
+
+    return hash;
+}
+
+/* composites hash is cached, and only recomputed for the ones
+    modified since (check Jscon_hash_invalidate()). read-only trees
+    may be shared between threads, and are never cached. other trees
+    may be read from many threads as well, so the cache is accessed
+    atomically, each of them storing the same value */
+static uint64_t
+_jscon_hash(const jscon_item_t *item)
+{
+    switch (item->type){
+    case JSCON_NULL:
+        return HASH_NULL;
+    case JSCON_BOOLEAN:
+        return _jscon_hash_mix(HASH_BOOLEAN ^ item->boolean);
+    case JSCON_INTEGER:
+    case JSCON_DOUBLE:
+        return _jscon_hash_number(item);
+    case JSCON_STRING:
+        return _jscon_hash_mix(HASH_STRING ^ Jscon_strhash(item->string, strlen(item->string)));
+    case JSCON_OBJECT:
+    case JSCON_ARRAY:
+        break;
+    default:
+        DEBUG_ERR("Can't hash undefined datatype, code: %d", item->type);
+        return HASH_NULL;
+    }
+
+    jscon_composite_t *comp = item->comp;
+
+    uint64_t hash = __atomic_load_n(&comp->hash, __ATOMIC_RELAXED);
+    if (0 != hash) return hash;
+
+    hash = (JSCON_OBJECT == item->type)
+                ? _jscon_hash_object(item)
+                : _jscon_hash_array(item);
+    if (0 == hash) hash = 1; //0 is reserved for not computed
+
+    if (!IS_READONLY(item)){
+        __atomic_store_n(&comp->hash, hash, __ATOMIC_RELAXED);
+    }
+
+    return hash;
+}
+
+/* discard the cached hash of item and its ancestors, must be called
+    whenever a composite branches change. a composite hash is only
+    cached if its branches are, so it may stop at the first one
+    that isn't */
+void
+Jscon_hash_invalidate(jscon_item_t *item)
+{
+    while (NULL != item && 0 != item->comp->hash){
+        item->comp->hash = 0;
+        item = item->parent;
+    }
+}
+
+/* content hash of item, equal items have the same hash */
+uint64_t
+jscon_hash(const jscon_item_t *item)
+{
+    DEBUG_ASSERT(NULL != item, "Missing item");
+
+    return _jscon_hash(item);
+}
+
+static bool
+_jscon_primitive_equal(const jscon_item_t *a, const jscon_item_t *b)
+{
+    switch (a->type){
+    case JSCON_NULL:
+        return JSCON_NULL == b->type;
+    case JSCON_BOOLEAN:
+        return JSCON_BOOLEAN == b->type && a->boolean == b->boolean;
+    case JSCON_STRING:
+        return JSCON_STRING == b->type && STREQ(a->string, b->string);
+    case JSCON_INTEGER:
+    case JSCON_DOUBLE:
+        if (!jscon_typecmp(b, JSCON_NUMBER)) return false;
+        if (a->type == b->type){
+            return (JSCON_INTEGER == a->type)
+                    ? a->i_number == b->i_number
+                    : a->d_number == b->d_number;
+        }
+        /* same hash is only reached by integral doubles */
+        return _jscon_hash_number(a) == _jscon_hash_number(b);
+    default:
+        DEBUG_ERR("Can't compare undefined datatype, code: %d", a->type);
+        return false;
+    }
+}
+
+/* element of array at index, packed numbers are read into number */
+static const jscon_item_t*
+_jscon_array_element(const jscon_item_t *array, size_t index, jscon_item_t *number)
+{
+    const jscon_composite_t *comp = array->comp;
+    if (!IS_PACKED(array)) return comp->branch[index];
+
+    number->type = comp->packed;
+    if (JSCON_INTEGER == comp->packed){
+        number->i_number = PACKED_INTEGER(comp)[index];
+    } else {
+        number->d_number = PACKED_DOUBLE(comp)[index];
+    }
+    return number;
+}
+
+/* composites whose hashes match are compared branch by branch, as
+    different ones may still share a hash */
+static bool
+_jscon_composite_equal(const jscon_item_t *a, const jscon_item_t *b)
+{
+    const size_t size = jscon_size(a);
+    if (size != jscon_size(b)) return false;
+
+    if (JSCON_OBJECT == a->type){
+        for (size_t i=0; i < size; ++i){
+            const jscon_item_t *a_branch = a->comp->branch[i];
+            const jscon_item_t *b_branch = Jscon_composite_get(a_branch->key, b);
+            if (NULL == b_branch || !jscon_equal(a_branch, b_branch)) return false;
+        }
+        return true;
+    }
+
+    jscon_item_t a_number, b_number;
+    for (size_t i=0; i < size; ++i){
+        if (!jscon_equal(_jscon_array_element(a, i, &a_number), _jscon_array_element(b, i, &b_number))){
+            return false;
+        }
+    }
+    return true;
+}
+
+/* items are equal if they have the same value, regardless of their
+    keys or object members order. composites whose hashes differ are
+    told apart at once, otherwise their branches are compared */
+bool
+jscon_equal(const jscon_item_t *a, const jscon_item_t *b)
+{
+    DEBUG_ASSERT(NULL != a && NULL != b, "Missing item");
+
+    if (a == b) return true;
+
+    if (IS_PRIMITIVE(a) || IS_PRIMITIVE(b)){
+        return IS_PRIMITIVE(a) && IS_PRIMITIVE(b) && _jscon_primitive_equal(a, b);
+    }
+
+    if (a->type != b->type || _jscon_hash(a) != _jscon_hash(b)) return false;
+
+    return _jscon_composite_equal(a, b);
+}
+
+/* appends token to path, escaped as a JSON Pointer reference token */
+static size_t
+_jscon_diff_path_push(struct jscon_utils_s *utils, const char *token)
+{
+    const size_t old_len = utils->path_len;
+
+    size_t needed = utils->path_len + 2 + 2 * strlen(token);
+    if (needed > utils->path_size){
+        utils->path_size = 2 * needed;
+        utils->path = Jscon_realloc(utils->path, utils->path_size, JSCON_ALLOC_OTHER);
+        DEBUG_ASSERT(NULL != utils->path, "Out of memory");
+    }
+
+    char *p = utils->path + utils->path_len;
+    *p++ = '/';
+    for ( ; '\0' != *token; ++token){
+        switch (*token){
+        case '~':
+            *p++ = '~';
+            *p++ = '0';
+            break;
+        case '/':
+            *p++ = '~';
+            *p++ = '1';
+            break;
+        default:
+            *p++ = *token;
+            break;
+        }
+    }
+    *p = '\0';
+    utils->path_len = p - utils->path;
+
+    return old_len;
+}
+
+static size_t
+_jscon_diff_path_push_index(struct jscon_utils_s *utils, size_t index)
+{
+    char numerical_key[32];
+    snprintf(numerical_key, sizeof numerical_key, "%zu", index);
+
+    return _jscon_diff_path_push(utils, numerical_key);
+}
+
+static void
+_jscon_diff_path_pop(struct jscon_utils_s *utils, size_t old_len)
+{
+    utils->path_len = old_len;
+    utils->path[old_len] = '\0';
+}
+
+/* appends operation op at current path to patch, along with a copy
+    of value, if not NULL */
+static void
+_jscon_diff_emit(struct jscon_utils_s *utils, char *op, jscon_item_t *value)
+{
+    char numerical_key[32];
+    snprintf(numerical_key, sizeof numerical_key, "%zu", jscon_size(utils->patch));
+
+    jscon_item_t *operation = jscon_append(utils->patch, jscon_object(numerical_key));
+    DEBUG_ASSERT(NULL != operation, "Out of memory");
+
+    jscon_append(operation, jscon_string("op", op));
+    jscon_append(operation, jscon_string("path", (NULL != utils->path) ? utils->path : ""));
+    if (NULL != value){
+        jscon_item_t *value_copy = Jscon_item_copy(value, "value");
+        DEBUG_ASSERT(NULL != value_copy, "Out of memory");
+
+        jscon_append(operation, value_copy);
+    }
+}
+
+static void _jscon_diff(struct jscon_utils_s *utils, jscon_item_t *a, jscon_item_t *b);
+
+static void
+_jscon_diff_object(struct jscon_utils_s *utils, jscon_item_t *a, jscon_item_t *b)
+{
+    for (size_t i=0; i < a->comp->num_branch; ++i){
+        jscon_item_t *a_branch = a->comp->branch[i];
+        jscon_item_t *b_branch = Jscon_composite_get(a_branch->key, b);
+
+        size_t old_len = _jscon_diff_path_push(utils, a_branch->key);
+        if (NULL == b_branch){
+            _jscon_diff_emit(utils, "remove", NULL);
+        }
+        else {
+            _jscon_diff(utils, a_branch, b_branch);
+        }
+        _jscon_diff_path_pop(utils, old_len);
+    }
+
+    for (size_t i=0; i < b->comp->num_branch; ++i){
+        jscon_item_t *b_branch = b->comp->branch[i];
+        if (NULL != Jscon_composite_get(b_branch->key, a)) continue;
+
+        size_t old_len = _jscon_diff_path_push(utils, b_branch->key);
+        _jscon_diff_emit(utils, "add", b_branch);
+        _jscon_diff_path_pop(utils, old_len);
+    }
+}
+
+/* elements equal at both arrays start and end are skipped, those in
+    between are compared by position, and the remaining ones removed
+    from or added to a */
+static void
+_jscon_diff_array(struct jscon_utils_s *utils, jscon_item_t *a, jscon_item_t *b)
+{
+    size_t a_size = jscon_size(a);
+    size_t b_size = jscon_size(b);
+
+    jscon_item_t a_number, b_number;
+
+    size_t start = 0;
+    while (start < a_size && start < b_size
+            && jscon_equal(_jscon_array_element(a, start, &a_number), _jscon_array_element(b, start, &b_number)))
+    {
+        ++start;
+    }
+    while (a_size > start && b_size > start
+            && jscon_equal(_jscon_array_element(a, a_size-1, &a_number), _jscon_array_element(b, b_size-1, &b_number)))
+    {
+        --a_size;
+        --b_size;
+    }
+
+    size_t i = start;
+    for ( ; i < a_size && i < b_size; ++i){
+        size_t old_len = _jscon_diff_path_push_index(utils, i);
+        _jscon_diff(utils, Jscon_array_element(a, i), Jscon_array_element(b, i));
+        _jscon_diff_path_pop(utils, old_len);
+    }
+
+    /* each removal shifts the following elements to index i */
+    for (size_t j=i; j < a_size; ++j){
+        size_t old_len = _jscon_diff_path_push_index(utils, i);
+        _jscon_diff_emit(utils, "remove", NULL);
+        _jscon_diff_path_pop(utils, old_len);
+    }
+    for ( ; i < b_size; ++i){
+        size_t old_len = _jscon_diff_path_push_index(utils, i);
+        _jscon_diff_emit(utils, "add", Jscon_array_element(b, i));
+        _jscon_diff_path_pop(utils, old_len);
+    }
+}
+
+/* only composites of same type whose hashes differ are descended
+    into, anything else that differs is replaced as a whole */
+static void
+_jscon_diff(struct jscon_utils_s *utils, jscon_item_t *a, jscon_item_t *b)
+{
+    if (jscon_equal(a, b)) return;
+
+    if (a->type != b->type || IS_PRIMITIVE(a)){
+        _jscon_diff_emit(utils, "replace", b);
+        return;
+    }
+
+    if (JSCON_OBJECT == a->type){
+        _jscon_diff_object(utils, a, b);
+    }
+    else {
+        _jscon_diff_array(utils, a, b);
+    }
+}
+
+/* JSON Patch (RFC 6902) array of operations that turn a into b */
+jscon_item_t*
+jscon_diff(jscon_item_t *a, jscon_item_t *b)
+{
+    DEBUG_ASSERT(NULL != a && NULL != b, "Missing item");
+
+    struct jscon_utils_s utils = {
+        .patch = jscon_array(NULL),
+    };
+    if (NULL == utils.patch) return NULL;
+
+    _jscon_diff(&utils, a, b);
+
+    Jscon_free(utils.path);
+
+    return utils.patch;
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <libjscon.h>
+#include "jscon-common.h"
+
+#include "debug.h"
+
+
+/* JSCON FIELD INDEX
+ * hash index of an array of objects, from the value of one of their
+ * fields to the element holding it. kept at the array composite,
+ * and updated whenever an element or its field changes
+ * field: key of the indexed field
+ * slot: open addressing table of elements (NULL if empty)
+ * hash: hash of each slot element field value
+ * num_slot: table size, always a power of two
+ * num_element: elements indexed, the table is kept at most half full
+ * next: next index of the same array */
+struct jscon_index_s {
+    char *field;
+    jscon_item_t **slot;
+    uint64_t *hash;
+    size_t num_slot;
+    size_t num_element;
+    struct jscon_index_s *next;
+};
+
+
+/* spread integer bits, so that sequential ids don't cluster */
+static inline uint64_t
+_jscon_index_hash_integer(long long i_number)
+{
+    uint64_t hash = (uint64_t)i_number;
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+/* the indexed field of element, NULL if element can't be indexed */
+static jscon_item_t*
+_jscon_index_field(const struct jscon_index_s *index, jscon_item_t *element)
+{
+    if (JSCON_OBJECT != element->type) return NULL;
+
+    jscon_item_t *field = Jscon_composite_get(index->field, element);
+    if (NULL == field) return NULL;
+
+    switch (field->type){
+    case JSCON_STRING:
+    case JSCON_INTEGER:
+        return field;
+    default:
+        return NULL;
+    }
+}
+
+static uint64_t
+_jscon_index_hash(const jscon_item_t *field)
+{
+    return (JSCON_STRING == field->type)
+            ? Jscon_strhash(field->string, strlen(field->string))
+            : _jscon_index_hash_integer(field->i_number);
+}
+
+static void
+_jscon_index_insert(struct jscon_index_s *index, jscon_item_t *element, uint64_t hash)
+{
+    const size_t mask = index->num_slot-1;
+
+    size_t i = hash & mask;
+    while (NULL != index->slot[i]){
+        i = (i+1) & mask;
+    }
+    index->slot[i] = element;
+    index->hash[i] = hash;
+    ++index->num_element;
+}
+
+static void
+_jscon_index_grow(struct jscon_index_s *index)
+{
+    jscon_item_t **old_slot = index->slot;
+    uint64_t *old_hash = index->hash;
+    const size_t old_num_slot = index->num_slot;
+
+    index->num_slot = (0 == old_num_slot) ? 16 : 2 * old_num_slot;
+    index->slot = Jscon_calloc(index->num_slot, sizeof *index->slot, JSCON_ALLOC_HASHTABLE);
+    DEBUG_ASSERT(NULL != index->slot, "Out of memory");
+    index->hash = Jscon_malloc(index->num_slot * sizeof *index->hash, JSCON_ALLOC_HASHTABLE);
+    DEBUG_ASSERT(NULL != index->hash, "Out of memory");
+    index->num_element = 0;
+
+    for (size_t i=0; i < old_num_slot; ++i){
+        if (NULL != old_slot[i]){
+            _jscon_index_insert(index, old_slot[i], old_hash[i]);
+        }
+    }
+    Jscon_free(old_slot);
+    Jscon_free(old_hash);
+}
+
+static void
+_jscon_index_add(struct jscon_index_s *index, jscon_item_t *element)
+{
+    jscon_item_t *field = _jscon_index_field(index, element);
+    if (NULL == field) return;
+
+    if (2 * (index->num_element+1) > index->num_slot){
+        _jscon_index_grow(index);
+    }
+    _jscon_index_insert(index, element, _jscon_index_hash(field));
+}
+
+/* removes element, shifting back the elements that follow it in the
+    same probe sequence, so that no tombstone is needed */
+static void
+_jscon_index_remove(struct jscon_index_s *index, jscon_item_t *element)
+{
+    jscon_item_t *field = _jscon_index_field(index, element);
+    if (NULL == field) return;
+
+    const size_t mask = index->num_slot-1;
+
+    size_t i = _jscon_index_hash(field) & mask;
+    while (element != index->slot[i]){
+        DEBUG_ASSERT(NULL != index->slot[i], "Element is missing from index");
+        i = (i+1) & mask;
+    }
+
+    size_t j = i;
+    while (true){
+        j = (j+1) & mask;
+        if (NULL == index->slot[j]) break;
+
+        /* slot[j] stays if its home slot is cyclically in (i, j] */
+        size_t home = index->hash[j] & mask;
+        if ((i < j) ? (i < home && home <= j) : (i < home || home <= j)){
+            continue;
+        }
+
+        index->slot[i] = index->slot[j];
+        index->hash[i] = index->hash[j];
+        i = j;
+    }
+    index->slot[i] = NULL;
+    --index->num_element;
+}
+
+static struct jscon_index_s*
+_jscon_index_of(const jscon_item_t *element)
+{
+    const jscon_item_t *array = element->parent;
+    if (NULL == array || JSCON_ARRAY != array->type) return NULL;
+
+    return array->comp->index;
+}
+
+/* add element to the indexes of its array, if any */
+void
+Jscon_index_link(jscon_item_t *element)
+{
+    for (struct jscon_index_s *index = _jscon_index_of(element); NULL != index; index = index->next){
+        _jscon_index_add(index, element);
+    }
+}
+
+/* remove element from the indexes of its array, if any. must be
+    called before element or its fields change, and linked back once
+    done */
+void
+Jscon_index_unlink(jscon_item_t *element)
+{
+    for (struct jscon_index_s *index = _jscon_index_of(element); NULL != index; index = index->next){
+        _jscon_index_remove(index, element);
+    }
+}
+
+/* destroy every index of an array */
+void
+Jscon_index_destroy(struct jscon_index_s *index)
+{
+    while (NULL != index){
+        struct jscon_index_s *next = index->next;
+
+        Jscon_free(index->field);
+        Jscon_free(index->slot);
+        Jscon_free(index->hash);
+        Jscon_free(index);
+
+        index = next;
+    }
+}
+
+/* index the array elements by the value of field, which may be a
+    string or an integer. the index belongs to the array, and is kept
+    up to date until the array is destroyed */
+jscon_index_t*
+jscon_index_by(jscon_item_t *array, const char *field)
+{
+    DEBUG_ASSERT(NULL != array && JSCON_ARRAY == array->type, "Item is not an Array");
+    DEBUG_ASSERT(!IS_READONLY(array), "Item is owned by a parser");
+    DEBUG_ASSERT(NULL != field, "Missing field");
+
+    for (struct jscon_index_s *index = array->comp->index; NULL != index; index = index->next){
+        if (STREQ(field, index->field)) return index;
+    }
+
+    struct jscon_index_s *new_index = Jscon_calloc(1, sizeof *new_index, JSCON_ALLOC_HASHTABLE);
+    if (NULL == new_index) return NULL;
+
+    new_index->field = Jscon_strndup(field, strlen(field), JSCON_ALLOC_KEY);
+    DEBUG_ASSERT(NULL != new_index->field, "Out of memory");
+
+    _jscon_index_grow(new_index);
+    for (size_t i=0; i < array->comp->num_branch; ++i){
+        _jscon_index_add(new_index, array->comp->branch[i]);
+    }
+
+    new_index->next = array->comp->index;
+    array->comp->index = new_index;
+
+    return new_index;
+}
+
+/* element whose field is string, NULL if none. if many have it,
+    any of them is returned */
+jscon_item_t*
+jscon_index_lookup(const jscon_index_t *index, const char *string)
+{
+    DEBUG_ASSERT(NULL != string, "Missing string");
+
+    const uint64_t hash = Jscon_strhash(string, strlen(string));
+    const size_t mask = index->num_slot-1;
+
+    for (size_t i = hash & mask; NULL != index->slot[i]; i = (i+1) & mask){
+        if (hash != index->hash[i]) continue;
+
+        jscon_item_t *field = _jscon_index_field(index, index->slot[i]);
+        if (JSCON_STRING == field->type && STREQ(string, field->string)){
+            return index->slot[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* element whose field is i_number, NULL if none. if many have it,
+    any of them is returned */
+jscon_item_t*
+jscon_index_lookup_integer(const jscon_index_t *index, long long i_number)
+{
+    const uint64_t hash = _jscon_index_hash_integer(i_number);
+    const size_t mask = index->num_slot-1;
+
+    for (size_t i = hash & mask; NULL != index->slot[i]; i = (i+1) & mask){
+        if (hash != index->hash[i]) continue;
+
+        jscon_item_t *field = _jscon_index_field(index, index->slot[i]);
+        if (JSCON_INTEGER == field->type && i_number == field->i_number){
+            return index->slot[i];
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <libjscon.h>
+#include "jscon-common.h"
+
+#include "debug.h"
+
+
+/* key storage is carved from blocks of at least this size */
+#define INTERN_BLOCK_SIZE (16 * 1024)
+
+struct jscon_intern_block_s {
+    struct jscon_intern_block_s *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+/* JSCON INTERN POOL
+ * keeps a single copy of each distinct key, so that items sharing a
+ * key share its storage, and may be compared by pointer
+ * slot: open addressing table of interned keys (NULL if empty)
+ * hash: hash of each slot key, compared before the keys themselves
+ * num_slot: table size, always a power of two
+ * num_key: keys interned, the table is kept at most half full
+ * block: key storage, from newest to oldest
+ * is_shared: if true, access is serialized by lock */
+struct jscon_intern_s {
+    char **slot;
+    uint64_t *hash;
+    size_t num_slot;
+    size_t num_key;
+    struct jscon_intern_block_s *block;
+    bool is_shared;
+    char lock;
+};
+
+static void
+_jscon_intern_lock(jscon_intern_t *intern)
+{
+    if (!intern->is_shared) return;
+
+    while (__atomic_test_and_set(&intern->lock, __ATOMIC_ACQUIRE)){
+        continue;
+    }
+}
+
+static void
+_jscon_intern_unlock(jscon_intern_t *intern)
+{
+    if (!intern->is_shared) return;
+
+    __atomic_clear(&intern->lock, __ATOMIC_RELEASE);
+}
+
+/* pool memory must outlive parser resets, so its never taken from
+    an arena, even if a parse is taking place */
+static bool
+_jscon_intern_grow(jscon_intern_t *intern)
+{
+    const size_t num_slot = 2 * intern->num_slot;
+
+    char **slot = Jscon_calloc(num_slot, sizeof *slot, JSCON_ALLOC_HASHTABLE);
+    if (NULL == slot) return false;
+    uint64_t *hash = Jscon_malloc(num_slot * sizeof *hash, JSCON_ALLOC_HASHTABLE);
+    if (NULL == hash){
+        Jscon_free(slot);
+        return false;
+    }
+
+    for (size_t i=0; i < intern->num_slot; ++i){
+        if (NULL == intern->slot[i]) continue;
+
+        size_t index = intern->hash[i] & (num_slot-1);
+        while (NULL != slot[index]){
+            index = (index+1) & (num_slot-1);
+        }
+        slot[index] = intern->slot[i];
+        hash[index] = intern->hash[i];
+    }
+
+    Jscon_free(intern->slot);
+    Jscon_free(intern->hash);
+
+    intern->slot = slot;
+    intern->hash = hash;
+    intern->num_slot = num_slot;
+
+    return true;
+}
+
+static char*
+_jscon_intern_store(jscon_intern_t *intern, const char *key, size_t len)
+{
+    struct jscon_intern_block_s *block = intern->block;
+    if (NULL == block || block->used + len+1 > block->size){
+        size_t size = (len+1 > INTERN_BLOCK_SIZE) ? len+1 : INTERN_BLOCK_SIZE;
+
+        block = Jscon_malloc(sizeof *block + size, JSCON_ALLOC_KEY);
+        if (NULL == block) return NULL;
+
+        block->next = intern->block;
+        block->size = size;
+        block->used = 0;
+        intern->block = block;
+    }
+
+    char *new_key = block->data + block->used;
+    memcpy(new_key, key, len);
+    new_key[len] = '\0';
+    block->used += len+1;
+
+    return new_key;
+}
+
+/* returns the pool copy of key with given len, which is added
+    to the pool if missing. returns NULL if out of memory */
+char*
+Jscon_intern_key(jscon_intern_t *intern, const char *key, size_t len)
+{
+    const uint64_t hash = Jscon_strhash(key, len);
+    char *found = NULL;
+
+    struct jscon_arena_s *prev = Jscon_arena_swap(NULL);
+    _jscon_intern_lock(intern);
+
+    size_t index = hash & (intern->num_slot-1);
+    while (NULL != intern->slot[index]){
+        if (hash == intern->hash[index]
+            && STRNEQ(intern->slot[index], key, len)
+            && '\0' == intern->slot[index][len])
+        {
+            found = intern->slot[index];
+            goto unlock;
+        }
+        index = (index+1) & (intern->num_slot-1);
+    }
+
+    found = _jscon_intern_store(intern, key, len);
+    if (NULL == found) goto unlock;
+
+    intern->slot[index] = found;
+    intern->hash[index] = hash;
+
+    if (++intern->num_key > intern->num_slot/2){
+        _jscon_intern_grow(intern); //on failure, table is just fuller
+    }
+
+unlock:
+    _jscon_intern_unlock(intern);
+    Jscon_arena_swap(prev);
+
+    return found;
+}
+
+/* if is_shared is true the pool may be used by many threads at once,
+    otherwise it should be used by one thread at a time */
+jscon_intern_t*
+jscon_intern_init(bool is_shared)
+{
+    jscon_intern_t *new_intern = Jscon_calloc(1, sizeof *new_intern, JSCON_ALLOC_OTHER);
+    if (NULL == new_intern) return NULL;
+
+    new_intern->num_slot = 64;
+    new_intern->slot = Jscon_calloc(new_intern->num_slot, sizeof *new_intern->slot, JSCON_ALLOC_HASHTABLE);
+    new_intern->hash = Jscon_malloc(new_intern->num_slot * sizeof *new_intern->hash, JSCON_ALLOC_HASHTABLE);
+    if (NULL == new_intern->slot || NULL == new_intern->hash){
+        jscon_intern_destroy(new_intern);
+        return NULL;
+    }
+    new_intern->is_shared = is_shared;
+
+    return new_intern;
+}
+
+/* every key returned by the pool is freed, so items referring to
+    them must have been released first */
+void
+jscon_intern_destroy(jscon_intern_t *intern)
+{
+    struct jscon_intern_block_s *block = intern->block;
+    while (NULL != block){
+        struct jscon_intern_block_s *next = block->next;
+        Jscon_free(block);
+        block = next;
+    }
+
+    Jscon_free(intern->slot);
+    Jscon_free(intern->hash);
+    Jscon_free(intern);
+}
+
+/* returns the pool copy of key, the same pointer given to every
+    item parsed with this pool that has a matching key */
+const char*
+jscon_intern(jscon_intern_t *intern, const char *key){
+    return Jscon_intern_key(intern, key, strlen(key));
+}
+
+size_t
+jscon_intern_size(jscon_intern_t *intern)
+{
+    _jscon_intern_lock(intern);
+    size_t num_key = intern->num_key;
+    _jscon_intern_unlock(intern);
+
+    return num_key;
+}
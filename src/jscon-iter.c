@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libjscon.h>
+#include "jscon-common.h"
+
+#include "debug.h"
+
+
+/* frames are kept inside the iterator, until the walk goes deeper
+    than JSCON_ITER_STACK */
+static inline struct jscon_iter_frame_s*
+_jscon_iter_frames(jscon_iter_t *iter){
+    return (NULL != iter->heap_stack) ? iter->heap_stack : iter->stack;
+}
+
+static void
+_jscon_iter_push(jscon_iter_t *iter, const jscon_item_t *item)
+{
+    if (JSCON_ITER_STACK == iter->depth && NULL == iter->heap_stack){
+        iter->capacity = 2 * JSCON_ITER_STACK;
+        iter->heap_stack = Jscon_malloc(iter->capacity * sizeof *iter->heap_stack, JSCON_ALLOC_OTHER);
+        DEBUG_ASSERT(NULL != iter->heap_stack, "Out of memory");
+
+        memcpy(iter->heap_stack, iter->stack, sizeof iter->stack);
+    }
+    else if (NULL != iter->heap_stack && iter->depth == iter->capacity){
+        iter->capacity *= 2;
+        struct jscon_iter_frame_s *tmp = Jscon_realloc(iter->heap_stack, iter->capacity * sizeof *iter->heap_stack, JSCON_ALLOC_OTHER);
+        DEBUG_ASSERT(NULL != tmp, "Out of memory");
+
+        iter->heap_stack = tmp;
+    }
+
+    struct jscon_iter_frame_s *frame = &_jscon_iter_frames(iter)[iter->depth++];
+    frame->item = item;
+    frame->branch = 0;
+}
+
+void
+jscon_iter_init(jscon_iter_t *iter, const jscon_item_t *root, enum jscon_iter_order order)
+{
+    iter->order = order;
+    iter->root = NULL;
+    iter->depth = 0;
+    iter->capacity = 0;
+    iter->heap_stack = NULL;
+
+    if (NULL == root) return;
+    if (JSCON_ITER_COMPOSITE == order && !IS_COMPOSITE(root)) return;
+
+    if (JSCON_ITER_POSTORDER == order || IS_COMPOSITE(root)){
+        _jscon_iter_push(iter, root);
+    }
+    if (JSCON_ITER_POSTORDER != order){
+        iter->root = root;
+    }
+}
+
+/* preorder walks return an item as soon as its met, and push it
+    if there are branches to be walked */
+static jscon_item_t*
+_jscon_iter_preorder(jscon_iter_t *iter)
+{
+    if (NULL != iter->root){
+        const jscon_item_t *root = iter->root;
+        iter->root = NULL;
+
+        return (jscon_item_t*)root;
+    }
+
+    while (iter->depth > 0){
+        struct jscon_iter_frame_s *frame = &_jscon_iter_frames(iter)[iter->depth-1];
+
+        /* packed elements are numbers, so there's no composite among
+            them to be returned */
+        if (frame->branch == jscon_size(frame->item)
+            || (JSCON_ITER_COMPOSITE == iter->order && IS_PACKED(frame->item)))
+        {
+            --iter->depth;
+            continue;
+        }
+
+        jscon_item_t *next_item = Jscon_array_element(frame->item, frame->branch++);
+        if (IS_COMPOSITE(next_item)){
+            _jscon_iter_push(iter, next_item);
+        }
+        else if (JSCON_ITER_COMPOSITE == iter->order){
+            continue;
+        }
+
+        return next_item;
+    }
+
+    return NULL;
+}
+
+/* postorder walks push every item met, and only return it once
+    all of its branches have been walked */
+static jscon_item_t*
+_jscon_iter_postorder(jscon_iter_t *iter)
+{
+    while (iter->depth > 0){
+        struct jscon_iter_frame_s *frame = &_jscon_iter_frames(iter)[iter->depth-1];
+        if (frame->branch < jscon_size(frame->item)){
+            _jscon_iter_push(iter, Jscon_array_element(frame->item, frame->branch++));
+            continue;
+        }
+
+        --iter->depth;
+        return (jscon_item_t*)frame->item;
+    }
+
+    return NULL;
+}
+
+/* returns next item in the iterator order, or NULL once the
+    whole tree has been walked */
+jscon_item_t*
+jscon_iter_step(jscon_iter_t *iter)
+{
+    switch (iter->order){
+    case JSCON_ITER_PREORDER:
+    case JSCON_ITER_COMPOSITE:
+        return _jscon_iter_preorder(iter);
+    case JSCON_ITER_POSTORDER:
+        return _jscon_iter_postorder(iter);
+    default:
+        DEBUG_ERR("Unknown iterator order: %d", iter->order);
+        abort();
+    }
+}
+
+/* only needed if the walk may have gone deeper than JSCON_ITER_STACK,
+    but always safe to call */
+void
+jscon_iter_destroy(jscon_iter_t *iter)
+{
+    Jscon_free(iter->heap_stack);
+    iter->heap_stack = NULL;
+    iter->depth = 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <libjscon.h>
+#include "jscon-common.h"
+
+#include "debug.h"
+
+
+/* object members sharing a key, in no particular order */
+struct jscon_keyindex_entry_s {
+    char *key; //NULL if entry is empty
+    uint64_t hash;
+    jscon_item_t **item;
+    size_t num_item;
+    size_t capacity;
+};
+
+/* JSCON KEY INDEX
+ * inverted index of a tree, from key to every object member with it.
+ * kept at root composite, and updated by jscon_append() and
+ * jscon_dettach() from then on
+ * entry: open addressing table of keys
+ * num_entry: table size, always a power of two
+ * num_key: distinct keys, the table is kept at most half full */
+struct jscon_keyindex_s {
+    struct jscon_keyindex_entry_s *entry;
+    size_t num_entry;
+    size_t num_key;
+};
+
+
+/* returns the entry where key is, or the empty entry where it
+    would be inserted */
+static struct jscon_keyindex_entry_s*
+_jscon_keyindex_find(const struct jscon_keyindex_s *keyindex, const char *key, uint64_t hash)
+{
+    const size_t mask = keyindex->num_entry-1;
+
+    size_t index = hash & mask;
+    while (NULL != keyindex->entry[index].key){
+        struct jscon_keyindex_entry_s *entry = &keyindex->entry[index];
+        if (hash == entry->hash && STREQ(key, entry->key)){
+            break;
+        }
+        index = (index+1) & mask;
+    }
+
+    return &keyindex->entry[index];
+}
+
+static void
+_jscon_keyindex_grow(struct jscon_keyindex_s *keyindex)
+{
+    struct jscon_keyindex_entry_s *old_entry = keyindex->entry;
+    const size_t old_num_entry = keyindex->num_entry;
+
+    keyindex->num_entry = (0 == old_num_entry) ? 16 : 2 * old_num_entry;
+    keyindex->entry = Jscon_calloc(keyindex->num_entry, sizeof *keyindex->entry, JSCON_ALLOC_HASHTABLE);
+    DEBUG_ASSERT(NULL != keyindex->entry, "Out of memory");
+
+    for (size_t i=0; i < old_num_entry; ++i){
+        if (NULL == old_entry[i].key) continue;
+
+        *_jscon_keyindex_find(keyindex, old_entry[i].key, old_entry[i].hash) = old_entry[i];
+    }
+    Jscon_free(old_entry);
+}
+
+static void
+_jscon_keyindex_insert(struct jscon_keyindex_s *keyindex, jscon_item_t *item)
+{
+    const size_t len = strlen(item->key);
+    const uint64_t hash = Jscon_strhash(item->key, len);
+
+    struct jscon_keyindex_entry_s *entry = _jscon_keyindex_find(keyindex, item->key, hash);
+    if (NULL == entry->key){
+        if (2 * (keyindex->num_key+1) > keyindex->num_entry){
+            _jscon_keyindex_grow(keyindex);
+            entry = _jscon_keyindex_find(keyindex, item->key, hash);
+        }
+
+        /* keys are copied, as items may be destroyed while their
+            entry remains */
+        entry->key = Jscon_strndup(item->key, len, JSCON_ALLOC_KEY);
+        DEBUG_ASSERT(NULL != entry->key, "Out of memory");
+        entry->hash = hash;
+        ++keyindex->num_key;
+    }
+
+    if (entry->num_item == entry->capacity){
+        entry->capacity = (0 == entry->capacity) ? 4 : 2 * entry->capacity;
+
+        void *tmp = Jscon_realloc(entry->item, entry->capacity * sizeof *entry->item, JSCON_ALLOC_HASHTABLE);
+        DEBUG_ASSERT(NULL != tmp, "Out of memory");
+        entry->item = tmp;
+    }
+    entry->item[entry->num_item++] = item;
+}
+
+static void
+_jscon_keyindex_erase(struct jscon_keyindex_s *keyindex, jscon_item_t *item)
+{
+    struct jscon_keyindex_entry_s *entry = _jscon_keyindex_find(keyindex, item->key, Jscon_strhash(item->key, strlen(item->key)));
+    DEBUG_ASSERT(NULL != entry->key, "Item is missing from key index");
+
+    for (size_t i=0; i < entry->num_item; ++i){
+        if (item == entry->item[i]){
+            entry->item[i] = entry->item[--entry->num_item];
+            return;
+        }
+    }
+
+    DEBUG_ERR("Item is missing from key index");
+    abort();
+}
+
+/* only object members are indexed, array elements keys are their
+    position, which is of no use to search for */
+static inline bool
+_jscon_keyindex_is_member(const jscon_item_t *item){
+    return NULL != item->parent && JSCON_OBJECT == item->parent->type;
+}
+
+/* index item and its branches */
+void
+Jscon_keyindex_add(struct jscon_keyindex_s *keyindex, jscon_item_t *item)
+{
+    jscon_iter_t iter;
+    jscon_iter_init(&iter, item, JSCON_ITER_PREORDER);
+
+    jscon_item_t *next_item;
+    while (NULL != (next_item = jscon_iter_step(&iter))){
+        if (_jscon_keyindex_is_member(next_item)){
+            _jscon_keyindex_insert(keyindex, next_item);
+        }
+    }
+
+    jscon_iter_destroy(&iter);
+}
+
+/* remove item and its branches, item must still be in the tree */
+void
+Jscon_keyindex_remove(struct jscon_keyindex_s *keyindex, jscon_item_t *item)
+{
+    jscon_iter_t iter;
+    jscon_iter_init(&iter, item, JSCON_ITER_PREORDER);
+
+    jscon_item_t *next_item;
+    while (NULL != (next_item = jscon_iter_step(&iter))){
+        if (_jscon_keyindex_is_member(next_item)){
+            _jscon_keyindex_erase(keyindex, next_item);
+        }
+    }
+
+    jscon_iter_destroy(&iter);
+}
+
+void
+Jscon_keyindex_destroy(struct jscon_keyindex_s *keyindex)
+{
+    if (NULL == keyindex) return;
+
+    for (size_t i=0; i < keyindex->num_entry; ++i){
+        Jscon_free(keyindex->entry[i].key);
+        Jscon_free(keyindex->entry[i].item);
+    }
+    Jscon_free(keyindex->entry);
+    Jscon_free(keyindex);
+}
+
+/* key index of the tree item belongs to, NULL if it has none */
+struct jscon_keyindex_s*
+Jscon_keyindex_get(jscon_item_t *item)
+{
+    jscon_item_t *root = jscon_get_root(item);
+    return IS_COMPOSITE(root) ? root->comp->keyindex : NULL;
+}
+
+/* every object member of root tree with the given key, in no
+    particular order. the index is built at the first call, and kept
+    up to date by jscon_append() and jscon_dettach() from then on. the
+    returned list is valid until the tree is next modified */
+jscon_item_t* const*
+jscon_find_all(jscon_item_t *root, const char *key, size_t *p_count)
+{
+    DEBUG_ASSERT(NULL != key, "Missing key");
+    DEBUG_ASSERT(NULL != p_count, "Missing count");
+
+    *p_count = 0;
+    root = jscon_get_root(root);
+    if (!IS_COMPOSITE(root)) return NULL;
+
+    DEBUG_ASSERT(!IS_READONLY(root), "Item is owned by a parser");
+
+    if (NULL == root->comp->keyindex){
+        struct jscon_keyindex_s *new_keyindex = Jscon_calloc(1, sizeof *new_keyindex, JSCON_ALLOC_HASHTABLE);
+        DEBUG_ASSERT(NULL != new_keyindex, "Out of memory");
+
+        _jscon_keyindex_grow(new_keyindex);
+        Jscon_keyindex_add(new_keyindex, root);
+
+        root->comp->keyindex = new_keyindex;
+    }
+
+    struct jscon_keyindex_entry_s *entry = _jscon_keyindex_find(root->comp->keyindex, key, Jscon_strhash(key, strlen(key)));
+    if (NULL == entry->key || 0 == entry->num_item) return NULL; //every item removed
+
+    *p_count = entry->num_item;
+    return entry->item;
+}
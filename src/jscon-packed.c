@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libjscon.h>
+#include "jscon-common.h"
+
+#include "debug.h"
+
+
+/* JSCON PACKED ARRAYS
+ * arrays made of numbers only are parsed straight into a flat array
+ * of long long (if all are integers) or double, stored in place of the
+ * composite branches, rather than into one item per element. reading
+ * an element as an item makes it once, alongside the packed numbers,
+ * so that the array is never changed by a read. the array is only
+ * turned into a regular one (unpacked) once it is modified */
+
+/* packs the array at *p_buffer if its elements are all numbers, the
+    new composite is returned and *p_buffer is moved past the array.
+    otherwise, NULL is returned and *p_buffer is left untouched */
+jscon_composite_t*
+Jscon_packed_decode(char **p_buffer)
+{
+    const char *end;
+    const size_t num_element = Jscon_count_number_array(*p_buffer, &end);
+    if (0 == num_element) return NULL;
+
+    jscon_composite_t *new_comp = Jscon_calloc(1, sizeof *new_comp + num_element * sizeof(double), JSCON_ALLOC_NODE);
+    DEBUG_ASSERT(NULL != new_comp, "Out of memory");
+
+    double *d_number = PACKED_DOUBLE(new_comp);
+    char *next = Jscon_decode_number_array(*p_buffer, end, num_element, d_number);
+    if (NULL == next){ //not a well formed array, left for the parser
+        Jscon_free(new_comp);
+        return NULL;
+    }
+
+    /* elements are typed the same as they would be as items */
+    bool is_integer = true;
+    for (size_t i=0; i < num_element && is_integer; ++i){
+        is_integer = DOUBLE_IS_INTEGER(d_number[i]);
+    }
+
+    if (is_integer){
+        long long *i_number = PACKED_INTEGER(new_comp);
+        for (size_t i=0; i < num_element; ++i){
+            i_number[i] = (long long)d_number[i];
+        }
+    }
+
+    new_comp->packed = is_integer ? JSCON_INTEGER : JSCON_DOUBLE;
+    new_comp->num_packed = num_element;
+
+    *p_buffer = next;
+
+    return new_comp;
+}
+
+/* copy of a packed composite, not yet linked to any tree */
+jscon_composite_t*
+Jscon_packed_copy(const jscon_composite_t *comp)
+{
+    DEBUG_ASSERT(0 != comp->packed, "Composite isn't packed");
+
+    jscon_composite_t *new_comp = Jscon_calloc(1, sizeof *new_comp + comp->num_packed * sizeof(double), JSCON_ALLOC_NODE);
+    if (NULL == new_comp) return NULL;
+
+    memcpy(new_comp->branch, comp->branch, comp->num_packed * sizeof(double));
+    new_comp->packed = comp->packed;
+    new_comp->num_packed = comp->num_packed;
+
+    return new_comp;
+}
+
+/* item of the packed element at index, typed as it would be parsed */
+static jscon_item_t*
+_jscon_packed_item(const jscon_item_t *item, size_t index)
+{
+    const jscon_composite_t *comp = item->comp;
+
+    char numerical_key[32];
+    size_t len = Jscon_encode_integer((long long)index, numerical_key);
+
+    jscon_item_t *new_item = Jscon_item_init(numerical_key, len, NULL, 0);
+    if (NULL == new_item) return NULL;
+
+    double d_number = 0.0;
+    if (JSCON_DOUBLE == comp->packed){
+        d_number = PACKED_DOUBLE(comp)[index];
+    }
+
+    if (JSCON_INTEGER == comp->packed){
+        new_item->type = JSCON_INTEGER;
+        new_item->i_number = PACKED_INTEGER(comp)[index];
+    }
+    else if (DOUBLE_IS_INTEGER(d_number)){
+        new_item->type = JSCON_INTEGER;
+        new_item->i_number = (long long)d_number;
+    }
+    else {
+        new_item->type = JSCON_DOUBLE;
+        new_item->d_number = d_number;
+    }
+
+    new_item->parent = (jscon_item_t*)item;
+
+    return new_item;
+}
+
+static void
+_jscon_packed_element_destroy(jscon_item_t **element, size_t num_element)
+{
+    for (size_t i=0; i < num_element; ++i){
+        if (NULL == element[i]) continue;
+
+        Jscon_item_free_key(element[i]);
+        Jscon_free(element[i]);
+    }
+    Jscon_free(element);
+}
+
+/* frees the items made of a packed composite elements, if any */
+void
+Jscon_packed_destroy(jscon_composite_t *comp)
+{
+    if (NULL == comp->element) return;
+
+    _jscon_packed_element_destroy(comp->element, comp->num_packed);
+    comp->element = NULL;
+}
+
+/* branch of item at index, or NULL if out of bounds. a packed element
+    is made into an item the first time it is read, and kept alongside
+    the packed numbers. each element slot is set by the first reader to
+    get there, others that race it discard theirs, so that readers may
+    share the array with no locks */
+jscon_item_t*
+Jscon_array_element(const jscon_item_t *item, size_t index)
+{
+    DEBUG_ASSERT(IS_COMPOSITE(item), "Item is not an Object or Array");
+
+    jscon_composite_t *comp = item->comp;
+    if (!IS_PACKED(item)){
+        return (index < comp->num_branch) ? comp->branch[index] : NULL;
+    }
+    if (index >= comp->num_packed) return NULL;
+
+    jscon_item_t **element = __atomic_load_n(&comp->element, __ATOMIC_ACQUIRE);
+    if (NULL == element){
+        jscon_item_t **new_element = Jscon_calloc(comp->num_packed, sizeof *new_element, JSCON_ALLOC_NODE);
+        DEBUG_ASSERT(NULL != new_element, "Out of memory");
+
+        if (__atomic_compare_exchange_n(&comp->element, &element, new_element, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+            element = new_element;
+        }
+        else {
+            Jscon_free(new_element);
+        }
+    }
+
+    jscon_item_t *element_item = __atomic_load_n(&element[index], __ATOMIC_ACQUIRE);
+    if (NULL != element_item) return element_item;
+
+    jscon_item_t *new_item = _jscon_packed_item(item, index);
+    DEBUG_ASSERT(NULL != new_item, "Out of memory");
+
+    if (!__atomic_compare_exchange_n(&element[index], &element_item, new_item, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+        Jscon_item_free_key(new_item);
+        Jscon_free(new_item);
+        return element_item;
+    }
+
+    return new_item;
+}
+
+/* turn the packed elements of item into branches, the array is left
+    as if it had been parsed without packing. items already made of
+    the elements become the branches, so that they stay valid. does
+    nothing if item isn't a packed array */
+void
+Jscon_array_unpack(jscon_item_t *item)
+{
+    if (!IS_PACKED(item)) return;
+
+    jscon_composite_t *comp = item->comp;
+    jscon_composite_t *new_comp = Jscon_composite_init(comp->num_packed);
+    DEBUG_ASSERT(NULL != new_comp, "Out of memory");
+
+    /* keeps its place at the tree */
+    new_comp->last_accessed_branch = comp->last_accessed_branch;
+    new_comp->next = comp->next;
+    new_comp->prev = comp->prev;
+    new_comp->keyindex = comp->keyindex;
+    new_comp->index = comp->index;
+    new_comp->hash = comp->hash;
+
+    for (size_t i=0; i < comp->num_packed; ++i){
+        jscon_item_t *new_branch = (NULL != comp->element && NULL != comp->element[i])
+                                        ? comp->element[i]
+                                        : _jscon_packed_item(item, i);
+        DEBUG_ASSERT(NULL != new_branch, "Out of memory");
+
+        new_comp->branch[i] = new_branch;
+    }
+    new_comp->num_branch = comp->num_packed;
+
+    item->comp = new_comp;
+    Jscon_composite_build(item);
+
+    Jscon_free(comp->element);
+    Jscon_free(comp);
+}
+
+/* packed elements of an array of integers, and their amount at
+    p_size. returns NULL if item isn't a packed array of integers */
+const long long*
+jscon_get_int_array(const jscon_item_t *item, size_t *p_size)
+{
+    if (NULL == item || JSCON_ARRAY != item->type || JSCON_INTEGER != item->comp->packed){
+        *p_size = 0;
+        return NULL;
+    }
+
+    *p_size = item->comp->num_packed;
+    return PACKED_INTEGER(item->comp);
+}
+
+/* packed elements of an array of doubles, and their amount at
+    p_size. returns NULL if item isn't a packed array of doubles */
+const double*
+jscon_get_double_array(const jscon_item_t *item, size_t *p_size)
+{
+    if (NULL == item || JSCON_ARRAY != item->type || JSCON_DOUBLE != item->comp->packed){
+        *p_size = 0;
+        return NULL;
+    }
+
+    *p_size = item->comp->num_packed;
+    return PACKED_DOUBLE(item->comp);
+}
@@ -34,9 +34,32 @@
 
 struct jscon_utils_s {
     char *buffer;
-    char *key; //holds key ptr to be received by item
-    jscon_composite_t *last_accessed_comp; //holds last composite accessed
+    char *key; //holds key text to be copied by item (not nul terminated)
+    size_t key_len; //key text length
+    char *string; //holds string value to be copied by item, if any
+    size_t string_len; //string value length
+    jscon_item_t *last_accessed; //holds last composite item accessed
     jscon_cb *parse_cb; //parser callback
+    size_t depth; //current composite nesting depth
+    size_t max_depth; //nesting depth limit
+    bool too_deep; //max_depth was exceeded, parsing stops
+    unsigned int flags; //flags given to every item created
+    jscon_intern_t *intern; //pool keys are taken from, if any
+    bool pack; //arrays of numbers are packed (check jscon-packed.c)
+};
+
+/* JSCON PARSER CONTEXT
+ * owns settings and memory for consecutive parses, two parsers share
+ * no mutable state, and may be used concurrently at different threads
+ * parse_cb: callback called for every item created
+ * max_depth: composite nesting limit
+ * intern: pool that item keys are taken from (NULL if none)
+ * arena: memory for every item tree parsed, recycled at reset */
+struct jscon_parser_s {
+    jscon_cb *parse_cb;
+    size_t max_depth;
+    jscon_intern_t *intern;
+    struct jscon_arena_s arena;
 };
 
 /* function pointers used while building json items, 
@@ -45,38 +68,40 @@ struct jscon_utils_s {
 typedef void (jscon_create_value)(jscon_item_t *item, struct jscon_utils_s *utils);
 typedef jscon_item_t* (jscon_create_item)(jscon_item_t*, struct jscon_utils_s*, jscon_create_value*);
 
+/* create a new branch to current jscon object item, and return
+    the new branch address. the key and string value held by utils
+    are copied along with it, unless the key is to be interned */
 static jscon_item_t*
-_jscon_item_init()
+_jscon_branch_init(jscon_item_t *item, struct jscon_utils_s *utils)
 {
-    jscon_item_t *new_item = calloc(1, sizeof *new_item);
-    DEBUG_ASSERT(NULL != new_item, "Out of memory");
+    DEBUG_ASSERT(item->comp->num_branch < item->comp->capacity, "Branches exceed amount counted");
 
-    return new_item;
-}
+    const char *key = (NULL == utils->intern) ? utils->key : NULL;
 
-/* create a new branch to current jscon object item, and return
-    the new branch address */
-static jscon_item_t*
-_jscon_branch_init(jscon_item_t *item)
-{
-    ++item->comp->num_branch;
+    jscon_item_t *new_branch = Jscon_item_init(key, utils->key_len, utils->string, utils->string_len);
+    DEBUG_ASSERT(NULL != new_branch, "Out of memory");
 
-    item->comp->branch[item->comp->num_branch-1] = _jscon_item_init();
+    if (NULL != utils->intern){
+        new_branch->key = Jscon_intern_key(utils->intern, utils->key, utils->key_len);
+        DEBUG_ASSERT(NULL != new_branch->key, "Out of memory");
+    }
+    utils->key = NULL;
 
-    item->comp->branch[item->comp->num_branch-1]->parent = item;
+    new_branch->parent = item;
+    new_branch->flags |= item->flags & JSCON_ITEM_ARENA;
 
-    return item->comp->branch[item->comp->num_branch-1];
+    item->comp->branch[item->comp->num_branch++] = new_branch;
+
+    return new_branch;
 }
 
 static void
 _jscon_composite_destroy(jscon_item_t *item)
 {
-    hashtable_destroy(item->comp->hashtable);
-
-    free(item->comp->branch);
-    item->comp->branch = NULL;
-
-    free(item->comp);
+    Jscon_keyindex_destroy(item->comp->keyindex);
+    Jscon_index_destroy(item->comp->index);
+    Jscon_packed_destroy(item->comp);
+    Jscon_free(item->comp);
     item->comp = NULL;
 }
 
@@ -92,32 +117,41 @@ _jscon_destroy_preorder(jscon_item_t *item)
         _jscon_composite_destroy(item);
         break;
     case JSCON_STRING:
-        free(item->string);
-        item->string = NULL;
+        Jscon_item_free_string(item);
         break;
     default:
         break;
     }
 
-    free(item->key);
-    item->key = NULL;
+    Jscon_item_free_key(item);
 
-    free(item);
+    Jscon_free(item);
     item = NULL;
 }
 
-/* destroy current item and all of its nested object/arrays */
+/* destroy current item and all of its nested object/arrays,
+    items owned by a jscon_parser_t are released at its reset instead */
 void
 jscon_destroy(jscon_item_t *item){
+    if (IS_READONLY(item)) return;
+
     _jscon_destroy_preorder(jscon_get_root(item));
 }
 
-/* fetch string type jscon and return allocated string */
+/* fetch string type jscon, branches have it copied already when
+    created, so it only needs to be decoded for a root item */
 static void
 _jscon_value_set_string(jscon_item_t *item, struct jscon_utils_s *utils)
 {
     item->type = JSCON_STRING;
-    item->string = Jscon_decode_string(&utils->buffer);
+
+    if (NULL == utils->string){
+        size_t len;
+        char *start = Jscon_decode_string_inplace(&utils->buffer, &len);
+        Jscon_item_set_string(item, start, len);
+        DEBUG_ASSERT(NULL != item->string, "Out of memory");
+    }
+    utils->string = NULL;
 }
 
 /* fetch number jscon type by parsing string,
@@ -194,10 +228,17 @@ _jscon_count_property(char *buffer)
 static void
 _jscon_value_set_object(jscon_item_t *item, struct jscon_utils_s *utils)
 {
+    if (++utils->depth > utils->max_depth){
+        /* item is left as a null, so that the tree can be destroyed */
+        item->type = JSCON_NULL;
+        utils->too_deep = true;
+        return;
+    }
+
     item->type = JSCON_OBJECT;
 
     item->comp = Jscon_decode_composite(&utils->buffer, _jscon_count_property(utils->buffer));
-    Jscon_composite_link_r(item, &utils->last_accessed_comp);
+    Jscon_composite_link_r(item, &utils->last_accessed);
 }
 
 inline static size_t
@@ -245,10 +286,26 @@ _jscon_count_element(char *buffer)
 static void
 _jscon_value_set_array(jscon_item_t *item, struct jscon_utils_s *utils)
 {
+    if (++utils->depth > utils->max_depth){
+        /* item is left as a null, so that the tree can be destroyed */
+        item->type = JSCON_NULL;
+        utils->too_deep = true;
+        return;
+    }
+
     item->type = JSCON_ARRAY;
 
+    if (utils->pack){
+        item->comp = Jscon_packed_decode(&utils->buffer);
+        if (NULL != item->comp){ //already wrapped
+            --utils->depth;
+            Jscon_composite_link_r(item, &utils->last_accessed);
+            return;
+        }
+    }
+
     item->comp = Jscon_decode_composite(&utils->buffer, _jscon_count_element(utils->buffer));
-    Jscon_composite_link_r(item, &utils->last_accessed_comp);
+    Jscon_composite_link_r(item, &utils->last_accessed);
 }
 
 /* create nested composite type (object/array) and return 
@@ -256,13 +313,16 @@ _jscon_value_set_array(jscon_item_t *item, struct jscon_utils_s *utils)
 static jscon_item_t*
 _jscon_composite_init(jscon_item_t *item, struct jscon_utils_s *utils, jscon_create_value *value_setter)
 {
-    item = _jscon_branch_init(item);
-    item->key = utils->key;
-    utils->key = NULL;
+    item = _jscon_branch_init(item, utils);
 
     (*value_setter)(item, utils);
+    if (utils->too_deep) return NULL; //stops building
+
     item = (utils->parse_cb)(item);
 
+    /* a packed array has no branches to be built */
+    if (IS_PACKED(item)) return item->parent;
+
     return item;
 }
 
@@ -272,6 +332,7 @@ static jscon_item_t*
 _jscon_wrap_composite(jscon_item_t *item, struct jscon_utils_s *utils)
 {
     ++utils->buffer; //skips '}' or ']'
+    --utils->depth;
     Jscon_composite_build(item);
     return item->parent;
 }
@@ -280,9 +341,7 @@ _jscon_wrap_composite(jscon_item_t *item, struct jscon_utils_s *utils)
 static jscon_item_t*
 _jscon_append_primitive(jscon_item_t *item, struct jscon_utils_s *utils, jscon_create_value *value_setter)
 {
-    item = _jscon_branch_init(item);
-    item->key = utils->key;
-    utils->key = NULL;
+    item = _jscon_branch_init(item, utils);
 
     (*value_setter)(item, utils);
     item = (utils->parse_cb)(item);
@@ -308,6 +367,7 @@ _jscon_branch_build(jscon_item_t *item, struct jscon_utils_s *utils)
         value_setter = &_jscon_value_set_array;
         break;
     case '\"':/*STRING DETECTED*/
+        utils->string = Jscon_decode_string_inplace(&utils->buffer, &utils->string_len);
         item_setter = &_jscon_append_primitive;
         value_setter = &_jscon_value_set_string;
         break;
@@ -364,9 +424,9 @@ _jscon_array_build(jscon_item_t *item, struct jscon_utils_s *utils)
         char numerical_key[MAX_DIGITS];
         snprintf(numerical_key, MAX_DIGITS-1, "%ld", item->comp->num_branch);
 
-        DEBUG_ASSERT(NULL == utils->key, "utils->key wasn't freed");
-        utils->key = strdup(numerical_key);
-        DEBUG_ASSERT(NULL != utils->key, "Out of memory");
+        DEBUG_ASSERT(NULL == utils->key, "utils->key wasn't received");
+        utils->key = numerical_key;
+        utils->key_len = strlen(numerical_key);
 
         return _jscon_branch_build(item, utils);
      }
@@ -390,8 +450,8 @@ _jscon_object_build(jscon_item_t *item, struct jscon_utils_s *utils)
         CONSUME_BLANK_CHARS(utils->buffer);
     /* fall through */
     case '\"':/*KEY STRING DETECTED*/
-        DEBUG_ASSERT(NULL == utils->key, "utils->key wasn't freed");
-        utils->key = Jscon_decode_string(&utils->buffer);
+        DEBUG_ASSERT(NULL == utils->key, "utils->key wasn't received");
+        utils->key = Jscon_decode_string_inplace(&utils->buffer, &utils->key_len);
         DEBUG_ASSERT(':' == *utils->buffer, "Missing ':' token after key"); //check for key's assign token 
         ++utils->buffer; //skips ':'
         CONSUME_BLANK_CHARS(utils->buffer);
@@ -456,46 +516,48 @@ _jscon_default_callback(jscon_item_t *item){
     return item;
 }
 
+static jscon_cb *_jscon_parse_cb = &_jscon_default_callback;
+
+/* installs new_cb as the jscon_parse() callback, NULL restores the
+    default one. returns the callback previously installed, so that
+    it can be restored later */
 jscon_cb*
 jscon_parse_cb(jscon_cb *new_cb)
 {
-    jscon_cb *parse_cb = &_jscon_default_callback;
+    jscon_cb *old_cb = _jscon_parse_cb;
+    _jscon_parse_cb = (NULL != new_cb) ? new_cb : &_jscon_default_callback;
 
-    if (NULL != new_cb){
-        parse_cb = new_cb;
-    }
-
-    return parse_cb;
+    return old_cb;
 }
 
-/* parse contents from buffer into a jscon item object
-    and return its root */
-jscon_item_t*
-jscon_parse(char *buffer)
+/* parse contents from utils->buffer into a jscon item object
+    and return its root, with settings given by utils */
+static jscon_item_t*
+_jscon_parse(struct jscon_utils_s *utils)
 {
-    jscon_item_t *root = calloc(1, sizeof *root);
+    jscon_item_t *root = Jscon_item_init(NULL, 0, NULL, 0);
     if (NULL == root) return NULL;
 
-    struct jscon_utils_s utils = {
-        .buffer = buffer,
-        .parse_cb = jscon_parse_cb(NULL),
-    };
+    root->flags = utils->flags;
     
     //build while item and buffer aren't nulled
     jscon_item_t *item = root;
-    while ((NULL != item) && ('\0' != *utils.buffer)){
+    while ((NULL != item) && ('\0' != *utils->buffer)){
         switch(item->type){
         case JSCON_OBJECT:
-            item = _jscon_object_build(item, &utils);
+            item = _jscon_object_build(item, utils);
             break;
         case JSCON_ARRAY:
-            item = _jscon_array_build(item, &utils);
+            item = _jscon_array_build(item, utils);
             break;
         case JSCON_UNDEFINED:
             /* this should be true only at the first iteration */
-            item = _jscon_entity_build(item, &utils);
-            if (IS_PRIMITIVE(item)) return item;
-
+            item = _jscon_entity_build(item, utils);
+            if (utils->too_deep){
+                item = NULL;
+            } else if (IS_PRIMITIVE(item) || IS_PACKED(item)){
+                return item;
+            }
             break;
         default:
             DEBUG_ERR("Unknown item->type found\n\t"
@@ -503,5 +565,107 @@ jscon_parse(char *buffer)
         }
     }
 
+    /* nesting limit exceeded, the partial tree is discarded */
+    if (utils->too_deep){
+        jscon_destroy(root);
+        return NULL;
+    }
+
+    return root;
+}
+
+/* parse contents from buffer into a jscon item object
+    and return its root */
+jscon_item_t*
+jscon_parse(char *buffer)
+{
+    struct jscon_utils_s utils = {
+        .buffer = buffer,
+        .parse_cb = _jscon_parse_cb,
+        .max_depth = SIZE_MAX, //no limit
+        /* callbacks expect to be given every item created */
+        .pack = (&_jscon_default_callback == _jscon_parse_cb),
+    };
+
+    return _jscon_parse(&utils);
+}
+
+jscon_parser_t*
+jscon_parser_init()
+{
+    jscon_parser_t *new_parser = Jscon_calloc(1, sizeof *new_parser, JSCON_ALLOC_OTHER);
+    if (NULL == new_parser) return NULL;
+
+    new_parser->parse_cb = &_jscon_default_callback;
+    new_parser->max_depth = MAX_DEPTH;
+
+    return new_parser;
+}
+
+void
+jscon_parser_destroy(jscon_parser_t *parser)
+{
+    Jscon_arena_destroy(&parser->arena);
+    Jscon_free(parser);
+}
+
+/* release every item parsed so far at once, their memory
+    is kept by the parser for the next parses */
+void
+jscon_parser_reset(jscon_parser_t *parser){
+    Jscon_arena_reset(&parser->arena);
+}
+
+/* installs new_cb as the parser callback, NULL restores the default
+    one. returns the callback previously installed */
+jscon_cb*
+jscon_parser_set_cb(jscon_parser_t *parser, jscon_cb *new_cb)
+{
+    jscon_cb *old_cb = parser->parse_cb;
+    parser->parse_cb = (NULL != new_cb) ? new_cb : &_jscon_default_callback;
+
+    return old_cb;
+}
+
+/* parser memory is taken from allocator, or from the global one
+    if NULL. every item parsed so far is released */
+void
+jscon_parser_set_allocator(jscon_parser_t *parser, const jscon_allocator_t *allocator)
+{
+    Jscon_arena_destroy(&parser->arena);
+    parser->arena.allocator = allocator;
+}
+
+/* keys of items parsed from now on are taken from intern, or
+    copied to the parser memory if NULL. the pool must outlive them */
+void
+jscon_parser_set_intern(jscon_parser_t *parser, jscon_intern_t *intern){
+    parser->intern = intern;
+}
+
+/* documents nested deeper than max_depth aren't parsed, and
+    jscon_parser_parse() returns NULL for them instead */
+void
+jscon_parser_set_max_depth(jscon_parser_t *parser, size_t max_depth){
+    parser->max_depth = max_depth;
+}
+
+/* parse contents from buffer into a jscon item object owned by
+    the parser, the item is valid until the next parser reset */
+jscon_item_t*
+jscon_parser_parse(jscon_parser_t *parser, char *buffer)
+{
+    struct jscon_utils_s utils = {
+        .buffer = buffer,
+        .parse_cb = parser->parse_cb,
+        .max_depth = parser->max_depth,
+        .flags = JSCON_ITEM_ARENA,
+        .intern = parser->intern,
+    };
+
+    struct jscon_arena_s *prev = Jscon_arena_swap(&parser->arena);
+    jscon_item_t *root = _jscon_parse(&utils);
+    Jscon_arena_swap(prev);
+
     return root;
 }
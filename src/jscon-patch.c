@@ -0,0 +1,577 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <libjscon.h>
+#include "jscon-common.h"
+
+#include "debug.h"
+
+
+struct jscon_patch_list_s {
+    jscon_item_t **item;
+    size_t num_item;
+    size_t capacity;
+};
+
+/* JSCON PATCH UTILITY STRUCTURE
+ * p_root: the tree being patched, its root may be replaced
+ * token: last decoded JSON Pointer reference token
+ * token_size: token allocated size
+ * touched: composites whose key index went stale, to be remade once
+ *      all operations are applied. arrays have their elements keys
+ *      renumbered along with it
+ * garbage: items removed from the tree, destroyed once done, as they
+ *      may hold touched composites */
+struct jscon_utils_s {
+    jscon_item_t **p_root;
+    char *token;
+    size_t token_size;
+    struct jscon_patch_list_s touched;
+    struct jscon_patch_list_s garbage;
+};
+
+static void
+_jscon_patch_list_push(struct jscon_patch_list_s *list, jscon_item_t *item)
+{
+    if (list->num_item == list->capacity){
+        list->capacity = (0 == list->capacity) ? 16 : 2 * list->capacity;
+        list->item = Jscon_realloc(list->item, list->capacity * sizeof *list->item, JSCON_ALLOC_OTHER);
+        DEBUG_ASSERT(NULL != list->item, "Out of memory");
+    }
+    list->item[list->num_item++] = item;
+}
+
+static void
+_jscon_patch_set_key(jscon_item_t *item, const char *key)
+{
+    char *new_key = Jscon_item_set_key(item, key, strlen(key));
+    DEBUG_ASSERT(NULL != new_key, "Out of memory");
+}
+
+static void
+_jscon_patch_set_index_key(jscon_item_t *item, size_t index)
+{
+    char numerical_key[32];
+    Jscon_encode_integer((long long)index, numerical_key);
+
+    if (NULL == item->key || !STREQ(numerical_key, item->key)){
+        _jscon_patch_set_key(item, numerical_key);
+    }
+}
+
+/* insert item at parent position index. the parent key index may
+    go stale, in which case it is remade only once done */
+static void
+_jscon_patch_insert(struct jscon_utils_s *utils, jscon_item_t *parent, jscon_item_t *item, size_t index)
+{
+    if (JSCON_ARRAY == parent->type){
+        _jscon_patch_set_index_key(item, index);
+    }
+
+    const bool was_stale = parent->comp->stale;
+
+    jscon_item_t *ret = Jscon_branch_insert(parent, item, index);
+    DEBUG_ASSERT(NULL != ret, "Out of memory");
+
+    if (!was_stale && parent->comp->stale){
+        _jscon_patch_list_push(&utils->touched, parent);
+    }
+}
+
+static void
+_jscon_patch_remove(struct jscon_utils_s *utils, jscon_item_t *item)
+{
+    jscon_item_t *parent = item->parent;
+    const bool was_stale = parent->comp->stale;
+
+    Jscon_branch_remove(item);
+
+    if (!was_stale && parent->comp->stale){
+        _jscon_patch_list_push(&utils->touched, parent);
+    }
+}
+
+static size_t
+_jscon_patch_position(const jscon_item_t *parent, const jscon_item_t *item)
+{
+    size_t index = parent->comp->num_branch;
+    while (parent->comp->branch[index-1] != item){
+        --index;
+    }
+
+    return index-1;
+}
+
+/* overwrite primitive item with a primitive value, item stays where
+    it is so that its parent needs no change */
+static void
+_jscon_patch_assign(jscon_item_t *item, const jscon_item_t *value)
+{
+    if (NULL != item->parent){
+        Jscon_index_unlink(item->parent);
+    }
+
+    if (JSCON_STRING == item->type){
+        Jscon_item_free_string(item);
+    }
+
+    switch (value->type){
+    case JSCON_STRING:
+        item->string = NULL;
+        if (NULL == Jscon_item_set_string(item, value->string, strlen(value->string))){
+            DEBUG_ERR("Out of memory");
+        }
+        break;
+    case JSCON_BOOLEAN:
+        item->boolean = value->boolean;
+        break;
+    case JSCON_INTEGER:
+        item->i_number = value->i_number;
+        break;
+    case JSCON_DOUBLE:
+        item->d_number = value->d_number;
+        break;
+    default:
+        break;
+    }
+    item->type = value->type;
+
+    if (NULL != item->parent){
+        Jscon_index_link(item->parent);
+        Jscon_hash_invalidate(item->parent);
+    }
+}
+
+/* item takes the place of target, which is removed */
+static void
+_jscon_patch_replace(struct jscon_utils_s *utils, jscon_item_t *target, jscon_item_t *item)
+{
+    if (IS_PRIMITIVE(target) && IS_PRIMITIVE(item)){
+        _jscon_patch_assign(target, item);
+        jscon_destroy(item);
+        return;
+    }
+
+    jscon_item_t *parent = target->parent;
+    if (NULL == parent){
+        Jscon_item_free_key(item);
+        *utils->p_root = item;
+        _jscon_patch_list_push(&utils->garbage, target);
+        return;
+    }
+
+    const size_t index = _jscon_patch_position(parent, target);
+    if (JSCON_OBJECT == parent->type){
+        _jscon_patch_set_key(item, target->key);
+    }
+
+    _jscon_patch_remove(utils, target);
+    _jscon_patch_list_push(&utils->garbage, target);
+
+    _jscon_patch_insert(utils, parent, item, index);
+}
+
+/* remake the key index of touched composites, and destroy removed
+    items */
+static void
+_jscon_patch_finish(struct jscon_utils_s *utils)
+{
+    for (size_t i=0; i < utils->touched.num_item; ++i){
+        jscon_item_t *item = utils->touched.item[i];
+
+        if (JSCON_ARRAY == item->type){
+            for (size_t j=0; j < item->comp->num_branch; ++j){
+                _jscon_patch_set_index_key(item->comp->branch[j], j);
+            }
+        }
+        Jscon_composite_remake(item);
+    }
+    for (size_t i=0; i < utils->garbage.num_item; ++i){
+        jscon_destroy(utils->garbage.item[i]);
+    }
+
+    Jscon_free(utils->touched.item);
+    Jscon_free(utils->garbage.item);
+    Jscon_free(utils->token);
+}
+
+/* array index token, digits only and without leading zeroes */
+static bool
+_jscon_patch_index(const char *token, size_t *p_index)
+{
+    if (!isdigit((unsigned char)*token)) return false;
+    if ('0' == *token && '\0' != token[1]) return false;
+
+    size_t index = 0;
+    for ( ; '\0' != *token; ++token){
+        if (!isdigit((unsigned char)*token)) return false;
+        if (index > (SIZE_MAX - 9) / 10) return false;
+        index = 10 * index + (*token - '0');
+    }
+    *p_index = index;
+
+    return true;
+}
+
+/* parent branch referred by token, the root if parent is NULL */
+static jscon_item_t*
+_jscon_patch_child(struct jscon_utils_s *utils, jscon_item_t *parent, const char *token)
+{
+    if (NULL == parent) return *utils->p_root;
+
+    if (JSCON_OBJECT == parent->type){
+        return Jscon_composite_get(token, parent);
+    }
+
+    Jscon_array_unpack(parent);
+
+    size_t index;
+    if (!_jscon_patch_index(token, &index) || index >= parent->comp->num_branch){
+        return NULL;
+    }
+
+    return parent->comp->branch[index];
+}
+
+/* decodes pointer next reference token into utils->token */
+static const char*
+_jscon_patch_token(struct jscon_utils_s *utils, const char *pointer)
+{
+    DEBUG_ASSERT('/' == *pointer, "Not a reference token");
+    ++pointer;
+
+    size_t len = strcspn(pointer, "/");
+    if (len + 1 > utils->token_size){
+        utils->token_size = 2 * (len + 1);
+        utils->token = Jscon_realloc(utils->token, utils->token_size, JSCON_ALLOC_OTHER);
+        DEBUG_ASSERT(NULL != utils->token, "Out of memory");
+    }
+
+    char *p = utils->token;
+    for (const char *end = pointer + len; pointer < end; ++pointer){
+        if ('~' == *pointer && '0' == pointer[1]){
+            *p++ = '~';
+            ++pointer;
+        }
+        else if ('~' == *pointer && '1' == pointer[1]){
+            *p++ = '/';
+            ++pointer;
+        }
+        else {
+            *p++ = *pointer;
+        }
+    }
+    *p = '\0';
+
+    return pointer;
+}
+
+/* finds the composite that pointer last reference token (decoded to
+    utils->token) refers to. for the "" pointer, which refers to the
+    root, the composite is NULL */
+static bool
+_jscon_patch_locate(struct jscon_utils_s *utils, const char *pointer, jscon_item_t **p_parent)
+{
+    *p_parent = NULL;
+    if ('\0' == *pointer) return true;
+    if ('/' != *pointer) return false;
+
+    jscon_item_t *item = *utils->p_root;
+    while (true){
+        pointer = _jscon_patch_token(utils, pointer);
+        if ('\0' == *pointer) break;
+
+        if (!IS_COMPOSITE(item)) return false;
+        item = _jscon_patch_child(utils, item, utils->token);
+        if (NULL == item) return false;
+    }
+    if (!IS_COMPOSITE(item)) return false;
+
+    *p_parent = item;
+
+    return true;
+}
+
+/* add item at parent, as referred by utils->token */
+static bool
+_jscon_patch_add(struct jscon_utils_s *utils, jscon_item_t *parent, jscon_item_t *item)
+{
+    if (NULL == parent){
+        _jscon_patch_replace(utils, *utils->p_root, item);
+        return true;
+    }
+
+    if (JSCON_OBJECT == parent->type){
+        jscon_item_t *member = Jscon_composite_get(utils->token, parent);
+        if (NULL != member){
+            _jscon_patch_replace(utils, member, item);
+        }
+        else {
+            _jscon_patch_set_key(item, utils->token);
+            _jscon_patch_insert(utils, parent, item, parent->comp->num_branch);
+        }
+        return true;
+    }
+
+    Jscon_array_unpack(parent);
+
+    size_t index;
+    if (STREQ("-", utils->token)){
+        index = parent->comp->num_branch;
+    }
+    else if (!_jscon_patch_index(utils->token, &index) || index > parent->comp->num_branch){
+        return false;
+    }
+    _jscon_patch_insert(utils, parent, item, index);
+
+    return true;
+}
+
+static jscon_item_t*
+_jscon_patch_member(jscon_item_t *operation, const char *key, enum jscon_type type)
+{
+    jscon_item_t *member = Jscon_composite_get(key, operation);
+    return (NULL != member && jscon_typecmp(member, type)) ? member : NULL;
+}
+
+/* apply a single operation, return false if it can't be */
+static bool
+_jscon_patch_apply(struct jscon_utils_s *utils, jscon_item_t *operation)
+{
+    if (JSCON_OBJECT != operation->type) return false;
+
+    jscon_item_t *op = _jscon_patch_member(operation, "op", JSCON_STRING);
+    jscon_item_t *path = _jscon_patch_member(operation, "path", JSCON_STRING);
+    jscon_item_t *value = _jscon_patch_member(operation, "value", JSCON_ANY);
+    jscon_item_t *from = _jscon_patch_member(operation, "from", JSCON_STRING);
+    if (NULL == op || NULL == path) return false;
+
+    jscon_item_t *parent, *target, *item;
+    if (STREQ("add", op->string)){
+        if (NULL == value) return false;
+        if (!_jscon_patch_locate(utils, path->string, &parent)) return false;
+
+        item = Jscon_item_copy(value, NULL);
+        DEBUG_ASSERT(NULL != item, "Out of memory");
+
+        if (!_jscon_patch_add(utils, parent, item)){
+            jscon_destroy(item);
+            return false;
+        }
+        return true;
+    }
+    if (STREQ("remove", op->string)){
+        if (!_jscon_patch_locate(utils, path->string, &parent)) return false;
+        if (NULL == parent) return false; //can't remove root
+
+        target = _jscon_patch_child(utils, parent, utils->token);
+        if (NULL == target) return false;
+
+        _jscon_patch_remove(utils, target);
+        _jscon_patch_list_push(&utils->garbage, target);
+        return true;
+    }
+    if (STREQ("replace", op->string)){
+        if (NULL == value) return false;
+        if (!_jscon_patch_locate(utils, path->string, &parent)) return false;
+
+        target = _jscon_patch_child(utils, parent, utils->token);
+        if (NULL == target) return false;
+
+        item = Jscon_item_copy(value, NULL);
+        DEBUG_ASSERT(NULL != item, "Out of memory");
+
+        _jscon_patch_replace(utils, target, item);
+        return true;
+    }
+    if (STREQ("move", op->string)){
+        if (NULL == from) return false;
+
+        /* can't move an item into one of its branches */
+        const size_t from_len = strlen(from->string);
+        if (0 == strncmp(from->string, path->string, from_len) && '/' == path->string[from_len]){
+            return false;
+        }
+
+        if (!_jscon_patch_locate(utils, from->string, &parent)) return false;
+        if (NULL == parent) return false; //can't move root
+
+        item = _jscon_patch_child(utils, parent, utils->token);
+        if (NULL == item) return false;
+
+        _jscon_patch_remove(utils, item);
+
+        if (!_jscon_patch_locate(utils, path->string, &parent)
+            || !_jscon_patch_add(utils, parent, item))
+        {
+            _jscon_patch_list_push(&utils->garbage, item);
+            return false;
+        }
+        return true;
+    }
+    if (STREQ("copy", op->string)){
+        if (NULL == from) return false;
+        if (!_jscon_patch_locate(utils, from->string, &parent)) return false;
+
+        target = _jscon_patch_child(utils, parent, utils->token);
+        if (NULL == target) return false;
+
+        item = Jscon_item_copy(target, NULL);
+        DEBUG_ASSERT(NULL != item, "Out of memory");
+
+        if (!_jscon_patch_locate(utils, path->string, &parent)
+            || !_jscon_patch_add(utils, parent, item))
+        {
+            jscon_destroy(item);
+            return false;
+        }
+        return true;
+    }
+    if (STREQ("test", op->string)){
+        if (NULL == value) return false;
+        if (!_jscon_patch_locate(utils, path->string, &parent)) return false;
+
+        target = _jscon_patch_child(utils, parent, utils->token);
+        return NULL != target && jscon_equal(target, value);
+    }
+
+    return false;
+}
+
+/* apply JSON Patch (RFC 6902) operations to *p_root in order, return
+    false at the first one that can't be applied, with the preceding
+    ones left applied. *p_root is updated if the root is replaced */
+bool
+jscon_patch(jscon_item_t **p_root, jscon_item_t *patch)
+{
+    DEBUG_ASSERT(NULL != p_root && NULL != *p_root, "Missing root");
+    DEBUG_ASSERT(NULL == (*p_root)->parent, "Item is not root");
+    DEBUG_ASSERT(!IS_READONLY(*p_root), "Item is owned by a parser");
+    DEBUG_ASSERT(NULL != patch, "Missing patch");
+
+    if (JSCON_ARRAY != patch->type) return false;
+
+    struct jscon_utils_s utils = {
+        .p_root = p_root,
+    };
+
+    bool is_applied = true;
+    for (size_t i=0; i < jscon_size(patch); ++i){
+        if (!_jscon_patch_apply(&utils, Jscon_array_element(patch, i))){
+            is_applied = false;
+            break;
+        }
+    }
+
+    _jscon_patch_finish(&utils);
+
+    return is_applied;
+}
+
+/* copy of a merge patch value, without its null members */
+static jscon_item_t*
+_jscon_merge_copy(jscon_item_t *value)
+{
+    if (JSCON_OBJECT != value->type){
+        jscon_item_t *copy = Jscon_item_copy(value, NULL);
+        DEBUG_ASSERT(NULL != copy, "Out of memory");
+        return copy;
+    }
+
+    jscon_item_t *copy = jscon_object(NULL);
+    DEBUG_ASSERT(NULL != copy, "Out of memory");
+
+    for (size_t i=0; i < value->comp->num_branch; ++i){
+        jscon_item_t *branch = value->comp->branch[i];
+        if (JSCON_NULL == branch->type) continue;
+
+        jscon_item_t *branch_copy = _jscon_merge_copy(branch);
+        _jscon_patch_set_key(branch_copy, branch->key);
+        jscon_append(copy, branch_copy);
+    }
+
+    return copy;
+}
+
+static void
+_jscon_merge(struct jscon_utils_s *utils, jscon_item_t *target, jscon_item_t *patch)
+{
+    for (size_t i=0; i < patch->comp->num_branch; ++i){
+        jscon_item_t *branch = patch->comp->branch[i];
+        jscon_item_t *member = Jscon_composite_get(branch->key, target);
+
+        if (JSCON_NULL == branch->type){
+            if (NULL != member){
+                _jscon_patch_remove(utils, member);
+                _jscon_patch_list_push(&utils->garbage, member);
+            }
+        }
+        else if (JSCON_OBJECT == branch->type && NULL != member && JSCON_OBJECT == member->type){
+            _jscon_merge(utils, member, branch);
+        }
+        else {
+            jscon_item_t *item = _jscon_merge_copy(branch);
+            if (NULL != member){
+                _jscon_patch_replace(utils, member, item);
+            }
+            else {
+                _jscon_patch_set_key(item, branch->key);
+                _jscon_patch_insert(utils, target, item, target->comp->num_branch);
+            }
+        }
+    }
+}
+
+/* apply JSON Merge Patch (RFC 7386) to *p_root. *p_root is updated
+    if the root is replaced */
+void
+jscon_merge_patch(jscon_item_t **p_root, jscon_item_t *patch)
+{
+    DEBUG_ASSERT(NULL != p_root && NULL != *p_root, "Missing root");
+    DEBUG_ASSERT(NULL == (*p_root)->parent, "Item is not root");
+    DEBUG_ASSERT(!IS_READONLY(*p_root), "Item is owned by a parser");
+    DEBUG_ASSERT(NULL != patch, "Missing patch");
+
+    struct jscon_utils_s utils = {
+        .p_root = p_root,
+    };
+
+    if (JSCON_OBJECT != patch->type){
+        _jscon_patch_replace(&utils, *p_root, _jscon_merge_copy(patch));
+    }
+    else {
+        if (JSCON_OBJECT != (*p_root)->type){
+            jscon_item_t *root = jscon_object(NULL);
+            DEBUG_ASSERT(NULL != root, "Out of memory");
+
+            _jscon_patch_replace(&utils, *p_root, root);
+        }
+        _jscon_merge(&utils, *p_root, patch);
+    }
+
+    _jscon_patch_finish(&utils);
+}
@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include <libjscon.h>
+
+#include "jscon-common.h"
+#include "debug.h"
+
+
+/* a chunk of literal text to be written as is, followed by the
+    value of its specifier (if any). every key is already expanded
+    to its "key": form at the literal, so that writing a token is
+    a memcpy followed by a single value conversion */
+struct jscon_printf_token_s {
+    char *literal;
+    size_t literal_len;
+    enum jscon_specifier specifier; //JSCON_SPECIFIER_NONE for trailing literal
+};
+
+/* the precompiled format, tokens and literals are stored in the same
+    block of memory as the plan itself. it is never modified after
+    jscon_printf_compile() returns, and can be shared between threads */
+struct jscon_printf_plan_s {
+    struct jscon_printf_token_s *token;
+    size_t num_token;
+    char *text; //literals storage
+};
+
+/* count amount of specifiers and the upper bound length of literals */
+static size_t
+_jscon_format_analyze(char *format, size_t *p_text_len)
+{
+    size_t num_spec = 0;
+    size_t text_len = 0;
+    while ('\0' != *format){
+        if ('%' == *format){
+            ++num_spec;
+            text_len += 3; //quotes and ':' surrounding key
+        }
+        ++text_len;
+        ++format;
+    }
+
+    *p_text_len = text_len;
+
+    return num_spec;
+}
+
+/* fills the plan tokens, blank characters outside of quotes are removed
+    so that the output is a compact json text. returns false if format
+    is malformed */
+static bool
+_jscon_format_decode(char *format, jscon_printf_plan_t *plan)
+{
+    char *text = plan->text;
+    struct jscon_printf_token_s *token = plan->token;
+    token->literal = text;
+
+    bool in_quotes = false;
+    while ('\0' != *format)
+    {
+        /* 1st STEP: copy literals, quoted text is kept untouched */
+        if (in_quotes){
+            if ('\\' == *format && '\0' != format[1]){
+                *text++ = *format++; //copy escaped char
+            } else if ('\"' == *format){
+                in_quotes = false;
+            }
+            *text++ = *format++;
+            continue;
+        }
+
+        switch (*format){
+        case '\"':
+            in_quotes = true;
+            *text++ = *format++;
+            continue;
+        case '%':
+            ++format; //skips '%'
+            break;
+        default:
+            if (!IS_BLANK_CHAR(*format)){
+                *text++ = *format;
+            }
+            ++format;
+            continue;
+        }
+
+        /* 2nd STEP: fetch type specifier */
+        char *spec_start = format;
+        while (isalpha(*format)){
+            ++format;
+        }
+        if ('[' != *format){
+            DEBUG_PRINT("Missing format '[' key prefix\n\t"
+                        "Found: '%c'", *format);
+            return false;
+        }
+
+        token->specifier = Jscon_specifier_decode(spec_start, format - spec_start);
+        if (JSCON_SPECIFIER_NONE == token->specifier){
+            DEBUG_PRINT("Unknown type specifier %%%.*s", (int)(format - spec_start), spec_start);
+            return false;
+        }
+        ++format; //skips '['
+
+        /* 3rd STEP: expand key to "key": if not empty (array element) */
+        char *key_start = format;
+        while (']' != *format){
+            if ('\0' == *format){
+                DEBUG_PRINT("Missing format ']' key suffix");
+                return false;
+            }
+            ++format;
+        }
+        if (format != key_start){
+            *text++ = '\"';
+            memcpy(text, key_start, format - key_start);
+            text += format - key_start;
+            *text++ = '\"';
+            *text++ = ':';
+        }
+        ++format; //skips ']'
+
+        /* 4th STEP: close token and start the next one */
+        token->literal_len = text - token->literal;
+        ++token;
+        token->literal = text;
+    }
+
+    if (in_quotes){
+        DEBUG_PRINT("Missing closing '\"' in format");
+        return false;
+    }
+
+    token->literal_len = text - token->literal;
+    token->specifier = JSCON_SPECIFIER_NONE;
+
+    return true;
+}
+
+jscon_printf_plan_t*
+jscon_printf_compile(char *format)
+{
+    DEBUG_ASSERT(NULL != format, "Missing format");
+
+    size_t text_len;
+    size_t num_token = 1 + _jscon_format_analyze(format, &text_len);
+
+    jscon_printf_plan_t *plan = Jscon_malloc(sizeof *plan
+                                       + num_token * sizeof *plan->token
+                                       + text_len, JSCON_ALLOC_OTHER);
+    if (NULL == plan) return NULL;
+
+    plan->token = (struct jscon_printf_token_s*)(plan + 1);
+    plan->num_token = num_token;
+    plan->text = (char*)(plan->token + num_token);
+
+    if (!_jscon_format_decode(format, plan)){
+        Jscon_free(plan);
+        return NULL;
+    }
+
+    return plan;
+}
+
+void
+jscon_printf_destroy(jscon_printf_plan_t *plan){
+    Jscon_free(plan);
+}
+
+/* strings are escaped, as they're C strings rather than json text */
+static void
+_jscon_printf_char(char c, struct jscon_outbuf_s *out){
+    Jscon_outbuf_string(out, &c, 1);
+}
+
+static void
+_jscon_printf_string(char *string, struct jscon_outbuf_s *out)
+{
+    if (NULL == string){
+        Jscon_outbuf_write(out, "null", 4);
+        return;
+    }
+
+    Jscon_outbuf_string(out, string, strlen(string));
+}
+
+static void
+_jscon_printf_double(double d_number, struct jscon_outbuf_s *out)
+{
+    /* json has no representation for inf and nan */
+    if (!isfinite(d_number)){
+        Jscon_outbuf_write(out, "null", 4);
+        return;
+    }
+
+    char numstr[MAX_DOUBLE_LEN];
+    size_t len = Jscon_encode_double_exact(d_number, numstr);
+
+    Jscon_outbuf_write(out, numstr, len);
+}
+
+static void
+_jscon_printf_integer(long long i_number, struct jscon_outbuf_s *out)
+{
+    char numstr[MAX_DIGITS+4];
+    size_t len = Jscon_encode_integer(i_number, numstr);
+
+    Jscon_outbuf_write(out, numstr, len);
+}
+
+static void
+_jscon_printf_item(jscon_item_t *item, struct jscon_outbuf_s *out)
+{
+    if (NULL == item){
+        Jscon_outbuf_write(out, "null", 4);
+        return;
+    }
+
+    char *buffer = jscon_stringify(item, JSCON_ANY);
+    DEBUG_ASSERT(NULL != buffer, "Out of memory");
+
+    Jscon_outbuf_write(out, buffer, strlen(buffer));
+    free(buffer);
+}
+
+static size_t
+_jscon_printf_vexec(const jscon_printf_plan_t *plan, char *buffer, size_t size, va_list ap)
+{
+    struct jscon_outbuf_s out = {
+        .base = buffer,
+        .size = size,
+    };
+
+    const struct jscon_printf_token_s *token = plan->token;
+    for (size_t i=0; i < plan->num_token; ++i, ++token){
+        Jscon_outbuf_write(&out, token->literal, token->literal_len);
+
+        switch (token->specifier){
+        case JSCON_SPECIFIER_NONE:
+            break;
+        case JSCON_SPECIFIER_CHAR:
+            _jscon_printf_char((char)va_arg(ap, int), &out);
+            break;
+        case JSCON_SPECIFIER_STRING:
+            _jscon_printf_string(va_arg(ap, char*), &out);
+            break;
+        case JSCON_SPECIFIER_INT:
+            _jscon_printf_integer(va_arg(ap, int), &out);
+            break;
+        case JSCON_SPECIFIER_LONG:
+            _jscon_printf_integer(va_arg(ap, long), &out);
+            break;
+        case JSCON_SPECIFIER_LLONG:
+            _jscon_printf_integer(va_arg(ap, long long), &out);
+            break;
+        case JSCON_SPECIFIER_FLOAT: /* float is promoted to double */
+        case JSCON_SPECIFIER_DOUBLE:
+            _jscon_printf_double(va_arg(ap, double), &out);
+            break;
+        case JSCON_SPECIFIER_BOOLEAN: /* bool is promoted to int */
+            if (va_arg(ap, int)){
+                Jscon_outbuf_write(&out, "true", 4);
+            } else {
+                Jscon_outbuf_write(&out, "false", 5);
+            }
+            break;
+        case JSCON_SPECIFIER_ITEM:
+            _jscon_printf_item(va_arg(ap, jscon_item_t*), &out);
+            break;
+        default:
+            DEBUG_ERR("Unknown specifier code: %d", token->specifier);
+        }
+    }
+
+    Jscon_outbuf_end(&out);
+
+    return out.offset;
+}
+
+/* works like snprintf, but with the format rules of jscon_scanf(), each
+    "%specifier[key]" expands to "key":value. returns the length the
+    json text would have if size was big enough (excluding nul char) */
+size_t
+jscon_printf_exec(const jscon_printf_plan_t *plan, char *buffer, size_t size, ...)
+{
+    va_list ap;
+    va_start(ap, size);
+
+    size_t len = _jscon_printf_vexec(plan, buffer, size, ap);
+
+    va_end(ap);
+
+    return len;
+}
+
+size_t
+jscon_vsnprintf(char *buffer, size_t size, char *format, va_list ap)
+{
+    jscon_printf_plan_t *plan = jscon_printf_compile(format);
+    if (NULL == plan){ //malformed format, nothing is written
+        struct jscon_outbuf_s out = {
+            .base = buffer,
+            .size = size,
+        };
+        Jscon_outbuf_end(&out);
+        return 0;
+    }
+
+    size_t len = _jscon_printf_vexec(plan, buffer, size, ap);
+
+    jscon_printf_destroy(plan);
+
+    return len;
+}
+
+size_t
+jscon_snprintf(char *buffer, size_t size, char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+
+    size_t len = jscon_vsnprintf(buffer, size, format, ap);
+
+    va_end(ap);
+
+    return len;
+}
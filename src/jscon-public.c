@@ -34,20 +34,9 @@
 static inline jscon_item_t*
 _jscon_new(const char *key, enum jscon_type type)
 {
-    jscon_item_t *new_item = malloc(sizeof *new_item);
+    jscon_item_t *new_item = Jscon_item_init(key, (NULL != key) ? strlen(key) : 0, NULL, 0);
     if (NULL == new_item) return NULL;
 
-    if (NULL != key){
-        new_item->key = strdup(key);
-        if (NULL == new_item->key){
-            free(new_item);
-            return NULL;
-        }
-    } else {
-        new_item->key = NULL;
-    }
-
-    new_item->parent = NULL;
     new_item->type = type;
 
     return new_item;
@@ -104,36 +93,12 @@ jscon_string(const char *key, char *string)
 {
     if (NULL == string) return jscon_null(key);
 
-    jscon_item_t *new_item = _jscon_new(key, JSCON_STRING);
+    jscon_item_t *new_item = Jscon_item_init(key, (NULL != key) ? strlen(key) : 0, string, strlen(string));
     if (NULL == new_item) return NULL;
 
-    new_item->string = strdup(string);
-    if (NULL == new_item->string) goto free_string;
+    new_item->type = JSCON_STRING;
 
     return new_item;
-
-free_string:
-    free(new_item->key);
-    free(new_item);
-
-    return NULL;
-}
-
-/* @todo add condition to stop if after linking item hwrap to a already
-      formed composite. This is far from ideal, I should probably try to
-      make this iteratively just so that I have a better control on whats
-      going on, early break conditions etc. As it is now it will keep on
-      going deeper and deeper recursively, even if not necessary */
-static void
-_jscon_comp_link_preorder(jscon_item_t *item, jscon_composite_t **last_accessed_comp)
-{
-    Jscon_composite_link_r(item, last_accessed_comp);
-
-    for (size_t i=0; i < item->comp->num_branch; ++i){
-        if (IS_COMPOSITE(item->comp->branch[i])){
-            _jscon_comp_link_preorder(item->comp->branch[i], last_accessed_comp);
-        }
-    }
 }
 
 inline static jscon_item_t*
@@ -142,30 +107,15 @@ _jscon_composite(const char *key, enum jscon_type type)
     jscon_item_t *new_item = _jscon_new(key, type);
     if (NULL == new_item) return NULL;
 
-    new_item->comp = calloc(1, sizeof *new_item->comp);
+    new_item->comp = Jscon_composite_init(1);
     if (NULL == new_item->comp) goto comp_free;
 
-    new_item->comp->hashtable = hashtable_init(); 
-    if (NULL == new_item->comp->hashtable) goto hashtable_free;
-
-    new_item->comp->branch = malloc(sizeof(jscon_item_t*));
-    if (NULL == new_item->comp->branch) goto branch_free;
-
-    jscon_composite_t *last_accessed_comp = NULL;
-    _jscon_comp_link_preorder(new_item, &last_accessed_comp);
-
-    Jscon_composite_build(new_item);
-
     return new_item;
 
 
-branch_free:
-    hashtable_destroy(new_item->comp->hashtable);
-hashtable_free:
-    free(new_item->comp);
 comp_free:
-    free(new_item->key);
-    free(new_item);
+    Jscon_item_free_key(new_item);
+    Jscon_free(new_item);
 
     return NULL;
 }
@@ -183,118 +133,200 @@ jscon_array(const char *key){
 /* total branches the item possess, returns 0 if item type is primitive */
 size_t
 jscon_size(const jscon_item_t *item){
-    return IS_COMPOSITE(item) ? item->comp->num_branch : 0;
+    if (!IS_COMPOSITE(item)) return 0;
+    return IS_PACKED(item) ? item->comp->num_packed : item->comp->num_branch;
 } 
 
-static size_t
-_jscon_depth(jscon_item_t *item)
-{
-    size_t depth = 0;
-    while (!IS_ROOT(item)){
-        item = item->parent;
-        ++depth;
-    }
-
-    return depth;
-}
-
-/* get the last comp relative to the item */
-static jscon_composite_t*
+/* get the last composite item relative to the item (itself if
+    it has no nested composites), by descending into the last
+    composite branch of each level */
+static jscon_item_t*
 _jscon_get_last_comp(jscon_item_t *item)
 {
     DEBUG_ASSERT(IS_COMPOSITE(item), "Item is not an Object or Array");
 
-    size_t item_depth = _jscon_depth(item);
-
-    /* get the deepest nested composite relative to item */
-    jscon_composite_t *comp_last = item->comp;
-    while(NULL != comp_last->next && item_depth < _jscon_depth(comp_last->next->p_item)){
-        comp_last = comp_last->next;
+    jscon_item_t *comp_last = item;
+    size_t i = comp_last->comp->num_branch;
+    while (i > 0){
+        if (IS_COMPOSITE(comp_last->comp->branch[i-1])){
+            comp_last = comp_last->comp->branch[i-1];
+            i = comp_last->comp->num_branch;
+        } else {
+            --i;
+        }
     }
 
     return comp_last;
 }
 
+/* insert new_branch at item branches position index, the branches
+    from it onwards are shifted one position. unless new_branch is the
+    last one, the item key index is left stale (check
+    Jscon_composite_remake()) */
 jscon_item_t*
-jscon_append(jscon_item_t *item, jscon_item_t *new_branch)
+Jscon_branch_insert(jscon_item_t *item, jscon_item_t *new_branch, size_t index)
 {
-    DEBUG_ASSERT(IS_COMPOSITE(item), "Item is not an Object or Array");
+    DEBUG_ASSERT(!IS_PACKED(item), "Array must be unpacked first");
+    DEBUG_ASSERT(index <= item->comp->num_branch, "Index out of bounds");
 
-    if (new_branch == item){
-        DEBUG_ASSERT(NULL != item->key, "Can't perform circular append of item without a key");
-        new_branch = jscon_clone(item);
-        if (NULL == new_branch) return NULL;
+    /* a tree appended to another is no longer a root */
+    if (IS_COMPOSITE(new_branch) && NULL != new_branch->comp->keyindex){
+        Jscon_keyindex_destroy(new_branch->comp->keyindex);
+        new_branch->comp->keyindex = NULL;
     }
 
-    /* realloc parent references to match new size */
-    jscon_item_t **tmp = realloc(item->comp->branch, (1+item->comp->num_branch) * sizeof(jscon_item_t*));
-    if (NULL == tmp) return NULL;
+    /* grow parent references geometrically when full */
+    if (item->comp->num_branch == item->comp->capacity){
+        if (!Jscon_composite_reserve(item, 2 * item->comp->capacity)) return NULL;
+    }
 
-    item->comp->branch = tmp;
+    /* get the last comp preceding index, before linking new_branch */
+    jscon_item_t *comp_last = NULL;
+    if (IS_COMPOSITE(new_branch)){
+        size_t i = index;
+        while (i > 0 && !IS_COMPOSITE(item->comp->branch[i-1])){
+            --i;
+        }
+        comp_last = (i > 0) ? _jscon_get_last_comp(item->comp->branch[i-1]) : item;
+    }
 
-    ++item->comp->num_branch;
+    /* new_branch may change the field item is indexed by */
+    Jscon_index_unlink(item);
 
-    item->comp->branch[item->comp->num_branch-1] = new_branch;
+    memmove(item->comp->branch + index + 1, item->comp->branch + index,
+            (item->comp->num_branch - index) * sizeof *item->comp->branch);
+    item->comp->branch[index] = new_branch;
+    ++item->comp->num_branch;
     new_branch->parent = item;
 
-    if (item->comp->num_branch <= item->comp->hashtable->num_bucket){
+    if (index == item->comp->num_branch-1){
         Jscon_composite_set(new_branch->key, new_branch);
     } else {
-        Jscon_composite_remake(item);
+        item->comp->stale = true;
+    }
+
+    Jscon_index_link(item);
+    Jscon_index_link(new_branch);
+
+    Jscon_hash_invalidate(item);
+
+    struct jscon_keyindex_s *keyindex = Jscon_keyindex_get(item);
+    if (NULL != keyindex){
+        Jscon_keyindex_add(keyindex, new_branch);
     }
 
     if (IS_PRIMITIVE(new_branch)) return new_branch;
 
-    /* get the last comp relative to item */
-    jscon_composite_t *comp_last = _jscon_get_last_comp(item);
-    comp_last->next = new_branch->comp;
+    /* splice new_branch composites in between comp_last and whatever
+        comes after it */
+    jscon_item_t *branch_last = _jscon_get_last_comp(new_branch);
+    branch_last->comp->next = comp_last->comp->next;
+    if (NULL != branch_last->comp->next){
+        branch_last->comp->next->comp->prev = branch_last;
+    }
+    comp_last->comp->next = new_branch;
     new_branch->comp->prev = comp_last;
 
     return new_branch;
 }
 
-/* @todo test this */
+/* remove item from its parent, whose key index is left stale (check
+    Jscon_composite_remake()) */
 jscon_item_t*
-jscon_dettach(jscon_item_t *item)
+Jscon_branch_remove(jscon_item_t *item)
 {
-    //can't dettach root from nothing
-    if (NULL == item || IS_ROOT(item)) return item;
+    DEBUG_ASSERT(!IS_ROOT(item), "Item has no parent");
+
+    /* remove item from the key index while still in the tree */
+    struct jscon_keyindex_s *keyindex = Jscon_keyindex_get(item);
+    if (NULL != keyindex){
+        Jscon_keyindex_remove(keyindex, item);
+    }
 
     /* get the item index reference from its parent */
     jscon_item_t *item_parent = item->parent;
 
-    /* realloc parent references to match new size */
-    jscon_item_t **tmp = realloc(item_parent->comp->branch, jscon_size(item_parent) * sizeof(jscon_item_t*));
-    if (NULL == tmp) return NULL;
-
-    item_parent->comp->branch = tmp;
+    /* remove item from its array indexes, and item_parent from the
+        ones it may be indexed at, before item is removed */
+    Jscon_index_unlink(item);
+    Jscon_index_unlink(item_parent);
 
     /* dettach the item from its parent and reorder keys */
-    for (size_t i = jscon_get_index(item_parent, item->key); i < jscon_size(item_parent)-1; ++i){
-        item_parent->comp->branch[i] = item_parent->comp->branch[i+1]; 
+    size_t index = item_parent->comp->num_branch;
+    while (item_parent->comp->branch[index-1] != item){
+        --index;
     }
-    item_parent->comp->branch[jscon_size(item_parent)-1] = NULL;
-    --item_parent->comp->num_branch;
+    memmove(item_parent->comp->branch + index - 1, item_parent->comp->branch + index,
+            (item_parent->comp->num_branch - index) * sizeof *item_parent->comp->branch);
+    item_parent->comp->branch[--item_parent->comp->num_branch] = NULL;
+    item_parent->comp->stale = true;
 
-    /* parent hashtable has to be remade, to match reordered keys */
-    Jscon_composite_remake(item_parent);
+    Jscon_index_link(item_parent);
+
+    Jscon_hash_invalidate(item_parent);
+
+    if (IS_PRIMITIVE(item)){
+        item->parent = NULL;
+        return item;
+    }
 
     /* get the immediate previous comp relative to the item */
-    jscon_composite_t *comp_prev = item->comp->prev;
+    jscon_item_t *comp_prev = item->comp->prev;
     /* get the last comp relative to item */
-    jscon_composite_t *comp_last = _jscon_get_last_comp(item);
+    jscon_item_t *comp_last = _jscon_get_last_comp(item);
 
     /* remove tree references to the item */
-    comp_prev->next = comp_last->next;
+    comp_prev->comp->next = comp_last->comp->next;
+    if (NULL != comp_last->comp->next){
+        comp_last->comp->next->comp->prev = comp_prev;
+    }
 
     /* remove item references to the tree */
     item->parent = NULL;
-    comp_last->next = NULL;
+    comp_last->comp->next = NULL;
     item->comp->prev = NULL;
 
     return item;
 }
 
+jscon_item_t*
+jscon_append(jscon_item_t *item, jscon_item_t *new_branch)
+{
+    DEBUG_ASSERT(IS_COMPOSITE(item), "Item is not an Object or Array");
+    DEBUG_ASSERT(!IS_READONLY(item), "Item is owned by a parser");
+    DEBUG_ASSERT(!IS_READONLY(new_branch), "Branch is owned by a parser");
+
+    if (new_branch == item){
+        DEBUG_ASSERT(NULL != item->key, "Can't perform circular append of item without a key");
+        new_branch = jscon_clone(item);
+        if (NULL == new_branch) return NULL;
+    }
+
+    /* packed elements can't sit next to items */
+    Jscon_array_unpack(item);
+
+    return Jscon_branch_insert(item, new_branch, item->comp->num_branch);
+}
+
+/* @todo test this */
+jscon_item_t*
+jscon_dettach(jscon_item_t *item)
+{
+    //can't dettach root from nothing
+    if (NULL == item || IS_ROOT(item)) return item;
+
+    DEBUG_ASSERT(!IS_READONLY(item), "Item is owned by a parser");
+
+    jscon_item_t *item_parent = item->parent;
+    Jscon_array_unpack(item_parent);
+    Jscon_branch_remove(item);
+
+    /* parent key index has to be remade, to match reordered keys */
+    Jscon_composite_remake(item_parent);
+
+    return item;
+}
+
 void
 jscon_delete(jscon_item_t *item, const char *key)
 {
@@ -329,13 +361,13 @@ jscon_iter_composite_r(jscon_item_t *item, jscon_item_t **p_current_item)
 
     /* get next comp in line, if NULL it means there are no more
         composite datatype items to iterate through */
-    jscon_composite_t *next_comp = (*p_current_item)->comp->next;
+    jscon_item_t *next_comp = (*p_current_item)->comp->next;
     if (NULL == next_comp){
         *p_current_item = NULL;
         return NULL;
     }
 
-    *p_current_item = next_comp->p_item;
+    *p_current_item = next_comp;
 
     return *p_current_item;
 }
@@ -345,10 +377,11 @@ static inline jscon_item_t*
 _jscon_push(jscon_item_t *item)
 {
     DEBUG_ASSERT(IS_COMPOSITE(item), "Item is not an Object or Array");
-    DEBUG_ASSERT(item->comp->last_accessed_branch < item->comp->num_branch, "Overflow, trying to access forbidden memory");
+    DEBUG_ASSERT(item->comp->last_accessed_branch < jscon_size(item), "Overflow, trying to access forbidden memory");
 
     ++item->comp->last_accessed_branch; //update last_accessed_branch to next
-    jscon_item_t *next_item = item->comp->branch[item->comp->last_accessed_branch-1];
+    /* packed elements are read as items, the array is kept packed */
+    jscon_item_t *next_item = Jscon_array_element(item, item->comp->last_accessed_branch-1);
 
     //resets incase its already set because of a different run
     if (IS_COMPOSITE(next_item)){
@@ -391,7 +424,7 @@ jscon_iter_next(jscon_item_t *item)
             if ((NULL == item) || (0 == item->comp->last_accessed_branch)){
                 return NULL; //return NULL if exceeded root
             }
-        } while (item->comp->num_branch == item->comp->last_accessed_branch);
+        } while (jscon_size(item) == item->comp->last_accessed_branch);
     }
 
     return _jscon_push(item);
@@ -413,8 +446,7 @@ jscon_clone(jscon_item_t *item)
     free(tmp_buffer);
 
     if (NULL != item->key){
-        clone->key = strdup(item->key);
-        if (NULL == clone->key){
+        if (NULL == Jscon_item_set_key(clone, item->key, strlen(item->key))){
             jscon_destroy(clone);
             clone = NULL;
         }
@@ -423,6 +455,73 @@ jscon_clone(jscon_item_t *item)
     return clone;
 }
 
+/* deep copy of item under key, built branch by branch rather than
+    parsed from text, so that no number loses precision */
+jscon_item_t*
+Jscon_item_copy(jscon_item_t *item, const char *key)
+{
+    jscon_item_t *copy;
+    switch (item->type){
+    case JSCON_NULL:
+        return jscon_null(key);
+    case JSCON_BOOLEAN:
+        return jscon_boolean(key, item->boolean);
+    case JSCON_INTEGER:
+        return jscon_integer(key, item->i_number);
+    case JSCON_DOUBLE:
+        return jscon_double(key, item->d_number);
+    case JSCON_STRING:
+        return jscon_string(key, item->string);
+    case JSCON_OBJECT:
+        copy = jscon_object(key);
+        break;
+    case JSCON_ARRAY:
+        copy = jscon_array(key);
+        break;
+    default:
+        DEBUG_ERR("Can't copy undefined datatype, code: %d", item->type);
+        return NULL;
+    }
+    if (NULL == copy) return NULL;
+
+    if (IS_PACKED(item)){
+        jscon_composite_t *packed_comp = Jscon_packed_copy(item->comp);
+        if (NULL == packed_comp){
+            jscon_destroy(copy);
+            return NULL;
+        }
+        Jscon_free(copy->comp);
+        copy->comp = packed_comp;
+        return copy;
+    }
+
+    if (!Jscon_composite_reserve(copy, item->comp->num_branch)){
+        jscon_destroy(copy);
+        return NULL;
+    }
+    for (size_t i=0; i < item->comp->num_branch; ++i){
+        jscon_item_t *branch = item->comp->branch[i];
+
+        /* array elements are keyed by their position */
+        char numerical_key[32];
+        if (JSCON_ARRAY == item->type){
+            snprintf(numerical_key, sizeof numerical_key, "%zu", i);
+        }
+        jscon_item_t *branch_copy = Jscon_item_copy(branch, (JSCON_ARRAY == item->type) ? numerical_key : branch->key);
+        if (NULL == branch_copy){
+            jscon_destroy(copy);
+            return NULL;
+        }
+        if (NULL == jscon_append(copy, branch_copy)){
+            jscon_destroy(branch_copy);
+            jscon_destroy(copy);
+            return NULL;
+        }
+    }
+
+    return copy;
+}
+
 char*
 jscon_typeof(const jscon_item_t *item)
 {
@@ -473,6 +572,8 @@ jscon_typecmp(const jscon_item_t *item, const enum jscon_type type){
 
 int
 jscon_keycmp(const jscon_item_t *item, const char *key){
+    if (item->key == key) return NULL != key;
+
     return (NULL != item->key) ? STREQ(item->key, key) : 0;
 }
 
@@ -540,7 +641,8 @@ jscon_item_t*
 jscon_get_byindex(const jscon_item_t *item, const size_t index)
 {
     DEBUG_ASSERT(IS_COMPOSITE(item), "Item is not an Object or Array");
-    return (index < item->comp->num_branch) ? item->comp->branch[index] : NULL;
+
+    return Jscon_array_element(item, index);
 }
 
 long
@@ -548,13 +650,13 @@ jscon_get_index(const jscon_item_t *item, const char *key)
 {
     DEBUG_ASSERT(IS_COMPOSITE(item), "Item is not an Object or Array");
 
-    jscon_item_t *lookup_item = Jscon_composite_get(key, (jscon_item_t*)item);
+    jscon_item_t *lookup_item = Jscon_composite_get(key, item);
 
     if (NULL == lookup_item) return -1;
 
     /* @todo can this be done differently? */
-    for (size_t i=0; i < item->comp->num_branch; ++i){
-        if (lookup_item == item->comp->branch[i]){
+    for (size_t i=0; i < jscon_size(item); ++i){
+        if (lookup_item == Jscon_array_element(item, i)){
             return i;
         }
     }
@@ -629,30 +731,83 @@ _jscon_trychange_type(jscon_item_t *item, enum jscon_type type)
     }
 }
 */
+/* an element read from a packed array no longer matches the packed
+    numbers once set, so the array is unpacked first (check
+    jscon-packed.c) */
+static inline void
+_jscon_set_prepare(jscon_item_t *item)
+{
+    if (NULL != item->parent){
+        Jscon_array_unpack(item->parent);
+    }
+}
+
 bool
 jscon_set_boolean(jscon_item_t *item, bool boolean)
 {
-    return item->boolean = boolean;
+    _jscon_set_prepare(item);
+
+    item->boolean = boolean;
+
+    if (NULL != item->parent){
+        Jscon_hash_invalidate(item->parent);
+    }
+
+    return boolean;
 }
 
 char*
 jscon_set_string(jscon_item_t *item, char *string)
 {
-    if (item->string){
-      free(item->string);
+    DEBUG_ASSERT(!IS_READONLY(item), "Item is owned by a parser");
+
+    _jscon_set_prepare(item);
+
+    /* item may be the field its parent is indexed by */
+    if (NULL != item->parent){
+        Jscon_index_unlink(item->parent);
     }
 
-    return item->string = strdup(string);
+    char *new_string = Jscon_item_set_string(item, string, strlen(string));
+
+    if (NULL != item->parent){
+        Jscon_index_link(item->parent);
+        Jscon_hash_invalidate(item->parent);
+    }
+
+    return new_string;
 }
 
 double
 jscon_set_double(jscon_item_t *item, double d_number)
 {
-    return item->d_number = d_number;
+    _jscon_set_prepare(item);
+
+    item->d_number = d_number;
+
+    if (NULL != item->parent){
+        Jscon_hash_invalidate(item->parent);
+    }
+
+    return d_number;
 }
 
 long long
 jscon_set_integer(jscon_item_t *item, long long i_number)
 {
-    return item->i_number = i_number;
+    _jscon_set_prepare(item);
+
+    /* item may be the field its parent is indexed by */
+    if (NULL != item->parent){
+        Jscon_index_unlink(item->parent);
+    }
+
+    item->i_number = i_number;
+
+    if (NULL != item->parent){
+        Jscon_index_link(item->parent);
+        Jscon_hash_invalidate(item->parent);
+    }
+
+    return i_number;
 }
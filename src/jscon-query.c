@@ -0,0 +1,559 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+
+#include <libjscon.h>
+#include "jscon-common.h"
+
+#include "debug.h"
+
+
+enum jscon_selector_type {
+    SELECTOR_NAME,      /* .key or ['key'], object members only */
+    SELECTOR_INDEX,     /* [i], negative counts from the end */
+    SELECTOR_WILDCARD,  /* .* or [*] */
+    SELECTOR_SLICE,     /* [start:end:step] */
+    SELECTOR_TOKEN,     /* json pointer reference token, matches
+                            object keys and array indexes alike */
+};
+
+/* a single selector of a step
+ *      name: unescaped key (SELECTOR_NAME and SELECTOR_TOKEN)
+ *      index: SELECTOR_INDEX index, or SELECTOR_SLICE start
+ *      end, step: SELECTOR_SLICE only
+ *      has_start, has_end: whether SELECTOR_SLICE bound was given */
+struct jscon_query_selector_s {
+    enum jscon_selector_type type;
+    char *name;
+    long index;
+    long end;
+    long step;
+    bool has_start;
+    bool has_end;
+};
+
+/* a step of the query, its selectors are applied in order to the
+    items matched by the previous step
+ *      is_descendant: selectors are also applied to every nested
+ *          composite, for '..' steps
+ *      selector: first selector of the step
+ *      num_selector: amount of selectors, more than 1 for unions */
+struct jscon_query_step_s {
+    bool is_descendant;
+    struct jscon_query_selector_s *selector;
+    size_t num_selector;
+};
+
+/* the precompiled query, never modified after jscon_query_compile()
+    so that it can be shared between threads */
+struct jscon_query_s {
+    struct jscon_query_step_s *step;
+    size_t num_step;
+    struct jscon_query_selector_s *selector; //selectors of all steps
+    size_t num_selector;
+
+    char *text; //names storage
+};
+
+struct jscon_utils_s {
+    const jscon_query_t *query;
+    jscon_query_cb *cb;
+    void *context;
+    size_t num_match;
+    bool is_stopped; //cb returned false
+};
+
+
+static struct jscon_query_step_s*
+_jscon_query_step(jscon_query_t *query, bool is_descendant)
+{
+    struct jscon_query_step_s *new_step = &query->step[query->num_step++];
+    new_step->is_descendant = is_descendant;
+    new_step->selector = &query->selector[query->num_selector];
+    new_step->num_selector = 0;
+
+    return new_step;
+}
+
+static struct jscon_query_selector_s*
+_jscon_query_selector(jscon_query_t *query, struct jscon_query_step_s *step, enum jscon_selector_type type)
+{
+    struct jscon_query_selector_s *new_selector = &query->selector[query->num_selector++];
+    memset(new_selector, 0, sizeof *new_selector);
+    new_selector->type = type;
+    ++step->num_selector;
+
+    return new_selector;
+}
+
+/* parse optional integer, returns false if there is none */
+static bool
+_jscon_query_integer(const char **p_query, long *p_number)
+{
+    const char *query = *p_query;
+    if (!isdigit(*query) && !('-' == *query && isdigit(query[1]))) return false;
+
+    char *end;
+    *p_number = strtol(query, &end, 10);
+    *p_query = end;
+
+    return true;
+}
+
+/* json pointer reference token, '~1' decodes to '/' and '~0' to '~'.
+    returns NULL on a malformed escape */
+static const char*
+_jscon_query_decode_token(const char *query, char **p_text)
+{
+    char *text = *p_text;
+    for ( ; '\0' != *query && '/' != *query; ++query){
+        if ('~' != *query){
+            *text++ = *query;
+            continue;
+        }
+
+        ++query;
+        if ('0' == *query){
+            *text++ = '~';
+        } else if ('1' == *query){
+            *text++ = '/';
+        } else {
+            DEBUG_PRINT("Invalid escape sequence in JSON Pointer: '~%c'", *query);
+            return NULL;
+        }
+    }
+    *text++ = '\0';
+    *p_text = text;
+
+    return query;
+}
+
+/* a json pointer is a step of a single token per reference token */
+static bool
+_jscon_query_decode_pointer(const char *query, jscon_query_t *query_plan)
+{
+    char *text = query_plan->text;
+    while ('/' == *query){
+        ++query; //skips '/'
+
+        struct jscon_query_step_s *step = _jscon_query_step(query_plan, false);
+        struct jscon_query_selector_s *selector = _jscon_query_selector(query_plan, step, SELECTOR_TOKEN);
+
+        selector->name = text;
+        query = _jscon_query_decode_token(query, &text);
+        if (NULL == query) return false;
+    }
+
+    return true;
+}
+
+/* quoted name, with its delimiters and escaped chars decoded. returns
+    NULL if the closing quote is missing */
+static const char*
+_jscon_query_decode_quoted(const char *query, char **p_text)
+{
+    const char delim = *query++;
+
+    char *text = *p_text;
+    while (delim != *query){
+        if ('\0' == *query){
+            DEBUG_PRINT("Missing '%c' closing quote in query", delim);
+            return NULL;
+        }
+        if ('\\' == *query && '\0' != query[1]){
+            ++query;
+        }
+        *text++ = *query++;
+    }
+    *text++ = '\0';
+    *p_text = text;
+
+    return query + 1; //skips closing quote
+}
+
+/* selectors between '[' and ']', separated by commas. returns NULL on
+    a malformed selector, or if the closing bracket is missing */
+static const char*
+_jscon_query_decode_bracket(const char *query, jscon_query_t *query_plan, struct jscon_query_step_s *step, char **p_text)
+{
+    ++query; //skips '['
+    for (;;){
+        CONSUME_BLANK_CHARS(query);
+        if ('\0' == *query) break; //unclosed bracket
+
+        struct jscon_query_selector_s *selector;
+        long number;
+        if ('\'' == *query || '\"' == *query){
+            selector = _jscon_query_selector(query_plan, step, SELECTOR_NAME);
+            selector->name = *p_text;
+            query = _jscon_query_decode_quoted(query, p_text);
+            if (NULL == query) return NULL;
+        }
+        else if ('*' == *query){
+            _jscon_query_selector(query_plan, step, SELECTOR_WILDCARD);
+            ++query;
+        }
+        else {
+            bool has_start = _jscon_query_integer(&query, &number);
+            CONSUME_BLANK_CHARS(query);
+            if (':' != *query){
+                if (!has_start){
+                    DEBUG_PRINT("Invalid '%c' token in query selector", *query);
+                    return NULL;
+                }
+                selector = _jscon_query_selector(query_plan, step, SELECTOR_INDEX);
+                selector->index = number;
+            } else {
+                selector = _jscon_query_selector(query_plan, step, SELECTOR_SLICE);
+                selector->has_start = has_start;
+                selector->index = has_start ? number : 0;
+                selector->step = 1;
+
+                ++query; //skips first ':'
+                CONSUME_BLANK_CHARS(query);
+                selector->has_end = _jscon_query_integer(&query, &selector->end);
+                CONSUME_BLANK_CHARS(query);
+                if (':' == *query){
+                    ++query; //skips second ':'
+                    CONSUME_BLANK_CHARS(query);
+                    _jscon_query_integer(&query, &selector->step);
+                }
+            }
+        }
+
+        CONSUME_BLANK_CHARS(query);
+        if (',' != *query) break;
+
+        ++query; //skips ','
+    }
+
+    if (']' != *query){
+        DEBUG_PRINT("Missing ']' closing bracket in query");
+        return NULL;
+    }
+
+    return query + 1; //skips ']'
+}
+
+/* member name following '.' or '..', up to the next step. returns
+    NULL if the name is empty */
+static const char*
+_jscon_query_decode_name(const char *query, char **p_text)
+{
+    const char *start = query;
+    while ('\0' != *query && '.' != *query && '[' != *query){
+        ++query;
+    }
+    if (query == start){
+        DEBUG_PRINT("Missing member name in query");
+        return NULL;
+    }
+
+    const size_t len = query - start;
+    memcpy(*p_text, start, len);
+    (*p_text)[len] = '\0';
+    *p_text += len + 1;
+
+    return query;
+}
+
+static bool
+_jscon_query_decode_path(const char *query, jscon_query_t *query_plan)
+{
+    DEBUG_ASSERT('$' == *query, "Query must start with '$' or '/'");
+    ++query; //skips '$'
+
+    char *text = query_plan->text;
+    while (NULL != query && '\0' != *query){
+        struct jscon_query_step_s *step;
+        struct jscon_query_selector_s *selector;
+
+        if ('[' == *query){
+            step = _jscon_query_step(query_plan, false);
+            query = _jscon_query_decode_bracket(query, query_plan, step, &text);
+            continue;
+        }
+
+        if ('.' != *query){
+            DEBUG_PRINT("Invalid '%c' token in query", *query);
+            return false;
+        }
+        ++query; //skips '.'
+
+        bool is_descendant = ('.' == *query);
+        if (is_descendant){
+            ++query; //skips second '.'
+        }
+
+        step = _jscon_query_step(query_plan, is_descendant);
+        if ('[' == *query && is_descendant){
+            query = _jscon_query_decode_bracket(query, query_plan, step, &text);
+        }
+        else if ('*' == *query){
+            _jscon_query_selector(query_plan, step, SELECTOR_WILDCARD);
+            ++query;
+        }
+        else {
+            selector = _jscon_query_selector(query_plan, step, SELECTOR_NAME);
+            selector->name = text;
+            query = _jscon_query_decode_name(query, &text);
+        }
+    }
+
+    return (NULL != query);
+}
+
+/* compile a JSONPath query starting with '$', or a JSON Pointer
+    starting with '/' (the empty string points to root). returns NULL
+    if out of memory, or if the query is malformed */
+jscon_query_t*
+jscon_query_compile(const char *query)
+{
+    DEBUG_ASSERT(NULL != query, "Missing query");
+
+    /* every step and selector takes at least a char of the query,
+        and so does every name along with its nul terminator */
+    const size_t len = strlen(query);
+
+    jscon_query_t *new_query = Jscon_malloc(sizeof *new_query
+                                      + len * sizeof *new_query->step
+                                      + len * sizeof *new_query->selector
+                                      + 2 * len + 1, JSCON_ALLOC_OTHER);
+    if (NULL == new_query) return NULL;
+
+    new_query->step = (struct jscon_query_step_s*)(new_query + 1);
+    new_query->num_step = 0;
+    new_query->selector = (struct jscon_query_selector_s*)(new_query->step + len);
+    new_query->num_selector = 0;
+    new_query->text = (char*)(new_query->selector + len);
+
+    bool is_valid;
+    if ('$' == *query){
+        is_valid = _jscon_query_decode_path(query, new_query);
+    } else if ('/' == *query || '\0' == *query){
+        is_valid = _jscon_query_decode_pointer(query, new_query);
+    } else {
+        DEBUG_PRINT("Query must start with '$' or '/': %s", query);
+        is_valid = false;
+    }
+
+    if (!is_valid){
+        Jscon_free(new_query);
+        return NULL;
+    }
+
+    return new_query;
+}
+
+void
+jscon_query_destroy(jscon_query_t *query){
+    Jscon_free(query);
+}
+
+static void _jscon_query_apply(struct jscon_utils_s *utils, jscon_item_t *item, size_t step);
+
+static void
+_jscon_query_match(struct jscon_utils_s *utils, jscon_item_t *item, size_t step)
+{
+    if (NULL == item || utils->is_stopped) return;
+
+    if (step < utils->query->num_step){
+        _jscon_query_apply(utils, item, step);
+        return;
+    }
+
+    ++utils->num_match;
+    if (NULL != utils->cb && !(*utils->cb)(item, utils->context)){
+        utils->is_stopped = true;
+    }
+}
+
+/* array index of a json pointer token, which must be a plain
+    decimal with no leading zeroes */
+static jscon_item_t*
+_jscon_query_token_index(jscon_item_t *item, const char *token)
+{
+    if (!isdigit(*token) || ('0' == *token && '\0' != token[1])) return NULL;
+
+    size_t index = 0;
+    for ( ; isdigit(*token); ++token){
+        index = 10 * index + (*token - '0');
+    }
+    if ('\0' != *token) return NULL;
+
+    return jscon_get_byindex(item, index);
+}
+
+static void
+_jscon_query_slice(struct jscon_utils_s *utils, jscon_item_t *item, const struct jscon_query_selector_s *selector, size_t step)
+{
+    const long len = (long)jscon_size(item);
+    const long slice_step = selector->step;
+    if (0 == slice_step) return;
+
+    /* normalize negative bounds, then clamp them to the array */
+    long start = selector->index, end = selector->end;
+    if (start < 0) start += len;
+    if (end < 0) end += len;
+
+    if (slice_step > 0){
+        start = selector->has_start ? (start < 0 ? 0 : (start > len ? len : start)) : 0;
+        end = selector->has_end ? (end < 0 ? 0 : (end > len ? len : end)) : len;
+
+        for (long i = start; i < end && !utils->is_stopped; i += slice_step){
+            _jscon_query_match(utils, jscon_get_byindex(item, i), step+1);
+        }
+    } else {
+        start = selector->has_start ? (start < -1 ? -1 : (start >= len ? len-1 : start)) : len-1;
+        end = selector->has_end ? (end < -1 ? -1 : (end >= len ? len-1 : end)) : -1;
+
+        for (long i = start; i > end && !utils->is_stopped; i += slice_step){
+            _jscon_query_match(utils, jscon_get_byindex(item, i), step+1);
+        }
+    }
+}
+
+/* apply step selectors to the branches of item */
+static void
+_jscon_query_select(struct jscon_utils_s *utils, jscon_item_t *item, size_t step)
+{
+    if (!IS_COMPOSITE(item)) return;
+
+    const struct jscon_query_step_s *query_step = &utils->query->step[step];
+    for (size_t i=0; i < query_step->num_selector && !utils->is_stopped; ++i){
+        const struct jscon_query_selector_s *selector = &query_step->selector[i];
+        switch (selector->type){
+        case SELECTOR_NAME:
+            if (JSCON_OBJECT == item->type){
+                _jscon_query_match(utils, Jscon_composite_get(selector->name, item), step+1);
+            }
+            break;
+        case SELECTOR_TOKEN:
+            if (JSCON_OBJECT == item->type){
+                _jscon_query_match(utils, Jscon_composite_get(selector->name, item), step+1);
+            } else {
+                _jscon_query_match(utils, _jscon_query_token_index(item, selector->name), step+1);
+            }
+            break;
+        case SELECTOR_INDEX:
+            if (JSCON_ARRAY == item->type){
+                long index = selector->index;
+                if (index < 0) index += (long)jscon_size(item);
+                if (index >= 0){
+                    _jscon_query_match(utils, jscon_get_byindex(item, index), step+1);
+                }
+            }
+            break;
+        case SELECTOR_WILDCARD:
+            for (size_t j=0; j < jscon_size(item) && !utils->is_stopped; ++j){
+                _jscon_query_match(utils, Jscon_array_element(item, j), step+1);
+            }
+            break;
+        case SELECTOR_SLICE:
+            if (JSCON_ARRAY == item->type){
+                _jscon_query_slice(utils, item, selector, step);
+            }
+            break;
+        default:
+            DEBUG_ERR("Unknown selector type: %d", selector->type);
+            abort();
+        }
+    }
+}
+
+static void
+_jscon_query_apply(struct jscon_utils_s *utils, jscon_item_t *item, size_t step)
+{
+    if (!utils->query->step[step].is_descendant){
+        _jscon_query_select(utils, item, step);
+        return;
+    }
+
+    /* descendant steps select from item and every composite nested
+        in it, in preorder */
+    jscon_iter_t iter;
+    jscon_iter_init(&iter, item, JSCON_ITER_COMPOSITE);
+
+    jscon_item_t *composite;
+    while (!utils->is_stopped && NULL != (composite = jscon_iter_step(&iter))){
+        _jscon_query_select(utils, composite, step);
+    }
+
+    jscon_iter_destroy(&iter);
+}
+
+/* run query against root, cb is called for every matched item, in
+    order, until it returns false. returns the amount of matches */
+size_t
+jscon_query_exec(const jscon_query_t *query, jscon_item_t *root, jscon_query_cb *cb, void *context)
+{
+    DEBUG_ASSERT(NULL != query, "Missing query");
+
+    struct jscon_utils_s utils = {
+        .query = query,
+        .cb = cb,
+        .context = context,
+    };
+    _jscon_query_match(&utils, root, 0);
+
+    return utils.num_match;
+}
+
+static bool
+_jscon_query_first_cb(jscon_item_t *item, void *context)
+{
+    *(jscon_item_t**)context = item;
+    return false;
+}
+
+/* first item matched by query, or NULL if none */
+jscon_item_t*
+jscon_query_first(const jscon_query_t *query, jscon_item_t *root)
+{
+    jscon_item_t *first = NULL;
+    jscon_query_exec(query, root, &_jscon_query_first_cb, &first);
+
+    return first;
+}
+
+/* resolve a JSON Pointer, without keeping it compiled. returns NULL
+    if it is malformed, or out of memory */
+jscon_item_t*
+jscon_get_pointer(jscon_item_t *root, const char *pointer)
+{
+    DEBUG_ASSERT(NULL != pointer, "Missing JSON Pointer");
+    DEBUG_ASSERT('/' == *pointer || '\0' == *pointer, "JSON Pointer must start with '/'");
+
+    jscon_query_t *query = jscon_query_compile(pointer);
+    if (NULL == query) return NULL;
+
+    jscon_item_t *item = jscon_query_first(query, root);
+
+    jscon_query_destroy(query);
+
+    return item;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <libjscon.h>
+
+#include "jscon-common.h"
+#include "debug.h"
+
+
+/* fires event, stops parsing if callback returns false. arguments
+    are only evaluated if the callback is set */
+#define SAX_EVENT(sax, event, ...) \
+    do { \
+        if (NULL != (sax)->event && !(sax)->event(__VA_ARGS__)) return false; \
+    } while (0)
+
+/* composite stack, a bit set for each object, unset for arrays. it is
+    kept at a fixed size so memory use doesn't depend on the json text */
+struct jscon_sax_stack_s {
+    unsigned char is_object[MAX_DEPTH/CHAR_BIT];
+    size_t depth;
+};
+
+/* returns false if the nesting depth limit is reached */
+static bool
+_jscon_sax_push(struct jscon_sax_stack_s *stack, bool is_object)
+{
+    if (MAX_DEPTH == stack->depth) return false;
+
+    const size_t byte = stack->depth / CHAR_BIT;
+    const unsigned char mask = 1 << (stack->depth % CHAR_BIT);
+    if (is_object){
+        stack->is_object[byte] |= mask;
+    } else {
+        stack->is_object[byte] &= ~mask;
+    }
+    ++stack->depth;
+
+    return true;
+}
+
+/* whether the innermost composite is an object */
+static bool
+_jscon_sax_top(const struct jscon_sax_stack_s *stack)
+{
+    const size_t i = stack->depth - 1;
+    return stack->is_object[i / CHAR_BIT] & (1 << (i % CHAR_BIT));
+}
+
+/* reads the json text firing events for each token found, without ever
+    allocating memory. returns false if a callback stopped parsing, or
+    if the nesting depth limit is exceeded */
+bool
+jscon_sax_parse(char *buffer, const jscon_sax_t *sax, void *context)
+{
+    DEBUG_ASSERT(NULL != buffer, "Missing JSON text");
+    DEBUG_ASSERT(NULL != sax, "Missing SAX callbacks");
+
+    struct jscon_sax_stack_s stack;
+    stack.depth = 0;
+
+    CONSUME_BLANK_CHARS(buffer);
+    while (true){
+        /* 1st STEP: read a value, composites open a new level */
+        switch (*buffer){
+        case '{':/*OBJECT DETECTED*/
+            SAX_EVENT(sax, on_object_begin, context);
+            ++buffer;
+            CONSUME_BLANK_CHARS(buffer);
+            if ('}' == *buffer){ //empty object
+                ++buffer;
+                SAX_EVENT(sax, on_object_end, context);
+                break;
+            }
+            if (!_jscon_sax_push(&stack, true)) return false;
+            goto read_key;
+        case '[':/*ARRAY DETECTED*/
+            SAX_EVENT(sax, on_array_begin, context);
+            ++buffer;
+            CONSUME_BLANK_CHARS(buffer);
+            if (']' == *buffer){ //empty array
+                ++buffer;
+                SAX_EVENT(sax, on_array_end, context);
+                break;
+            }
+            if (!_jscon_sax_push(&stack, false)) return false;
+            continue;
+        case '\"':/*STRING DETECTED*/
+         {
+            size_t len;
+            char *string = Jscon_decode_string_inplace(&buffer, &len);
+            SAX_EVENT(sax, on_string, context, string, len);
+            break;
+         }
+        case 't':/*CHECK FOR*/
+        case 'f':/* BOOLEAN */
+            if (!STRNEQ(buffer,"true",4) && !STRNEQ(buffer,"false",5)){
+                goto token_error;
+            }
+         {
+            bool boolean = Jscon_decode_boolean(&buffer);
+            SAX_EVENT(sax, on_boolean, context, boolean);
+            break;
+         }
+        case 'n':/*CHECK FOR NULL*/
+            if (!STRNEQ(buffer,"null",4)){
+                goto token_error;
+            }
+            Jscon_decode_null(&buffer);
+            SAX_EVENT(sax, on_null, context);
+            break;
+        default:
+         { /*CHECK FOR NUMBER*/
+            if (!IS_DIGIT(*buffer) && '-' != *buffer){
+                goto token_error;
+            }
+
+            /* numbers are typed by their value, same as jscon_parse() */
+            long long i_number;
+            double d_number;
+            bool is_integer = Jscon_decode_number(&buffer, &i_number, &d_number);
+            if (!is_integer && DOUBLE_IS_INTEGER(d_number)){
+                i_number = (long long)d_number;
+                is_integer = true;
+            }
+
+            if (is_integer){
+                SAX_EVENT(sax, on_integer, context, i_number);
+            } else {
+                SAX_EVENT(sax, on_double, context, d_number);
+            }
+            break;
+         }
+        }
+
+        /* 2nd STEP: a value has been read, close every composite that
+            ends here and find out what comes next */
+        while (true){
+            if (0 == stack.depth) return true; //root value read
+
+            CONSUME_BLANK_CHARS(buffer);
+            if (',' == *buffer){
+                ++buffer;
+                CONSUME_BLANK_CHARS(buffer);
+                break;
+            }
+
+            if (_jscon_sax_top(&stack)){
+                if ('}' != *buffer) goto token_error;
+                --stack.depth;
+                ++buffer;
+                SAX_EVENT(sax, on_object_end, context);
+            } else {
+                if (']' != *buffer) goto token_error;
+                --stack.depth;
+                ++buffer;
+                SAX_EVENT(sax, on_array_end, context);
+            }
+        }
+
+        if (!_jscon_sax_top(&stack)) continue; //next array element
+
+read_key:
+        /* 3rd STEP: object members are preceded by their key */
+        if ('\"' != *buffer) goto token_error;
+        {
+            size_t len;
+            char *key = Jscon_decode_string_inplace(&buffer, &len);
+            SAX_EVENT(sax, on_key, context, key, len);
+        }
+        CONSUME_BLANK_CHARS(buffer);
+        DEBUG_ASSERT(':' == *buffer, "Missing ':' token after key"); //check for key's assign token 
+        ++buffer; //consume ':'
+        CONSUME_BLANK_CHARS(buffer);
+    }
+
+
+token_error:
+    DEBUG_ERR("Invalid '%c' token", *buffer);
+    return false;
+}
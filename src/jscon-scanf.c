@@ -33,81 +33,55 @@
 #include "strscpy.h"
 
 
-struct jscon_utils_s {
-    char *buffer;
-    char *key; //holds key ptr to be received by item
+/* a node of the key path tree generated from the format, where each
+    path segment (separated by '.') is a child of the previous segment.
+    root node is always at index 0, and every other node is either a
+    leaf (have a specifier) or a path to other nodes */
+struct jscon_scanf_node_s {
+    char *key; //path segment
+    size_t len;
+    size_t parent; //parent node index
+    enum jscon_specifier specifier; //JSCON_SPECIFIER_NONE if path
+    bool is_array; //specifier is followed by '*'
+    size_t arg; //argument index, if leaf
 };
 
-/* temp struct that will be stored at jscon_scanf dictionary */
-struct jscon_pair_s {
-    char specifier[5];
-    void *value;
+/* the precompiled format, nodes are retrieved by a perfect hash table
+    of their (parent, key) pair, which is generated at
+    jscon_scanf_compile(). the plan is never modified afterwards, so
+    it can be shared between threads */
+struct jscon_scanf_plan_s {
+    struct jscon_scanf_node_s *node;
+    size_t num_node;
+    size_t *leaf; //leaf nodes, in the same order as the arguments
+    size_t num_leaf;
+
+    size_t *slot; //node index, 0 (root) if slot is empty
+    size_t num_slot; //always a power of 2
+    unsigned long seed;
+
+    char *text; //keys storage
 };
 
-inline static void
-_jscon_skip_string(struct jscon_utils_s *utils)
-{
-    /* loops until null terminator or end of string are found */
-    do {
-        /* skips escaped characters */
-        if ('\\' == *utils->buffer++){
-            ++utils->buffer;
-        }
-    } while ('\0' != *utils->buffer && '\"' != *utils->buffer);
-    DEBUG_ASSERT('\"' == *utils->buffer, "Not a String");
-    ++utils->buffer; //skip double quotes
-}
-
-inline static void
-_jscon_skip_composite(int ldelim, int rdelim, struct jscon_utils_s *utils)
-{
-    /* skips the item and all of its nests, special care is taken for any
-        inner string is found, as it might contain a delim character that
-        if not treated as a string will incorrectly trigger 
-        depth action*/
-    size_t depth = 0;
-    do {
-        if (ldelim == *utils->buffer){
-            ++depth;
-            ++utils->buffer; //skips ldelim char
-        } else if (rdelim == *utils->buffer) {
-            --depth;
-            ++utils->buffer; //skips rdelim char
-        } else if ('\"' == *utils->buffer) { //treat string separetely
-            _jscon_skip_string(utils);
-        } else {
-            ++utils->buffer; //skips whatever char
-        }
-
-        if (0 == depth) return; //entire item has been skipped, return
-
-    } while ('\0' != *utils->buffer);
-}
+/* the arguments of a leaf, as fetched from the va_list */
+struct jscon_scanf_arg_s {
+    void *value;
+    size_t capacity; //array specifier only
+    size_t *p_count; //array specifier only
+    bool assigned; //whether argument has been assigned already
+};
 
-static void
-_jscon_skip(struct jscon_utils_s *utils)
-{
-    switch (*utils->buffer){
-    case '{':/*OBJECT DETECTED*/
-        _jscon_skip_composite('{', '}', utils);
-        return;
-    case '[':/*ARRAY DETECTED*/
-        _jscon_skip_composite('[', ']', utils);
-        return;
-    case '\"':/*STRING DETECTED*/
-        _jscon_skip_string(utils);
-        return;
-    default:
-        //consume characters while not end of string or not new key
-        while ('\0' != *utils->buffer && ',' != *utils->buffer){
-            ++utils->buffer;
-        }
-        return;
-    }
-}
+struct jscon_utils_s {
+    char *buffer;
+    char *key; //current key position (not nul terminated)
+    size_t key_len;
+    const jscon_scanf_plan_t *plan;
+    struct jscon_scanf_arg_s *arg; //in the same order as the format
+    size_t num_pending; //amount of arguments not yet assigned
+};
 
 static char*
-_jscon_format_info(char *specifier, size_t *p_tmp)
+_jscon_format_info(enum jscon_specifier specifier, size_t *p_tmp)
 {
     size_t *n_bytes;
     size_t discard; //throw values here if p_tmp is NULL
@@ -117,66 +91,53 @@ _jscon_format_info(char *specifier, size_t *p_tmp)
         n_bytes = &discard;
     }
 
-    if (STREQ(specifier, "c")){
-        *n_bytes = sizeof(char);
-        return "char*";
-    }
-    if (STREQ(specifier, "s")){
+    switch (specifier){
+    case JSCON_SPECIFIER_CHAR:
+    case JSCON_SPECIFIER_STRING:
         *n_bytes = sizeof(char);
         return "char*";
-    }
-    if (STREQ(specifier, "d")){
+    case JSCON_SPECIFIER_INT:
         *n_bytes = sizeof(int);
         return "int*";
-    }
-    if (STREQ(specifier, "ld")){
+    case JSCON_SPECIFIER_LONG:
         *n_bytes = sizeof(long);
         return "long*";
-    }
-    if (STREQ(specifier, "lld")){
+    case JSCON_SPECIFIER_LLONG:
         *n_bytes = sizeof(long long);
         return "long long*";
-    }
-    if (STREQ(specifier, "f")){
+    case JSCON_SPECIFIER_FLOAT:
         *n_bytes = sizeof(float);
         return "float*";
-    }
-    if (STREQ(specifier, "lf")){
+    case JSCON_SPECIFIER_DOUBLE:
         *n_bytes = sizeof(double);
         return "double*";
-    }
-    if (STREQ(specifier, "b")){
+    case JSCON_SPECIFIER_BOOLEAN:
         *n_bytes = sizeof(bool);
         return "bool*";
-    }
-    if (STREQ(specifier, "ji")){
+    case JSCON_SPECIFIER_ITEM:
         /* this will never get validated at _jscon_apply(),
           but it doesn't matter, a JSCON_NULL item is created either way */
         *n_bytes = sizeof(jscon_item_t*);
         return "jscon_item_t**";
+    default:
+        *n_bytes = 0;
+        return "NaN";
     }
-
-    *n_bytes = 0;
-    return "NaN";
 }
 
 static void
-_jscon_apply(struct jscon_utils_s *utils, struct jscon_pair_s *pair)
+_jscon_apply(struct jscon_utils_s *utils, enum jscon_specifier specifier, void *value)
 {
-    char *specifier = pair->specifier;
-    void *value = pair->value;
-      
-
     /* if specifier is item, simply call jscon_parse at current buffer token */
-    if (STREQ(specifier, "ji")){
+    if (JSCON_SPECIFIER_ITEM == specifier){
         jscon_item_t **item = value;
         *item = jscon_parse(utils->buffer);
-        _jscon_skip(utils); //skip characters parsed by jscon_parse
+        utils->buffer = Jscon_skip_value(utils->buffer); //skip characters parsed by jscon_parse
 
         /* get key, but keep in mind that this item is an "entity". The key will
           be ignored when serializing with jscon_stringify(); */
-        (*item)->key = utils->key;
-        utils->key = NULL;
+        Jscon_item_set_key(*item, utils->key, utils->key_len);
+        DEBUG_ASSERT(NULL != (*item)->key, "Out of memory");
         return;
     }
 
@@ -184,14 +145,15 @@ _jscon_apply(struct jscon_utils_s *utils, struct jscon_pair_s *pair)
     char err_typeis[50];
     switch (*utils->buffer){
     case '\"':/*STRING DETECTED*/
-        if (STREQ(specifier, "c")){
-            char *string = Jscon_decode_string(&utils->buffer);
-            strscpy(value, string, sizeof(char));
-            free(string);
-        } else if (STREQ(specifier, "s")){
-            char *string = Jscon_decode_string(&utils->buffer);
-            strscpy(value, string, strlen(string)+1);
-            free(string);
+        if (JSCON_SPECIFIER_CHAR == specifier){
+            size_t len;
+            char *string = Jscon_decode_string_inplace(&utils->buffer, &len);
+            *(char*)value = (0 != len) ? *string : '\0';
+        } else if (JSCON_SPECIFIER_STRING == specifier){
+            size_t len;
+            char *string = Jscon_decode_string_inplace(&utils->buffer, &len);
+            memcpy(value, string, len);
+            ((char*)value)[len] = '\0';
         } else {
             char reason[] = "char* or jscon_item_t**";
             strscpy(err_typeis, reason, sizeof(err_typeis));
@@ -205,7 +167,7 @@ _jscon_apply(struct jscon_utils_s *utils, struct jscon_pair_s *pair)
             goto token_error;
         }
 
-        if (STREQ(specifier, "b")){
+        if (JSCON_SPECIFIER_BOOLEAN == specifier){
             bool *boolean = value;
             *boolean = Jscon_decode_boolean(&utils->buffer);
         } else {
@@ -242,53 +204,162 @@ _jscon_apply(struct jscon_utils_s *utils, struct jscon_pair_s *pair)
             goto token_error;
         }
 
-        double tmp = Jscon_decode_double(&utils->buffer);
-        if (DOUBLE_IS_INTEGER(tmp)){
-            if (STREQ(specifier, "d")){
-                int *number_i = value;
-                *number_i = (int)tmp;
-            } else if (STREQ(specifier, "ld")){
-                long *number_i = value;
-                *number_i = (long)tmp;
-            } else if (STREQ(specifier, "lld")){
-                long long *number_i = value;
-                *number_i = (long long)tmp;
-            } else {
-                char reason[] = "short*, int*, long*, long long* or jscon_item_t**";
-                strscpy(err_typeis, reason, sizeof(err_typeis));
-                goto type_error;
-            }
-        } else {
-            if (STREQ(specifier, "f")){
-                float *number_d = value; 
-                *number_d = (float)tmp;
-            } else if (STREQ(specifier, "lf")){
-                double *number_d = value; 
-                *number_d = tmp;
-            } else {
-                char reason[] = "float*, double* or jscon_item_t**";
-                strscpy(err_typeis, reason, sizeof(err_typeis));
-                goto type_error;
-            }
+        long long i_number;
+        double d_number;
+        bool is_integer = Jscon_decode_number(&utils->buffer, &i_number, &d_number);
+        if (!is_integer && DOUBLE_IS_INTEGER(d_number)){
+            i_number = (long long)d_number;
+            is_integer = true;
+        }
+
+        switch (specifier){
+        case JSCON_SPECIFIER_INT:
+            if (!is_integer) goto integer_error;
+            *(int*)value = (int)i_number;
+            break;
+        case JSCON_SPECIFIER_LONG:
+            if (!is_integer) goto integer_error;
+            *(long*)value = (long)i_number;
+            break;
+        case JSCON_SPECIFIER_LLONG:
+            if (!is_integer) goto integer_error;
+            *(long long*)value = i_number;
+            break;
+        /* integers are converted to floating point */
+        case JSCON_SPECIFIER_FLOAT:
+            *(float*)value = (float)d_number;
+            break;
+        case JSCON_SPECIFIER_DOUBLE:
+            *(double*)value = d_number;
+            break;
+        default:
+         {
+            char reason[] = "int*, long*, long long*, float*, double* or jscon_item_t**";
+            strscpy(err_typeis, reason, sizeof(err_typeis));
+            goto type_error;
+         }
         }
 
         return;
+
+integer_error:
+     {
+        char reason[] = "float*, double* or jscon_item_t**";
+        strscpy(err_typeis, reason, sizeof(err_typeis));
+        goto type_error;
+     }
+        return;
      }
     }
 
 
 type_error:
-    DEBUG_ERR("Expected specifier %s but specifier is %s( found: \"%s\" )\n", err_typeis, _jscon_format_info(specifier, NULL), specifier);
+    DEBUG_ERR("Expected specifier %s but specifier is %s\n", err_typeis, _jscon_format_info(specifier, NULL));
 
 token_error:
     DEBUG_ERR("Invalid JSON Token: %c", *utils->buffer);
 }
 
-/* count amount of keys and check for formatting errors */
-static size_t
-_jscon_format_analyze(char *format)
+/* fills the caller array with the elements of the json array found at
+    buffer, no item is created for its elements. elements that exceed
+    capacity are skipped, but still accounted for at p_count */
+static void
+_jscon_apply_array(struct jscon_utils_s *utils, enum jscon_specifier specifier, struct jscon_scanf_arg_s *arg)
+{
+    if ('n' == *utils->buffer && STRNEQ(utils->buffer, "null", 4)){
+        Jscon_decode_null(&utils->buffer);
+        *arg->p_count = 0;
+        return;
+    }
+    if ('[' != *utils->buffer){
+        DEBUG_ERR("Expected a JSCON_ARRAY for %%%s*\n\t"
+                  "Found: '%c'", _jscon_format_info(specifier, NULL), *utils->buffer);
+    }
+    ++utils->buffer; //skips '['
+
+    size_t n_bytes; //element size
+    _jscon_format_info(specifier, &n_bytes);
+
+    char numerical_key[MAX_DIGITS+4];
+    size_t count = 0;
+    while (true){
+        CONSUME_BLANK_CHARS(utils->buffer);
+        switch (*utils->buffer){
+        case ']':/*ARRAY WRAPPER DETECTED*/
+            ++utils->buffer;
+            *arg->p_count = count;
+            return;
+        case ',':/*NEXT ELEMENT TOKEN*/
+            ++utils->buffer;
+            continue;
+        case '\0':
+            DEBUG_ERR("Bad formatting");
+            *arg->p_count = count;
+            return;
+        default:
+            break;
+        }
+
+        if (count >= arg->capacity){
+            utils->buffer = Jscon_skip_value(utils->buffer);
+            ++count;
+            continue;
+        }
+
+        /* fast path for numerical elements, the most common case */
+        if (IS_DIGIT(*utils->buffer) || '-' == *utils->buffer){
+            long long i_number;
+            double d_number;
+            switch (specifier){
+            case JSCON_SPECIFIER_DOUBLE:
+                Jscon_decode_number(&utils->buffer, &i_number, &d_number);
+                ((double*)arg->value)[count++] = d_number;
+                continue;
+            case JSCON_SPECIFIER_FLOAT:
+                Jscon_decode_number(&utils->buffer, &i_number, &d_number);
+                ((float*)arg->value)[count++] = (float)d_number;
+                continue;
+            case JSCON_SPECIFIER_LLONG:
+                if (Jscon_decode_number(&utils->buffer, &i_number, &d_number)){
+                    ((long long*)arg->value)[count++] = i_number;
+                    continue;
+                }
+                if (!DOUBLE_IS_INTEGER(d_number)){
+                    DEBUG_ERR("Expected specifier float*, double* or jscon_item_t** but specifier is long long*");
+                }
+                ((long long*)arg->value)[count++] = (long long)d_number;
+                continue;
+            default: //let _jscon_apply() deal with it
+                break;
+            }
+        }
+
+        void *element;
+        switch (specifier){
+        case JSCON_SPECIFIER_STRING: //array of char buffers
+            element = ((char**)arg->value)[count];
+            break;
+        case JSCON_SPECIFIER_ITEM: //item receives its numerical key
+            utils->key = numerical_key;
+            utils->key_len = Jscon_encode_integer(count, numerical_key);
+        /* fall through */
+        default:
+            element = (char*)arg->value + count * n_bytes;
+            break;
+        }
+
+        _jscon_apply(utils, specifier, element);
+        ++count;
+    }
+}
+
+/* count amount of keys and their path segments, returns false if the
+    format is malformed (the format must then be rejected) */
+static bool
+_jscon_format_analyze(char *format, size_t *p_num_keys, size_t *p_num_segment)
 {
     size_t num_keys = 0;
+    size_t num_segment = 0;
     while (true) //run until end of string found
     {
         /* 1st STEP: find % occurrence */
@@ -298,60 +369,82 @@ _jscon_format_analyze(char *format)
                 break;
             }
             if ('\0' == *format){
-                DEBUG_ASSERT(num_keys != 0, "No type specifiers from format");
-                return num_keys;
+                *p_num_keys = num_keys;
+                *p_num_segment = num_segment;
+                return (0 != num_keys); //no type specifiers from format
             }
-            DEBUG_ASSERT(']' != *format, "Found extra ']' in key specifier");
+            if (']' == *format) return false; //extra ']' in key specifier
 
             ++format;
         }
 
         /* 2nd STEP: check specifier validity */
-        while (true){
-            if ('[' == *format){
-                ++format;
-                break;
-            }
-            if ('\0' == *format){
-                DEBUG_ERR("Missing format '[' key prefix\n\t"\
-                        "Found: '%c'", *format);
-            }
-            if (!isalpha(*format)){
-                DEBUG_ERR("Unknown type specifier character\n\t"
-                        "Found: '%c'", *format);
+        char *spec_start = format;
+        while ('[' != *format){
+            if ('\0' == *format) return false; //missing '[' key prefix
+            if (!isalpha(*format) && !('*' == *format && '[' == format[1])){
+                return false; //unknown type specifier character
             }
             ++format;
         }
 
-        /* 3rd STEP: check key validity */
-        while (true){
-            if (']' == *format){
-                ++format;
-                break;
-            }
-            if ('\0' == *format){
-                DEBUG_ERR("Missing format ']' key suffix\n\t"\
-                        "Found: '%c'", *format);
+        bool is_array = (format > spec_start && '*' == format[-1]);
+        if (JSCON_SPECIFIER_NONE == Jscon_specifier_decode(spec_start, format - spec_start - is_array)){
+            return false; //unknown type specifier
+        }
+        ++format; //skips '['
+
+        /* 3rd STEP: check key validity, and count its path segments */
+        ++num_segment;
+        while (']' != *format){
+            if ('\0' == *format) return false; //missing ']' key suffix
+            if ('.' == *format){
+                ++num_segment;
             }
             ++format;
         }
+        ++format; //skips ']'
 
         ++num_keys;
     }
 }
 
-static void
-_jscon_format_decode(char *format, dictionary_t *dictionary, va_list ap)
+/* get child node of parent with matching key, create it if it doesn't
+    exist yet. this is only used while compiling, lookups performed
+    during execution are done through the perfect hash table */
+static size_t
+_jscon_plan_child(jscon_scanf_plan_t *plan, size_t parent, char *key, size_t len, char **p_text)
 {
-    /* Can't decode empty string */
-    DEBUG_ASSERT('\0' != *format, "Empty format");
+    for (size_t i=1; i < plan->num_node; ++i){
+        struct jscon_scanf_node_s *node = &plan->node[i];
+        if (parent == node->parent && len == node->len && STRNEQ(node->key, key, len)){
+            return i;
+        }
+    }
+
+    struct jscon_scanf_node_s *new_node = &plan->node[plan->num_node];
+    new_node->key = memcpy(*p_text, key, len);
+    new_node->key[len] = '\0';
+    new_node->len = len;
+    new_node->parent = parent;
+    new_node->specifier = JSCON_SPECIFIER_NONE;
 
-    char str[256];
+    *p_text += len + 1;
 
-    struct jscon_pair_s *pair;
+    return plan->num_node++;
+}
+
+/* split keys from its type specifier and store them at plan as a
+    tree of key path segments */
+static bool
+_jscon_format_decode(char *format, jscon_scanf_plan_t *plan)
+{
+    char *text = plan->text;
 
-    /* split keys from its type specifier */
-    size_t i; /* str char index */
+    /* root node */
+    plan->node[0] = (struct jscon_scanf_node_s){ .key = "" };
+    plan->num_node = 1;
+    plan->num_leaf = 0;
     while (true) /* run until end of string found */
     {
         /* 1st STEP: find % occurrence */
@@ -361,117 +454,350 @@ _jscon_format_decode(char *format, dictionary_t *dictionary, va_list ap)
                 break;
             }
             if ('\0' == *format){
-                return;
+                return true;
             }
             ++format;
         }
 
-        i = 0;
+        /* 2nd STEP: fetch type specifier, already checked by
+            _jscon_format_analyze() */
+        char *spec_start = format;
+        while ('[' != *format){
+            ++format;
+        }
 
-        /* 2nd STEP: fetch type specifier */
-        while (true){
-            ++i;
-            DEBUG_ASSERT(i <= sizeof(str), "Buffer overflow");
+        bool is_array = ('*' == format[-1]); //ex: "%lf*[key]"
 
-            if ('[' == *format){
+        enum jscon_specifier specifier = Jscon_specifier_decode(spec_start, format - spec_start - is_array);
+        ++format; //skips '['
+
+        /* 3rd STEP: type specifier is formed, proceed to walk the key
+            path, creating every segment node that's missing */
+        size_t node = 0;
+        while (true){
+            char *key_start = format;
+            while (']' != *format && '.' != *format){
                 ++format;
-                str[i-1] = '\0';
-                break;
             }
 
-            str[i-1] = *format++;
+            if (JSCON_SPECIFIER_NONE != plan->node[node].specifier){
+                return false; //key is both a value and a path
+            }
+            node = _jscon_plan_child(plan, node, key_start, format - key_start, &text);
+
+            if (']' == *format) break;
+
+            ++format; //skips '.'
         }
 
-        /* 3rd STEP: type specifier is formed, proceed to fetch the key */
-        while(true) {
-            if (']' == *format){
-                str[i] = '\0';
-                break;
+        /* 4th STEP: last segment is the leaf that receives the argument */
+        struct jscon_scanf_node_s *leaf = &plan->node[node];
+        if (JSCON_SPECIFIER_NONE != leaf->specifier){
+            return false; //duplicate key in format
+        }
+        for (size_t i=node+1; i < plan->num_node; ++i){
+            if (node == plan->node[i].parent){
+                return false; //key is both a value and a path
             }
-
-            str[i] = *format++;
-            ++i;
-            DEBUG_ASSERT(i <= sizeof(str), "Buffer overflow");
         }
+        leaf->specifier = specifier;
+        leaf->is_array = is_array;
+        leaf->arg = plan->num_leaf;
+        plan->leaf[plan->num_leaf++] = node;
+    }
+}
+
+/* FNV-1a variant, the seed and the parent node are mixed in so that
+    different seeds can be tried until a collision free table is found */
+static inline size_t
+_jscon_plan_hash(unsigned long seed, size_t parent, const char *key, size_t len)
+{
+    size_t hash = 14695981039346656037ULL ^ seed ^ (parent * 0x9E3779B97F4A7C15ULL);
+    for (size_t i=0; i < len; ++i){
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash ^ (hash >> 29);
+}
+
+/* try seeds until every node occupy a different slot, the table
+    doubles its size if no seed is found after a few attempts */
+static bool
+_jscon_plan_build_hash(jscon_scanf_plan_t *plan)
+{
+    plan->num_slot = 2;
+    while (plan->num_slot < 2 * plan->num_node){
+        plan->num_slot <<= 1;
+    }
 
-        /* 4th STEP: store extracted specifier/value in a 
-        *  struct jscon_pair_s, then assign that pair with its matching
-        *  key and store it in a dictionary for later retrieval */
-        pair = malloc(sizeof *pair);
-        DEBUG_ASSERT(NULL != pair, "Out of memory");
+    while (true){
+        size_t *slot = Jscon_calloc(plan->num_slot, sizeof *slot, JSCON_ALLOC_OTHER);
+        if (NULL == slot) return false;
 
-        strscpy(pair->specifier, str, sizeof(pair->specifier)); //get specifier string
-        if (STREQ("NaN", _jscon_format_info(pair->specifier, NULL))){
-            DEBUG_ERR("Unknown type specifier %%%s", pair->specifier);
+        for (plan->seed = 0; plan->seed < 64; ++plan->seed){
+            size_t i;
+            for (i=1; i < plan->num_node; ++i){
+                struct jscon_scanf_node_s *node = &plan->node[i];
+                size_t index = _jscon_plan_hash(plan->seed, node->parent, node->key, node->len) & (plan->num_slot-1);
+                if (0 != slot[index]) break;
+
+                slot[index] = i;
+            }
+            if (i == plan->num_node){ //no collision found
+                plan->slot = slot;
+                return true;
+            }
+            memset(slot, 0, plan->num_slot * sizeof *slot);
         }
 
-        pair->value = va_arg(ap, void*);
+        Jscon_free(slot);
+        plan->num_slot <<= 1;
+    }
+}
+
+/* returns index of parent's child node with matching key, 0 if not found */
+static inline size_t
+_jscon_plan_lookup(const jscon_scanf_plan_t *plan, size_t parent, const char *key, size_t len)
+{
+    size_t index = _jscon_plan_hash(plan->seed, parent, key, len) & (plan->num_slot-1);
 
-        dictionary_set(dictionary, &str[strlen(str)+1], pair, &free);
+    const struct jscon_scanf_node_s *match = &plan->node[plan->slot[index]];
+    if (parent != match->parent || len != match->len || 0 != memcmp(match->key, key, len)){
+        return 0;
     }
+
+    return plan->slot[index];
 }
 
-/* works like sscanf, will parse stuff only for the keys specified to the format string parameter. the variables assigned to ... must be in
-the correct order, and type, as the requested keys.
+jscon_scanf_plan_t*
+jscon_scanf_compile(char *format)
+{
+    DEBUG_ASSERT(NULL != format, "Missing format");
+
+    size_t num_key, num_segment;
+    if (!_jscon_format_analyze(format, &num_key, &num_segment)) return NULL;
+    size_t num_node = 1 + num_segment;
+    size_t text_len = strlen(format); //upper bound for keys storage
+
+    jscon_scanf_plan_t *plan = Jscon_malloc(sizeof *plan
+                                      + num_node * sizeof *plan->node
+                                      + num_key * sizeof *plan->leaf
+                                      + text_len, JSCON_ALLOC_OTHER);
+    if (NULL == plan) return NULL;
+
+    plan->node = (struct jscon_scanf_node_s*)(plan + 1);
+    plan->leaf = (size_t*)(plan->node + num_node);
+    plan->text = (char*)(plan->leaf + num_key);
+
+    if (!_jscon_format_decode(format, plan) || !_jscon_plan_build_hash(plan)){
+        Jscon_free(plan);
+        return NULL;
+    }
+
+    return plan;
+}
 
-    every key found that doesn't match any of the requested keys will be
-    ignored along with all its contents. */
 void
-jscon_scanf(char *buffer, char *format, ...)
+jscon_scanf_destroy(jscon_scanf_plan_t *plan)
+{
+    Jscon_free(plan->slot);
+    Jscon_free(plan);
+}
+
+static void _jscon_scan_composite(struct jscon_utils_s *utils, size_t parent);
+
+/* value of a node found at the document, apply it if node is a leaf,
+    descend into it if node is a path, otherwise skip it */
+static void
+_jscon_scan_value(struct jscon_utils_s *utils, size_t node)
+{
+    if (0 == node){ //not requested
+        utils->buffer = Jscon_skip_value(utils->buffer);
+        return;
+    }
+
+    const struct jscon_scanf_node_s *match = &utils->plan->node[node];
+    if (JSCON_SPECIFIER_NONE != match->specifier){
+        struct jscon_scanf_arg_s *arg = &utils->arg[match->arg];
+        if (match->is_array){
+            _jscon_apply_array(utils, match->specifier, arg);
+        } else {
+            _jscon_apply(utils, match->specifier, arg->value);
+        }
+
+        if (!arg->assigned){
+            arg->assigned = true;
+            --utils->num_pending;
+        }
+        return;
+    }
+
+    if ('{' == *utils->buffer || '[' == *utils->buffer){
+        _jscon_scan_composite(utils, node);
+        return;
+    }
+
+    utils->buffer = Jscon_skip_value(utils->buffer); //path doesn't match document's layout
+}
+
+static void
+_jscon_scan_object(struct jscon_utils_s *utils, size_t parent)
+{
+    ++utils->buffer; //skips '{'
+    while (true){
+        CONSUME_BLANK_CHARS(utils->buffer);
+        switch (*utils->buffer){
+        case '}':/*OBJECT WRAPPER DETECTED*/
+            ++utils->buffer;
+            return;
+        case ',':/*NEXT PROPERTY TOKEN*/
+            ++utils->buffer;
+            break;
+        case '\"':/*KEY STRING DETECTED*/
+         {
+            /* key is matched in place, no copy is made */
+            char *key = Jscon_decode_string_inplace(&utils->buffer, &utils->key_len);
+            utils->key = key;
+
+            CONSUME_BLANK_CHARS(utils->buffer);
+            DEBUG_ASSERT(':' == *utils->buffer, "Missing ':' token after key"); //check for key's assign token 
+            ++utils->buffer; //consume ':'
+            CONSUME_BLANK_CHARS(utils->buffer);
+
+            /* check whether key found is specified */
+            size_t node = _jscon_plan_lookup(utils->plan, parent, key, utils->key_len);
+            _jscon_scan_value(utils, node);
+
+            /* every argument has been assigned, stop scanning */
+            if (0 == utils->num_pending) return;
+            break;
+         }
+        default:
+            DEBUG_ERR("Invalid '%c' token", *utils->buffer);
+            return;
+        }
+    }
+}
+
+static void
+_jscon_scan_array(struct jscon_utils_s *utils, size_t parent)
+{
+    ++utils->buffer; //skips '['
+
+    size_t index = 0;
+    while (true){
+        CONSUME_BLANK_CHARS(utils->buffer);
+        switch (*utils->buffer){
+        case ']':/*ARRAY WRAPPER DETECTED*/
+            ++utils->buffer;
+            return;
+        case ',':/*NEXT ELEMENT TOKEN*/
+            ++utils->buffer;
+            ++index;
+            break;
+        case '\0':
+            DEBUG_ERR("Bad formatting");
+            return;
+        default:
+         {
+            /* elements are matched by their numerical key */
+            char numerical_key[MAX_DIGITS+4];
+            size_t len = Jscon_encode_integer(index, numerical_key);
+
+            utils->key = numerical_key;
+            utils->key_len = len;
+
+            size_t node = _jscon_plan_lookup(utils->plan, parent, numerical_key, len);
+            _jscon_scan_value(utils, node);
+
+            /* every argument has been assigned, stop scanning */
+            if (0 == utils->num_pending) return;
+            break;
+         }
+        }
+    }
+}
+
+/* walks through composite members, only descending into the ones that
+    are part of a requested key path, everything else is skipped */
+static void
+_jscon_scan_composite(struct jscon_utils_s *utils, size_t parent)
+{
+    switch (*utils->buffer){
+    case '{':
+        _jscon_scan_object(utils, parent);
+        return;
+    case '[':
+        _jscon_scan_array(utils, parent);
+        return;
+    default:
+        DEBUG_ERR("Item type must be a JSCON_OBJECT or JSCON_ARRAY");
+    }
+}
+
+static void
+_jscon_scanf_vexec(const jscon_scanf_plan_t *plan, char *buffer, va_list ap)
 {
     DEBUG_ASSERT(NULL != buffer, "Missing JSON text");
 
     CONSUME_BLANK_CHARS(buffer);
 
-    if ('{' != *buffer){
-        DEBUG_ERR("Item type must be a JSCON_OBJECT");
+    /* fetch arguments, in the same order as the keys */
+    struct jscon_scanf_arg_s arg[plan->num_leaf];
+    for (size_t i=0; i < plan->num_leaf; ++i){
+        arg[i].value = va_arg(ap, void*);
+        if (plan->node[plan->leaf[i]].is_array){
+            arg[i].capacity = va_arg(ap, size_t);
+            arg[i].p_count = va_arg(ap, size_t*);
+        }
+        arg[i].assigned = false;
     }
 
     struct jscon_utils_s utils = {
         .buffer = buffer,
+        .plan = plan,
+        .arg = arg,
+        .num_pending = plan->num_leaf,
     };
 
+    _jscon_scan_composite(&utils, 0);
+}
+/* same as jscon_scanf(), but with a precompiled format */
+void
+jscon_scanf_exec(const jscon_scanf_plan_t *plan, char *buffer, ...)
+{
     va_list ap;
-    va_start(ap, format);
+    va_start(ap, buffer);
 
-    size_t num_key = _jscon_format_analyze(format);
+    _jscon_scanf_vexec(plan, buffer, ap);
 
-    /* key/value dictionary fetched from format */
-    dictionary_t *dictionary = dictionary_init();
-    dictionary_build(dictionary, num_key);
+    va_end(ap);
+}
 
-    //return keys for freeing later
-    _jscon_format_decode(format, dictionary, ap);
-    DEBUG_ASSERT(num_key == dictionary->len, "Number of keys encountered is different than allocated");
+void
+jscon_vscanf(char *buffer, char *format, va_list ap)
+{
+    jscon_scanf_plan_t *plan = jscon_scanf_compile(format);
+    if (NULL == plan) return; //malformed format, nothing is assigned
 
-    while ('\0' != *utils.buffer)
-    {
-        if ('\"' == *utils.buffer){
-            DEBUG_ASSERT(NULL == utils.key, "utils.key wasn't freed");
-            utils.key = Jscon_decode_string(&utils.buffer);
-            DEBUG_ASSERT(':' == *utils.buffer, "Missing ':' token after key"); //check for key's assign token 
+    _jscon_scanf_vexec(plan, buffer, ap);
 
-            ++utils.buffer; //consume ':'
-            CONSUME_BLANK_CHARS(utils.buffer);
+    jscon_scanf_destroy(plan);
+}
 
-            /* check whether key found is specified */
-            struct jscon_pair_s *pair = dictionary_get(dictionary, utils.key);
-            if (NULL != pair){
-                _jscon_apply(&utils, pair);
-            } else {
-                _jscon_skip(&utils);
-            }
+/* works like sscanf, will parse stuff only for the keys specified to the format string parameter. the variables assigned to ... must be in
+the correct order, and type, as the requested keys.
 
-            if (NULL != utils.key){
-                free(utils.key);
-                utils.key = NULL;
-            }
-        } else {
-            ++utils.buffer;
-        }
-    }
+    every key found that doesn't match any of the requested keys will be
+    ignored along with all its contents. */
+void
+jscon_scanf(char *buffer, char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
 
-    dictionary_destroy(dictionary);
+    jscon_vscanf(buffer, format, ap);
 
     va_end(ap);
 }
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include <libjscon.h>
+#include "jscon-common.h"
+
+#include "debug.h"
+
+
+/* JSCON VERSION
+ * a published, read-only state of the store tree
+ * tape: the tree as it was frozen when published
+ * number: amount of versions published before it, plus one
+ * refcount: the store and every reader holding it count as one */
+struct jscon_version_s {
+    jscon_tape_t *tape;
+    size_t number;
+    size_t refcount;
+};
+
+/* JSCON STORE
+ * a tree edited by a single writer, whose versions are read by any
+ * amount of readers without locking
+ * root: the writer tree, only touched by the writer
+ * current: latest version published, swapped atomically
+ * num_version: amount of versions published
+ * epoch: which of num_acquiring new readers count themselves at
+ * num_acquiring: readers that may have loaded current, but have yet
+ *      to count themselves at its refcount. by flipping epoch and
+ *      waiting for the previous epoch count to drain, a writer knows
+ *      no reader is about to take a version it releases */
+struct jscon_store_s {
+    jscon_item_t *root;
+    jscon_version_t *current;
+    size_t num_version;
+
+    unsigned int epoch;
+    size_t num_acquiring[2];
+};
+
+static void
+_jscon_version_destroy(jscon_version_t *version)
+{
+    jscon_tape_destroy(version->tape);
+    Jscon_free(version);
+}
+
+/* the tree is given to the store, which publishes it as the first
+    version. if that fails, the tree is left to the caller */
+jscon_store_t*
+jscon_store_init(jscon_item_t *root)
+{
+    DEBUG_ASSERT(NULL != root, "Missing item");
+    DEBUG_ASSERT(!IS_READONLY(root), "Item is owned by a parser");
+
+    jscon_store_t *new_store = Jscon_calloc(1, sizeof *new_store, JSCON_ALLOC_OTHER);
+    if (NULL == new_store) return NULL;
+
+    new_store->root = root;
+    if (0 == jscon_store_publish(new_store)){
+        Jscon_free(new_store);
+        return NULL;
+    }
+
+    return new_store;
+}
+
+/* versions still held by readers outlive the store, until released */
+void
+jscon_store_destroy(jscon_store_t *store)
+{
+    if (NULL == store) return;
+
+    jscon_version_release(store->current);
+    jscon_destroy(store->root);
+    Jscon_free(store);
+}
+
+/* the writer tree, edits made to it are only seen by readers once
+    published */
+jscon_item_t*
+jscon_store_get_root(jscon_store_t *store){
+    return store->root;
+}
+
+/* freeze the writer tree into a new version, and make it the one
+    readers acquire. returns the new version number, or 0 if the tree
+    couldn't be frozen, in which case the current version is kept.
+    the whole tree is frozen each time, so a publish costs O(document)
+    no matter how small the edits were, versions share nothing */
+size_t
+jscon_store_publish(jscon_store_t *store)
+{
+    jscon_version_t *new_version = Jscon_malloc(sizeof *new_version, JSCON_ALLOC_OTHER);
+    if (NULL == new_version) return 0;
+
+    new_version->tape = jscon_freeze(store->root);
+    if (NULL == new_version->tape){
+        Jscon_free(new_version);
+        return 0;
+    }
+    new_version->number = ++store->num_version;
+    new_version->refcount = 1; //held by store
+
+    jscon_version_t *old_version = __atomic_exchange_n(&store->current, new_version, __ATOMIC_SEQ_CST);
+    if (NULL == old_version) return new_version->number;
+
+    /* readers from now on count at the new epoch, and will only see
+        new_version. wait for those that may have seen old_version,
+        giving the cpu away meanwhile, as a reader preempted while
+        counted would otherwise keep the writer spinning */
+    unsigned int epoch = __atomic_fetch_xor(&store->epoch, 1, __ATOMIC_SEQ_CST);
+    while (0 != __atomic_load_n(&store->num_acquiring[epoch], __ATOMIC_SEQ_CST)){
+        sched_yield();
+    }
+
+    jscon_version_release(old_version);
+
+    return new_version->number;
+}
+
+/* take a reference to the latest version, which stays valid until
+    released, no matter how many versions are published meanwhile */
+jscon_version_t*
+jscon_store_acquire(jscon_store_t *store)
+{
+    /* the epoch may be flipped before the reader counts itself, and a
+        writer waiting on the other epoch would miss it. count again
+        until the epoch counted at is still the current one */
+    unsigned int epoch = __atomic_load_n(&store->epoch, __ATOMIC_SEQ_CST);
+    while (1){
+        __atomic_add_fetch(&store->num_acquiring[epoch], 1, __ATOMIC_SEQ_CST);
+
+        unsigned int new_epoch = __atomic_load_n(&store->epoch, __ATOMIC_SEQ_CST);
+        if (new_epoch == epoch) break;
+
+        __atomic_sub_fetch(&store->num_acquiring[epoch], 1, __ATOMIC_RELEASE);
+        epoch = new_epoch;
+    }
+
+    jscon_version_t *version = __atomic_load_n(&store->current, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&version->refcount, 1, __ATOMIC_RELAXED);
+
+    __atomic_sub_fetch(&store->num_acquiring[epoch], 1, __ATOMIC_RELEASE);
+
+    return version;
+}
+
+void
+jscon_version_release(jscon_version_t *version)
+{
+    if (NULL == version) return;
+
+    if (0 == __atomic_sub_fetch(&version->refcount, 1, __ATOMIC_ACQ_REL)){
+        _jscon_version_destroy(version);
+    }
+}
+
+const jscon_tape_t*
+jscon_version_get_tape(const jscon_version_t *version){
+    return version->tape;
+}
+
+size_t
+jscon_version_get_number(const jscon_version_t *version){
+    return version->number;
+}
@@ -66,49 +66,12 @@ _jscon_utils_apply_string(char *string, struct jscon_utils_s *utils)
     }
 }
 
-/* converts double to string and store it in p_str */
-//@todo make this more readable
-static void 
-_jscon_double_tostr(const double d_number, char *p_str, const int digits)
-{
-    if (DOUBLE_IS_INTEGER(d_number)){
-        sprintf(p_str,"%.lf",d_number); //convert integer to string
-        return;
-    }
-
-    int decimal=0, sign=0;
-    char *tmp_str = fcvt(d_number,digits-1,&decimal,&sign);
-
-    int i=0;
-    if (0 > sign){ //negative sign detected
-        p_str[i++] = '-';
-    }
-
-    if (IN_RANGE(decimal,-7,17)){
-        //print scientific notation
-        sprintf(p_str+i,"%c.%.7se%d",*tmp_str,tmp_str+1,decimal-1);
-        return;
-    }
-
-    char format[100];
-    if (0 < decimal){
-        sprintf(format,"%%.%ds.%%.7s",decimal);
-        sprintf(i + p_str, format, tmp_str, tmp_str + decimal);
-    } else if (0 > decimal) {
-        sprintf(format, "0.%0*d%%.7s", abs(decimal), 0);
-        sprintf(i + p_str, format, tmp_str);
-    } else {
-        sprintf(format,"0.%%.7s");
-        sprintf(i + p_str, format, tmp_str);
-    }
-}
-
 /* get double converted to string and then perform buffer method calls */
 static void
 _jscon_utils_apply_double(double d_number, struct jscon_utils_s *utils)
 {
     char get_strnum[MAX_DIGITS];
-    _jscon_double_tostr(d_number, get_strnum, MAX_DIGITS);
+    Jscon_encode_double(d_number, get_strnum, MAX_DIGITS);
 
     _jscon_utils_apply_string(get_strnum,utils); //store value in utils
 }
@@ -123,6 +86,43 @@ _jscon_utils_apply_integer(long long i_number, struct jscon_utils_s *utils)
     _jscon_utils_apply_string(get_strnum,utils); //store value in utils
 }
 
+/* packed numbers are written the same as the items they stand for
+    would be, by the 5th and 6th steps below */
+static void
+_jscon_utils_apply_packed(const jscon_composite_t *comp, enum jscon_type type, struct jscon_utils_s *utils)
+{
+    bool is_first = true;
+    for (size_t i=0; i < comp->num_packed; ++i){
+        long long i_number = 0;
+        double d_number = 0.0;
+        bool is_integer = true;
+        if (JSCON_INTEGER == comp->packed){
+            i_number = PACKED_INTEGER(comp)[i];
+        }
+        else {
+            d_number = PACKED_DOUBLE(comp)[i];
+            is_integer = DOUBLE_IS_INTEGER(d_number);
+            i_number = is_integer ? (long long)d_number : 0;
+        }
+
+        const bool is_match = (0 != (type & (is_integer ? JSCON_INTEGER : JSCON_DOUBLE)));
+        if (is_first && !is_match) continue;
+
+        if (!is_first){
+            (*utils->method)(',', utils);
+        }
+        is_first = false;
+
+        if (!is_match) continue;
+
+        if (is_integer){
+            _jscon_utils_apply_integer(i_number, utils);
+        } else {
+            _jscon_utils_apply_double(d_number, utils);
+        }
+    }
+}
+
 /* walk jscon item, by traversing its branches recursively,
       and perform buffer_method callback on each branch */
 static void
@@ -175,6 +175,12 @@ _jscon_traverse_preorder(jscon_item_t *item, enum jscon_type type, struct jscon_
         DEBUG_ERR("Can't stringify undefined datatype, code: %d", item->type);
     }
 
+    if (IS_PACKED(item)){
+        _jscon_utils_apply_packed(item->comp, type, utils);
+        (*utils->method)(']', utils);
+        return;
+    }
+
     /* 4th STEP: if item is is a branch's leaf (defined at macros.h),
         the 5th step can be ignored and returned */
     if (IS_LEAF(item)){
@@ -0,0 +1,483 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+
+#include <libjscon.h>
+
+#include "jscon-common.h"
+#include "debug.h"
+
+
+/* expected member size of a field type, 0 if it varies */
+static size_t
+_jscon_field_size(enum jscon_field_type type)
+{
+    switch (type){
+    case JSCON_FIELD_CHAR:      return sizeof(char);
+    case JSCON_FIELD_INT:       return sizeof(int);
+    case JSCON_FIELD_LONG:      return sizeof(long);
+    case JSCON_FIELD_LLONG:     return sizeof(long long);
+    case JSCON_FIELD_FLOAT:     return sizeof(float);
+    case JSCON_FIELD_DOUBLE:    return sizeof(double);
+    case JSCON_FIELD_BOOLEAN:   return sizeof(bool);
+    case JSCON_FIELD_STRING:
+    case JSCON_FIELD_STRUCT:
+        return 0;
+    default:
+        DEBUG_ERR("Unknown field type code: %d", type);
+        return 0;
+    }
+}
+
+/* catches descriptors whose type doesn't agree with the member */
+static void
+_jscon_field_check(const jscon_field_t *field)
+{
+    size_t size = _jscon_field_size(field->type);
+    if (0 != size && size != field->size){
+        DEBUG_ERR("Field '%s' size is %zu, but its type expects %zu",
+                  field->key, field->size, size);
+    }
+    if (JSCON_FIELD_STRING == field->type && 0 == field->size){
+        DEBUG_ERR("Field '%s' is a string of size 0", field->key);
+    }
+    if (JSCON_FIELD_STRUCT == field->type && NULL == field->nested){
+        DEBUG_ERR("Field '%s' is a struct with no nested descriptor", field->key);
+    }
+}
+
+/* fields usually show up in the same order as the descriptor, so the
+    search starts right after the last matched field */
+static const jscon_field_t*
+_jscon_field_match(const jscon_field_t *desc, size_t num_field, size_t *p_hint, const char *key, size_t len)
+{
+    size_t i = *p_hint;
+    for (size_t n=0; n < num_field; ++n){
+        const jscon_field_t *field = &desc[i];
+        if (++i == num_field) i = 0;
+
+        if (STRNEQ(field->key, key, len) && '\0' == field->key[len]){
+            *p_hint = i;
+            return field;
+        }
+    }
+
+    return NULL;
+}
+
+/* value of the 4 hex digits at str, or -1 if they aren't hex digits */
+static long
+_jscon_hex4(const char *str, const char *end)
+{
+    if (end - str < 4) return -1;
+
+    long code = 0;
+    for (int i=0; i < 4; ++i){
+        if (!isxdigit((unsigned char)str[i])) return -1;
+        code = 16 * code + (isdigit((unsigned char)str[i]) ? str[i] - '0' : (tolower((unsigned char)str[i]) - 'a' + 10));
+    }
+    return code;
+}
+
+/* code point as utf-8 at utf8, returns its length */
+static size_t
+_jscon_utf8_encode(long code, char utf8[4])
+{
+    if (code < 0x80){
+        utf8[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800){
+        utf8[0] = (char)(0xC0 | (code >> 6));
+        utf8[1] = (char)(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000){
+        utf8[0] = (char)(0xE0 | (code >> 12));
+        utf8[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        utf8[2] = (char)(0x80 | (code & 0x3F));
+        return 3;
+    }
+    utf8[0] = (char)(0xF0 | (code >> 18));
+    utf8[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+    utf8[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+    utf8[3] = (char)(0x80 | (code & 0x3F));
+    return 4;
+}
+
+/* copies the len chars of the json string at string into value (of
+    size chars) with its escape sequences decoded, so that members hold
+    the same C text jscon_encode_struct() was given. a char that doesn't
+    fit is dropped along with all that follow it, value is always nul
+    terminated */
+static void
+_jscon_field_unescape(const char *string, size_t len, char *value, size_t size)
+{
+    const char *end = string + len;
+    size_t i = 0;
+    while (string < end){
+        char utf8[4];
+        size_t utf8_len = 1;
+
+        if ('\\' != *string){
+            utf8[0] = *string++;
+        }
+        else {
+            ++string; //skips '\\'
+            if (string == end) break;
+
+            switch (*string++){
+            case 'b': utf8[0] = '\b'; break;
+            case 'f': utf8[0] = '\f'; break;
+            case 'n': utf8[0] = '\n'; break;
+            case 'r': utf8[0] = '\r'; break;
+            case 't': utf8[0] = '\t'; break;
+            case 'u':
+             {
+                long code = _jscon_hex4(string, end);
+                if (-1 == code) goto done;
+                string += 4;
+
+                /* surrogate pairs make a single code point */
+                if (code >= 0xD800 && code <= 0xDBFF){
+                    long low = ('\\' == string[0] && 'u' == string[1]) ? _jscon_hex4(string + 2, end) : -1;
+                    if (low >= 0xDC00 && low <= 0xDFFF){
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        string += 6;
+                    } else {
+                        code = 0xFFFD; //replacement character
+                    }
+                }
+                else if (code >= 0xDC00 && code <= 0xDFFF){
+                    code = 0xFFFD;
+                }
+
+                utf8_len = _jscon_utf8_encode(code, utf8);
+                break;
+             }
+            default: /* '"', '\\' and '/' are themselves */
+                utf8[0] = string[-1];
+                break;
+            }
+        }
+
+        if (i + utf8_len >= size) break; //doesn't fit member
+
+        memcpy(value + i, utf8, utf8_len);
+        i += utf8_len;
+    }
+
+done:
+    value[i] = '\0';
+}
+
+static char* _jscon_struct_decode(const jscon_field_t *desc, char *buffer, char *p_struct);
+
+static char*
+_jscon_field_decode(const jscon_field_t *field, char *buffer, char *p_struct)
+{
+    _jscon_field_check(field);
+
+    char *value = p_struct + field->offset;
+
+    /* null conversion */
+    if ('n' == *buffer){
+        if (!STRNEQ(buffer, "null", 4)) goto token_error;
+
+        Jscon_decode_null(&buffer);
+        memset(value, 0, field->size);
+        return buffer;
+    }
+
+    switch (field->type){
+    case JSCON_FIELD_CHAR:
+    case JSCON_FIELD_STRING:
+     {
+        if ('\"' != *buffer) goto type_error;
+
+        size_t len;
+        char *string = Jscon_decode_string_inplace(&buffer, &len);
+        if ('\0' == *buffer) goto token_error; //string is never last in an object
+
+        if (JSCON_FIELD_CHAR == field->type){
+            char first[5]; //room for a single utf-8 char
+            _jscon_field_unescape(string, len, first, sizeof(first));
+            *value = *first;
+            return buffer;
+        }
+
+        /* truncate string that doesn't fit member */
+        _jscon_field_unescape(string, len, value, field->size);
+        return buffer;
+     }
+    case JSCON_FIELD_BOOLEAN:
+        if (STRNEQ(buffer, "true", 4) || STRNEQ(buffer, "false", 5)){
+            *(bool*)value = Jscon_decode_boolean(&buffer);
+            return buffer;
+        }
+        goto type_error;
+    case JSCON_FIELD_STRUCT:
+        if ('{' != *buffer) goto type_error;
+
+        return _jscon_struct_decode(field->nested, buffer, value);
+    default:
+        break;
+    }
+
+    /* field must be a number */
+    if (!IS_DIGIT(*buffer) && '-' != *buffer) goto type_error;
+
+    long long i_number;
+    double d_number;
+    bool is_integer = Jscon_decode_number(&buffer, &i_number, &d_number);
+    if (!is_integer && DOUBLE_IS_INTEGER(d_number)){
+        i_number = (long long)d_number;
+        is_integer = true;
+    }
+
+    switch (field->type){
+    /* integers that don't fit member are a type mismatch, rather than
+        being narrowed */
+    case JSCON_FIELD_INT:
+        if (!is_integer || i_number < INT_MIN || i_number > INT_MAX) goto type_error;
+        *(int*)value = (int)i_number;
+        return buffer;
+    case JSCON_FIELD_LONG:
+        if (!is_integer || i_number < LONG_MIN || i_number > LONG_MAX) goto type_error;
+        *(long*)value = (long)i_number;
+        return buffer;
+    case JSCON_FIELD_LLONG:
+        if (!is_integer) goto type_error;
+        *(long long*)value = i_number;
+        return buffer;
+    /* integers are converted to floating point */
+    case JSCON_FIELD_FLOAT:
+        *(float*)value = (float)d_number;
+        return buffer;
+    case JSCON_FIELD_DOUBLE:
+        *(double*)value = d_number;
+        return buffer;
+    default:
+        goto type_error;
+    }
+
+
+type_error:
+    DEBUG_ERR("Field '%s' type code %d doesn't match JSON value", field->key, field->type);
+
+token_error:
+    DEBUG_ERR("Invalid JSON Token: %c", *buffer);
+    return buffer;
+}
+
+/* walks through the object members in a single pass, members with no
+    matching field are skipped without being decoded */
+static char*
+_jscon_struct_decode(const jscon_field_t *desc, char *buffer, char *p_struct)
+{
+    size_t num_field = 0;
+    while (NULL != desc[num_field].key){
+        ++num_field;
+    }
+    size_t hint = 0;
+
+    DEBUG_ASSERT('{' == *buffer, "Item type must be a JSCON_OBJECT");
+    ++buffer; //skips '{'
+    while (true){
+        CONSUME_BLANK_CHARS(buffer);
+
+        switch (*buffer){
+        case '\0':
+            DEBUG_ERR("Bad formatting: JSON object isn't closed");
+            return buffer;
+        case '}':/*OBJECT WRAPPER DETECTED*/
+            return buffer + 1;
+        case ',':/*NEXT PROPERTY TOKEN*/
+            ++buffer;
+            break;
+        case '\"':/*KEY STRING DETECTED*/
+         {
+            /* key is matched in place, no copy is made */
+            size_t len;
+            char *key = Jscon_decode_string_inplace(&buffer, &len);
+
+            CONSUME_BLANK_CHARS(buffer);
+            if (':' != *buffer){ //check for key's assign token
+                DEBUG_ERR("Missing ':' token after key");
+                return buffer;
+            }
+            ++buffer; //consume ':'
+            CONSUME_BLANK_CHARS(buffer);
+
+            const jscon_field_t *field = _jscon_field_match(desc, num_field, &hint, key, len);
+            if (NULL == field){
+                buffer = Jscon_skip_value(buffer);
+            } else {
+                buffer = _jscon_field_decode(field, buffer, p_struct);
+            }
+            break;
+         }
+        default:
+            DEBUG_ERR("Invalid '%c' token", *buffer);
+            return buffer;
+        }
+    }
+}
+
+/* fills p_struct members described by desc with the values of the json
+    object at buffer, members whose key are missing are left untouched.
+    buffer must be nul terminated, reading stops at the nul char at most.
+    returns the amount of chars read from buffer */
+size_t
+jscon_decode_struct(const jscon_field_t *desc, char *buffer, void *p_struct)
+{
+    DEBUG_ASSERT(NULL != desc, "Missing descriptor");
+    DEBUG_ASSERT(NULL != buffer, "Missing JSON text");
+
+    char *start = buffer;
+
+    CONSUME_BLANK_CHARS(buffer);
+    if ('{' != *buffer){
+        DEBUG_ERR("Missing JSON object");
+        return buffer - start;
+    }
+
+    buffer = _jscon_struct_decode(desc, buffer, p_struct);
+
+    return buffer - start;
+}
+
+static void
+_jscon_field_encode(const jscon_field_t *field, const char *p_struct, struct jscon_outbuf_s *out);
+
+static void
+_jscon_struct_encode(const jscon_field_t *desc, const char *p_struct, struct jscon_outbuf_s *out)
+{
+    Jscon_outbuf_putc(out, '{');
+    for (const jscon_field_t *field = desc; NULL != field->key; ++field){
+        if (field != desc){
+            Jscon_outbuf_putc(out, ',');
+        }
+
+        Jscon_outbuf_putc(out, '\"');
+        Jscon_outbuf_write(out, field->key, strlen(field->key));
+        Jscon_outbuf_putc(out, '\"');
+        Jscon_outbuf_putc(out, ':');
+
+        _jscon_field_encode(field, p_struct, out);
+    }
+    Jscon_outbuf_putc(out, '}');
+}
+
+static void
+_jscon_field_encode(const jscon_field_t *field, const char *p_struct, struct jscon_outbuf_s *out)
+{
+    _jscon_field_check(field);
+
+    const char *value = p_struct + field->offset;
+
+    long long i_number;
+    double d_number;
+    switch (field->type){
+    /* members are C text, escaped so that the json is valid */
+    case JSCON_FIELD_CHAR:
+        Jscon_outbuf_string(out, value, ('\0' != *value) ? 1 : 0);
+        return;
+    case JSCON_FIELD_STRING:
+        Jscon_outbuf_string(out, value, strnlen(value, field->size));
+        return;
+    case JSCON_FIELD_BOOLEAN:
+        if (*(bool*)value){
+            Jscon_outbuf_write(out, "true", 4);
+        } else {
+            Jscon_outbuf_write(out, "false", 5);
+        }
+        return;
+    case JSCON_FIELD_STRUCT:
+        _jscon_struct_encode(field->nested, value, out);
+        return;
+    case JSCON_FIELD_INT:
+        i_number = *(int*)value;
+        break;
+    case JSCON_FIELD_LONG:
+        i_number = *(long*)value;
+        break;
+    case JSCON_FIELD_LLONG:
+        i_number = *(long long*)value;
+        break;
+    case JSCON_FIELD_FLOAT:
+    case JSCON_FIELD_DOUBLE:
+     {
+        if (JSCON_FIELD_FLOAT == field->type){
+            d_number = *(float*)value;
+        } else {
+            d_number = *(double*)value;
+        }
+
+        /* json has no representation for inf and nan */
+        if (!isfinite(d_number)){
+            Jscon_outbuf_write(out, "null", 4);
+            return;
+        }
+
+        char numstr[MAX_DOUBLE_LEN];
+        size_t len = Jscon_encode_double_exact(d_number, numstr);
+
+        Jscon_outbuf_write(out, numstr, len);
+        return;
+     }
+    default:
+        DEBUG_ERR("Unknown field type code: %d", field->type);
+        return;
+    }
+
+    char numstr[MAX_DIGITS+4];
+    size_t len = Jscon_encode_integer(i_number, numstr);
+
+    Jscon_outbuf_write(out, numstr, len);
+}
+
+/* works like snprintf, every member described by desc is written as
+    a "key":value pair of a json object. returns the length the json
+    text would have if size was big enough (excluding nul char) */
+size_t
+jscon_encode_struct(const jscon_field_t *desc, const void *p_struct, char *buffer, size_t size)
+{
+    DEBUG_ASSERT(NULL != desc, "Missing descriptor");
+
+    struct jscon_outbuf_s out = {
+        .base = buffer,
+        .size = size,
+    };
+
+    _jscon_struct_encode(desc, p_struct, &out);
+
+    Jscon_outbuf_end(&out);
+
+    return out.offset;
+}
@@ -0,0 +1,700 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <libjscon.h>
+
+#include "jscon-common.h"
+#include "debug.h"
+
+
+/* TAPE ENTRY
+ * every value is a 64-bit entry, with its tag at the upper 8 bits, a
+ * member flag at the next bit and a payload at the remaining 55 bits:
+ *      null, true, false: payload unused
+ *      integer, double: payload unused, number bits at next entry
+ *      string, key: offset of its nul terminated text at string storage
+ *      object, array begin: index of matching end entry
+ *      object, array end: amount of branches
+ * an object member is a key entry followed by its value, which is
+ * flagged as a member, as its composite is an object. an object end
+ * entry is followed by the index of each of its key entries, sorted by
+ * key, so that members may be binary searched. the end entry of either
+ * composite is then followed by the value index of every TAPE_STRIDE
+ * branch, so that branches are reached by position without walking
+ * through all of the ones before */
+#define TAPE_TAG(entry) ((char)((entry) >> 56))
+#define TAPE_PAYLOAD(entry) ((entry) & ((UINT64_C(1) << 55) - 1))
+#define TAPE_ENTRY(tag, payload) (((uint64_t)(unsigned char)(tag) << 56) | (payload))
+#define TAPE_MEMBER (UINT64_C(1) << 55)
+
+#define TAPE_STRIDE 16
+#define TAPE_NUM_STRIDE(num_branch) (((num_branch) + TAPE_STRIDE - 1) / TAPE_STRIDE)
+
+#define TAG_NULL        'n'
+#define TAG_TRUE        't'
+#define TAG_FALSE       'f'
+#define TAG_INTEGER     'l'
+#define TAG_DOUBLE      'd'
+#define TAG_STRING      's'
+#define TAG_KEY         'k'
+#define TAG_OBJECT      '{'
+#define TAG_OBJECT_END  '}'
+#define TAG_ARRAY       '['
+#define TAG_ARRAY_END   ']'
+
+struct jscon_tape_s {
+    uint64_t *entry;
+    size_t num_entry;
+
+    char *string; //strings and keys storage
+    size_t string_len;
+};
+
+/* composites that are yet to be closed while building the tape */
+struct jscon_tape_open_s {
+    size_t begin; //begin entry index
+    size_t num_branch;
+};
+
+/* object member to be sorted by key */
+struct jscon_tape_member_s {
+    const char *key;
+    uint64_t index; //key entry index
+};
+
+struct jscon_utils_s {
+    jscon_tape_t *tape;
+    size_t capacity; //entries allocated
+    struct jscon_tape_open_s open[MAX_DEPTH];
+    size_t depth;
+
+    struct jscon_tape_member_s *member; //reused by every object sort
+    size_t num_member; //members allocated
+};
+
+static size_t _jscon_tape_after(const jscon_tape_t *tape, size_t index);
+
+static void
+_jscon_tape_push(struct jscon_utils_s *utils, uint64_t entry)
+{
+    jscon_tape_t *tape = utils->tape;
+    if (tape->num_entry == utils->capacity){
+        utils->capacity *= 2;
+
+        void *tmp = Jscon_realloc(tape->entry, utils->capacity * sizeof *tape->entry, JSCON_ALLOC_NODE);
+        DEBUG_ASSERT(NULL != tmp, "Out of memory");
+        tape->entry = tmp;
+    }
+    tape->entry[tape->num_entry++] = entry;
+}
+
+/* a new value counts as a branch of its composite, and is flagged as
+    a member if its composite is an object */
+static void
+_jscon_tape_value(struct jscon_utils_s *utils, char tag, uint64_t payload)
+{
+    if (0 != utils->depth){
+        struct jscon_tape_open_s *open = &utils->open[utils->depth-1];
+        ++open->num_branch;
+        if (TAG_OBJECT == TAPE_TAG(utils->tape->entry[open->begin])){
+            payload |= TAPE_MEMBER;
+        }
+    }
+    _jscon_tape_push(utils, TAPE_ENTRY(tag, payload));
+}
+
+/* strings are copied to storage, which never needs to grow as its
+    size is bound by the json text length */
+static uint64_t
+_jscon_tape_string(struct jscon_utils_s *utils, const char *string, size_t len)
+{
+    jscon_tape_t *tape = utils->tape;
+    uint64_t offset = tape->string_len;
+
+    memcpy(tape->string + offset, string, len);
+    tape->string[offset + len] = '\0';
+    tape->string_len += len + 1;
+
+    return offset;
+}
+
+static bool
+_jscon_tape_on_begin(struct jscon_utils_s *utils, char tag)
+{
+    _jscon_tape_value(utils, tag, 0);
+
+    struct jscon_tape_open_s *open = &utils->open[utils->depth++];
+    open->begin = utils->tape->num_entry - 1;
+    open->num_branch = 0;
+    return true;
+}
+
+/* members with equal keys are reversed, so that the last one is
+    found, same as jscon_get_branch() */
+static int
+_jscon_tape_member_cmp(const void *a, const void *b)
+{
+    const struct jscon_tape_member_s *member_a = a, *member_b = b;
+
+    int cmp = strcmp(member_a->key, member_b->key);
+    if (0 != cmp) return cmp;
+
+    return (member_a->index < member_b->index) - (member_a->index > member_b->index);
+}
+
+/* push the object key entries indexes, sorted by key */
+static void
+_jscon_tape_sort_keys(struct jscon_utils_s *utils, struct jscon_tape_open_s *open)
+{
+    jscon_tape_t *tape = utils->tape;
+    if (open->num_branch > utils->num_member){
+        void *tmp = Jscon_realloc(utils->member, open->num_branch * sizeof *utils->member, JSCON_ALLOC_OTHER);
+        DEBUG_ASSERT(NULL != tmp, "Out of memory");
+        utils->member = tmp;
+        utils->num_member = open->num_branch;
+    }
+
+    size_t i = open->begin + 1;
+    for (size_t n=0; n < open->num_branch; ++n){
+        utils->member[n].key = tape->string + TAPE_PAYLOAD(tape->entry[i]);
+        utils->member[n].index = i;
+        i = _jscon_tape_after(tape, i + 1);
+    }
+    if (0 != open->num_branch){
+        qsort(utils->member, open->num_branch, sizeof *utils->member, &_jscon_tape_member_cmp);
+    }
+
+    for (size_t n=0; n < open->num_branch; ++n){
+        _jscon_tape_push(utils, utils->member[n].index);
+    }
+}
+
+/* push the value index of every TAPE_STRIDE branch */
+static void
+_jscon_tape_push_strides(struct jscon_utils_s *utils, struct jscon_tape_open_s *open, char tag)
+{
+    const size_t offset = (TAG_OBJECT_END == tag) ? 1 : 0; //skips key entry
+
+    size_t i = open->begin + 1;
+    for (size_t n=0; n < open->num_branch; ++n){
+        if (0 == n % TAPE_STRIDE){
+            _jscon_tape_push(utils, i + offset);
+        }
+        i = _jscon_tape_after(utils->tape, i + offset);
+    }
+}
+
+static bool
+_jscon_tape_on_end(struct jscon_utils_s *utils, char tag)
+{
+    struct jscon_tape_open_s *open = &utils->open[--utils->depth];
+
+    /* begin entry jumps to its end */
+    utils->tape->entry[open->begin] |= utils->tape->num_entry;
+    _jscon_tape_push(utils, TAPE_ENTRY(tag, open->num_branch));
+
+    if (TAG_OBJECT_END == tag){
+        _jscon_tape_sort_keys(utils, open);
+    }
+    _jscon_tape_push_strides(utils, open, tag);
+    return true;
+}
+
+static bool
+_jscon_tape_on_object_begin(void *context){
+    return _jscon_tape_on_begin(context, TAG_OBJECT);
+}
+
+static bool
+_jscon_tape_on_object_end(void *context){
+    return _jscon_tape_on_end(context, TAG_OBJECT_END);
+}
+
+static bool
+_jscon_tape_on_array_begin(void *context){
+    return _jscon_tape_on_begin(context, TAG_ARRAY);
+}
+
+static bool
+_jscon_tape_on_array_end(void *context){
+    return _jscon_tape_on_end(context, TAG_ARRAY_END);
+}
+
+static bool
+_jscon_tape_on_key(void *context, const char *key, size_t len)
+{
+    struct jscon_utils_s *utils = context;
+    _jscon_tape_push(utils, TAPE_ENTRY(TAG_KEY, _jscon_tape_string(utils, key, len)));
+    return true;
+}
+
+static bool
+_jscon_tape_on_string(void *context, const char *string, size_t len)
+{
+    struct jscon_utils_s *utils = context;
+    _jscon_tape_value(utils, TAG_STRING, _jscon_tape_string(utils, string, len));
+    return true;
+}
+
+static bool
+_jscon_tape_on_integer(void *context, long long i_number)
+{
+    _jscon_tape_value(context, TAG_INTEGER, 0);
+    _jscon_tape_push(context, (uint64_t)i_number);
+    return true;
+}
+
+static bool
+_jscon_tape_on_double(void *context, double d_number)
+{
+    uint64_t bits;
+    memcpy(&bits, &d_number, sizeof bits);
+
+    _jscon_tape_value(context, TAG_DOUBLE, 0);
+    _jscon_tape_push(context, bits);
+    return true;
+}
+
+static bool
+_jscon_tape_on_boolean(void *context, bool boolean)
+{
+    _jscon_tape_value(context, boolean ? TAG_TRUE : TAG_FALSE, 0);
+    return true;
+}
+
+static bool
+_jscon_tape_on_null(void *context)
+{
+    _jscon_tape_value(context, TAG_NULL, 0);
+    return true;
+}
+
+/* start a tape, string storage is allocated by the caller, as only
+    they know its size */
+static struct jscon_utils_s*
+_jscon_tape_init()
+{
+    jscon_tape_t *tape = Jscon_calloc(1, sizeof *tape, JSCON_ALLOC_OTHER);
+    if (NULL == tape) return NULL;
+
+    struct jscon_utils_s *utils = Jscon_malloc(sizeof *utils, JSCON_ALLOC_OTHER);
+    DEBUG_ASSERT(NULL != utils, "Out of memory");
+    utils->tape = tape;
+    utils->capacity = 64;
+    utils->depth = 0;
+    utils->member = NULL;
+    utils->num_member = 0;
+
+    tape->entry = Jscon_malloc(utils->capacity * sizeof *tape->entry, JSCON_ALLOC_NODE);
+    DEBUG_ASSERT(NULL != tape->entry, "Out of memory");
+
+    return utils;
+}
+
+/* drop an unfinished tape */
+static void
+_jscon_tape_cancel(struct jscon_utils_s *utils)
+{
+    jscon_tape_destroy(utils->tape);
+    Jscon_free(utils->member);
+    Jscon_free(utils);
+}
+
+/* finish the tape, trimming it to its final size */
+static jscon_tape_t*
+_jscon_tape_finish(struct jscon_utils_s *utils)
+{
+    jscon_tape_t *tape = utils->tape;
+
+    Jscon_free(utils->member);
+    Jscon_free(utils);
+
+    void *tmp = Jscon_realloc(tape->entry, tape->num_entry * sizeof *tape->entry, JSCON_ALLOC_NODE);
+    if (NULL != tmp) tape->entry = tmp;
+    tmp = Jscon_realloc(tape->string, tape->string_len + 1, JSCON_ALLOC_STRING);
+    if (NULL != tmp) tape->string = tmp;
+
+    return tape;
+}
+
+/* parse buffer into a tape, which is built from jscon_sax_parse()
+    events */
+jscon_tape_t*
+jscon_tape_parse(char *buffer)
+{
+    DEBUG_ASSERT(NULL != buffer, "Missing JSON text");
+
+    struct jscon_utils_s *utils = _jscon_tape_init();
+    if (NULL == utils) return NULL;
+
+    jscon_tape_t *tape = utils->tape;
+    tape->string = Jscon_malloc(strlen(buffer) + 1, JSCON_ALLOC_STRING);
+    DEBUG_ASSERT(NULL != tape->string, "Out of memory");
+
+    static const jscon_sax_t sax = {
+        .on_object_begin = &_jscon_tape_on_object_begin,
+        .on_object_end = &_jscon_tape_on_object_end,
+        .on_array_begin = &_jscon_tape_on_array_begin,
+        .on_array_end = &_jscon_tape_on_array_end,
+        .on_key = &_jscon_tape_on_key,
+        .on_string = &_jscon_tape_on_string,
+        .on_integer = &_jscon_tape_on_integer,
+        .on_double = &_jscon_tape_on_double,
+        .on_boolean = &_jscon_tape_on_boolean,
+        .on_null = &_jscon_tape_on_null,
+    };
+    if (!jscon_sax_parse(buffer, &sax, utils)){ //nesting too deep
+        _jscon_tape_cancel(utils);
+        return NULL;
+    }
+
+    return _jscon_tape_finish(utils);
+}
+
+/* emit the same events jscon_sax_parse() would, for item and its
+    branches. is_member tells if item is an object member. returns
+    false if item is nested deeper than the tape allows */
+static bool
+_jscon_tape_freeze_preorder(struct jscon_utils_s *utils, const jscon_item_t *item, bool is_member)
+{
+    if (is_member){
+        _jscon_tape_on_key(utils, item->key, strlen(item->key));
+    }
+
+    switch (item->type){
+    case JSCON_NULL:
+        _jscon_tape_on_null(utils);
+        return true;
+    case JSCON_BOOLEAN:
+        _jscon_tape_on_boolean(utils, item->boolean);
+        return true;
+    case JSCON_INTEGER:
+        _jscon_tape_on_integer(utils, item->i_number);
+        return true;
+    case JSCON_DOUBLE:
+        _jscon_tape_on_double(utils, item->d_number);
+        return true;
+    case JSCON_STRING:
+        _jscon_tape_on_string(utils, item->string, strlen(item->string));
+        return true;
+    case JSCON_OBJECT:
+    case JSCON_ARRAY:
+        break;
+    default:
+        DEBUG_ERR("Can't freeze item of type: %d", item->type);
+        abort();
+    }
+
+    if (MAX_DEPTH == utils->depth) return false;
+
+    const bool is_object = (JSCON_OBJECT == item->type);
+    _jscon_tape_on_begin(utils, is_object ? TAG_OBJECT : TAG_ARRAY);
+
+    /* packed numbers are frozen as the items they stand for */
+    const jscon_composite_t *comp = item->comp;
+    for (size_t i=0; i < comp->num_packed; ++i){
+        if (JSCON_INTEGER == comp->packed){
+            _jscon_tape_on_integer(utils, PACKED_INTEGER(comp)[i]);
+        }
+        else if (DOUBLE_IS_INTEGER(PACKED_DOUBLE(comp)[i])){
+            _jscon_tape_on_integer(utils, (long long)PACKED_DOUBLE(comp)[i]);
+        }
+        else {
+            _jscon_tape_on_double(utils, PACKED_DOUBLE(comp)[i]);
+        }
+    }
+
+    for (size_t i=0; i < item->comp->num_branch; ++i){
+        if (!_jscon_tape_freeze_preorder(utils, item->comp->branch[i], is_object)){
+            return false;
+        }
+    }
+
+    _jscon_tape_on_end(utils, is_object ? TAG_OBJECT_END : TAG_ARRAY_END);
+    return true;
+}
+
+/* make a tape out of a tree. root is only read from, and the tape
+    may then be read by any amount of threads */
+jscon_tape_t*
+jscon_freeze(const jscon_item_t *root)
+{
+    DEBUG_ASSERT(NULL != root, "Missing item");
+
+    /* size string storage beforehand, so that it never grows. only
+        composites are walked, so that packed arrays (which hold no
+        strings) aren't unpacked */
+    size_t string_len = 0;
+    if (JSCON_STRING == root->type){
+        string_len += strlen(root->string) + 1;
+    }
+
+    jscon_iter_t iter;
+    jscon_iter_init(&iter, root, JSCON_ITER_COMPOSITE);
+
+    jscon_item_t *item;
+    while (NULL != (item = jscon_iter_step(&iter))){
+        for (size_t i=0; i < item->comp->num_branch; ++i){
+            const jscon_item_t *branch = item->comp->branch[i];
+            if (JSCON_OBJECT == item->type){
+                string_len += strlen(branch->key) + 1;
+            }
+            if (JSCON_STRING == branch->type){
+                string_len += strlen(branch->string) + 1;
+            }
+        }
+    }
+    jscon_iter_destroy(&iter);
+
+    struct jscon_utils_s *utils = _jscon_tape_init();
+    if (NULL == utils) return NULL;
+
+    jscon_tape_t *tape = utils->tape;
+    tape->string = Jscon_malloc(string_len + 1, JSCON_ALLOC_STRING);
+    DEBUG_ASSERT(NULL != tape->string, "Out of memory");
+
+    /* root is frozen as if it had no parent */
+    if (!_jscon_tape_freeze_preorder(utils, root, false)){
+        _jscon_tape_cancel(utils);
+        return NULL;
+    }
+
+    return _jscon_tape_finish(utils);
+}
+
+void
+jscon_tape_destroy(jscon_tape_t *tape)
+{
+    if (NULL == tape) return;
+
+    Jscon_free(tape->entry);
+    Jscon_free(tape->string);
+    Jscon_free(tape);
+}
+
+static char
+_jscon_tape_tag(const jscon_tape_t *tape, size_t index)
+{
+    DEBUG_ASSERT(index < tape->num_entry, "Index out of bounds");
+    return TAPE_TAG(tape->entry[index]);
+}
+
+/* index of the entry right after the composite end at index, object
+    ends are followed by their sorted keys, and both by their strides */
+static size_t
+_jscon_tape_after_end(const jscon_tape_t *tape, size_t index)
+{
+    const size_t num_branch = TAPE_PAYLOAD(tape->entry[index]);
+    if (TAG_OBJECT_END == _jscon_tape_tag(tape, index)){
+        return index + 1 + num_branch + TAPE_NUM_STRIDE(num_branch);
+    }
+    return index + 1 + TAPE_NUM_STRIDE(num_branch);
+}
+
+/* index of the entry right after the value at index */
+static size_t
+_jscon_tape_after(const jscon_tape_t *tape, size_t index)
+{
+    switch (_jscon_tape_tag(tape, index)){
+    case TAG_OBJECT:
+    case TAG_ARRAY:
+        return _jscon_tape_after_end(tape, TAPE_PAYLOAD(tape->entry[index]));
+    case TAG_INTEGER:
+    case TAG_DOUBLE:
+        return index + 2;
+    default:
+        return index + 1;
+    }
+}
+
+/* skips key entry, if any */
+static size_t
+_jscon_tape_value_at(const jscon_tape_t *tape, size_t index)
+{
+    if (TAG_KEY == _jscon_tape_tag(tape, index)){
+        return index + 1;
+    }
+    return index;
+}
+
+/* amount of branches of a composite, 0 for primitives */
+size_t
+jscon_tape_size(const jscon_tape_t *tape, size_t index)
+{
+    switch (_jscon_tape_tag(tape, index)){
+    case TAG_OBJECT:
+    case TAG_ARRAY:
+        return TAPE_PAYLOAD(tape->entry[TAPE_PAYLOAD(tape->entry[index])]);
+    default:
+        return 0;
+    }
+}
+
+/* same as jscon_iter_next(), returns the next value in preorder, or 0
+    once every value has been visited */
+size_t
+jscon_tape_iter_next(const jscon_tape_t *tape, size_t index)
+{
+    char tag = _jscon_tape_tag(tape, index);
+    if (TAG_OBJECT == tag || TAG_ARRAY == tag){
+        ++index; //descend into composite
+    } else {
+        index = _jscon_tape_after(tape, index);
+    }
+
+    /* skip composite ends */
+    while (index < tape->num_entry){
+        tag = TAPE_TAG(tape->entry[index]);
+        if (TAG_OBJECT_END != tag && TAG_ARRAY_END != tag){
+            return _jscon_tape_value_at(tape, index);
+        }
+        index = _jscon_tape_after_end(tape, index);
+    }
+
+    return 0;
+}
+
+size_t
+jscon_tape_get_branch(const jscon_tape_t *tape, size_t index, const char *key)
+{
+    if (TAG_OBJECT != _jscon_tape_tag(tape, index)) return 0;
+
+    /* binary search for the first of the sorted keys that isn't less
+        than key */
+    size_t end = TAPE_PAYLOAD(tape->entry[index]);
+    const uint64_t *sorted = tape->entry + end + 1;
+    size_t low = 0, high = TAPE_PAYLOAD(tape->entry[end]);
+    while (low < high){
+        size_t mid = low + (high - low) / 2;
+        if (strcmp(tape->string + TAPE_PAYLOAD(tape->entry[sorted[mid]]), key) < 0){
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low == TAPE_PAYLOAD(tape->entry[end])) return 0;
+    if (!STREQ(key, tape->string + TAPE_PAYLOAD(tape->entry[sorted[low]]))) return 0;
+
+    return sorted[low] + 1;
+}
+
+size_t
+jscon_tape_get_byindex(const jscon_tape_t *tape, size_t index, size_t branch)
+{
+    char tag = _jscon_tape_tag(tape, index);
+    if (TAG_OBJECT != tag && TAG_ARRAY != tag) return 0;
+
+    const size_t end = TAPE_PAYLOAD(tape->entry[index]);
+    const size_t num_branch = TAPE_PAYLOAD(tape->entry[end]);
+    if (branch >= num_branch) return 0;
+
+    /* start from the closest stride, at most TAPE_STRIDE-1 branches
+        are walked from it */
+    const uint64_t *stride = tape->entry + end + 1;
+    if (TAG_OBJECT == tag){
+        stride += num_branch; //skips sorted keys
+    }
+
+    size_t i = stride[branch / TAPE_STRIDE];
+    for (branch %= TAPE_STRIDE; 0 != branch; --branch){
+        i = _jscon_tape_value_at(tape, _jscon_tape_after(tape, i));
+    }
+
+    return i;
+}
+
+enum jscon_type
+jscon_tape_get_type(const jscon_tape_t *tape, size_t index)
+{
+    switch (_jscon_tape_tag(tape, index)){
+    case TAG_NULL:      return JSCON_NULL;
+    case TAG_TRUE:
+    case TAG_FALSE:     return JSCON_BOOLEAN;
+    case TAG_INTEGER:   return JSCON_INTEGER;
+    case TAG_DOUBLE:    return JSCON_DOUBLE;
+    case TAG_STRING:    return JSCON_STRING;
+    case TAG_OBJECT:    return JSCON_OBJECT;
+    case TAG_ARRAY:     return JSCON_ARRAY;
+    default:            return JSCON_UNDEFINED;
+    }
+}
+
+/* key of an object member, or NULL if value isn't one. the entry
+    before a value can't be told apart from number bits, members are
+    flagged instead */
+char*
+jscon_tape_get_key(const jscon_tape_t *tape, size_t index)
+{
+    DEBUG_ASSERT(index < tape->num_entry, "Index out of bounds");
+    if (!(tape->entry[index] & TAPE_MEMBER)) return NULL;
+
+    return tape->string + TAPE_PAYLOAD(tape->entry[index - 1]);
+}
+
+bool
+jscon_tape_get_boolean(const jscon_tape_t *tape, size_t index)
+{
+    char tag = _jscon_tape_tag(tape, index);
+    if (TAG_NULL == tag) return false;
+
+    DEBUG_ASSERT(TAG_TRUE == tag || TAG_FALSE == tag, "Value type is not a Boolean");
+    return TAG_TRUE == tag;
+}
+
+char*
+jscon_tape_get_string(const jscon_tape_t *tape, size_t index)
+{
+    char tag = _jscon_tape_tag(tape, index);
+    if (TAG_NULL == tag) return NULL;
+
+    DEBUG_ASSERT(TAG_STRING == tag, "Value type is not a String");
+    return tape->string + TAPE_PAYLOAD(tape->entry[index]);
+}
+
+double
+jscon_tape_get_double(const jscon_tape_t *tape, size_t index)
+{
+    char tag = _jscon_tape_tag(tape, index);
+    if (TAG_NULL == tag) return 0.0;
+
+    DEBUG_ASSERT(TAG_DOUBLE == tag, "Value type is not a Double");
+
+    double d_number;
+    memcpy(&d_number, &tape->entry[index + 1], sizeof d_number);
+    return d_number;
+}
+
+long long
+jscon_tape_get_integer(const jscon_tape_t *tape, size_t index)
+{
+    char tag = _jscon_tape_tag(tape, index);
+    if (TAG_NULL == tag) return 0;
+
+    DEBUG_ASSERT(TAG_INTEGER == tag, "Value type is not a Integer");
+    return (long long)tape->entry[index + 1];
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+static const char text[] = "{\"id\":10, \"name\":\"john\", \"tags\":[\"a\",\"b\",{\"c\":null}],"
+                           " \"pos\":{\"lat\":-23.5, \"lon\":-46.5}}";
+
+static size_t
+total(const size_t *tally)
+{
+    size_t sum = 0;
+    for (int i=0; i < JSCON_ALLOC_NUM_CATEGORY; ++i){
+        sum += tally[i];
+    }
+    return sum;
+}
+
+/* every allocation goes through the installed allocator, and is
+    tallied by category */
+static void
+test_counting_allocator(void)
+{
+    jscon_alloc_stats_t stats = {0};
+    jscon_allocator_t counting = jscon_counting_allocator(&stats);
+    const jscon_allocator_t *prev = jscon_set_allocator(&counting);
+
+    char buffer[sizeof(text)];
+    memcpy(buffer, text, sizeof(text));
+    jscon_item_t *root = jscon_parse(buffer);
+    assert(NULL != root);
+
+    assert(0 != stats.count[JSCON_ALLOC_NODE]);
+    assert(0 != total(stats.in_use));
+    assert(total(stats.in_use) <= total(stats.bytes));
+
+    char *str = jscon_stringify(root, JSCON_ANY);
+    assert(NULL != str);
+    free(str);
+
+    /* tape strings are kept at their own storage */
+    jscon_tape_t *tape = jscon_freeze(root);
+    assert(0 != stats.count[JSCON_ALLOC_STRING]);
+    jscon_tape_destroy(tape);
+
+    jscon_destroy(root);
+    assert(0 == total(stats.in_use)); //nothing leaks
+
+    assert(&counting == jscon_set_allocator(prev));
+}
+
+/* a resized block is tallied at the category it is resized for */
+static void
+test_counting_realloc(void)
+{
+    jscon_alloc_stats_t stats = {0};
+    jscon_allocator_t counting = jscon_counting_allocator(&stats);
+
+    void *ptr = (*counting.alloc_cb)(counting.context, 16, JSCON_ALLOC_NODE);
+    assert(NULL != ptr);
+    ptr = (*counting.realloc_cb)(counting.context, ptr, 64, JSCON_ALLOC_STRING);
+    assert(NULL != ptr);
+
+    assert(0 == stats.in_use[JSCON_ALLOC_NODE]);
+    assert(64 == stats.in_use[JSCON_ALLOC_STRING]);
+    assert(1 == stats.count[JSCON_ALLOC_STRING]);
+
+    (*counting.free_cb)(counting.context, ptr);
+    assert(0 == total(stats.in_use));
+}
+
+/* NULL restores the libc allocator */
+static void
+test_set_allocator(void)
+{
+    jscon_alloc_stats_t stats = {0};
+    jscon_allocator_t counting = jscon_counting_allocator(&stats);
+
+    const jscon_allocator_t *libc = jscon_set_allocator(&counting);
+    assert(&counting == jscon_set_allocator(NULL));
+    assert(libc == jscon_set_allocator(NULL));
+
+    char buffer[sizeof(text)];
+    memcpy(buffer, text, sizeof(text));
+    jscon_destroy(jscon_parse(buffer));
+    assert(0 == total(stats.count));
+}
+
+static size_t num_failing;
+
+static void*
+failing_alloc(void *context, size_t size, enum jscon_alloc_category category)
+{
+    (void)context; (void)size; (void)category;
+    ++num_failing;
+    return NULL;
+}
+
+static void*
+failing_realloc(void *context, void *ptr, size_t size, enum jscon_alloc_category category)
+{
+    (void)context; (void)ptr; (void)size; (void)category;
+    ++num_failing;
+    return NULL;
+}
+
+static void
+failing_free(void *context, void *ptr)
+{
+    (void)context;
+    assert(NULL == ptr);
+}
+
+/* allocation failure is reported by the functions that may fail */
+static void
+test_allocator_failure(void)
+{
+    const jscon_allocator_t failing = {
+        .alloc_cb = &failing_alloc,
+        .realloc_cb = &failing_realloc,
+        .free_cb = &failing_free,
+    };
+    const jscon_allocator_t *prev = jscon_set_allocator(&failing);
+
+    char buffer[sizeof(text)];
+    memcpy(buffer, text, sizeof(text));
+    assert(NULL == jscon_parse(buffer));
+    assert(NULL == jscon_parser_init());
+    assert(NULL == jscon_scanf_compile("%d[id]"));
+    assert(0 != num_failing);
+
+    jscon_set_allocator(prev);
+}
+
+/* parser memory comes from its own allocator, if given */
+static void
+test_parser_allocator(void)
+{
+    jscon_alloc_stats_t stats = {0};
+    jscon_allocator_t counting = jscon_counting_allocator(&stats);
+
+    jscon_parser_t *parser = jscon_parser_init();
+    jscon_parser_set_allocator(parser, &counting);
+
+    char buffer[sizeof(text)];
+    memcpy(buffer, text, sizeof(text));
+    assert(NULL != jscon_parser_parse(parser, buffer));
+    assert(0 != stats.count[JSCON_ALLOC_ARENA]);
+    assert(0 == stats.count[JSCON_ALLOC_NODE]); //items are taken from the arena
+
+    jscon_parser_destroy(parser);
+    assert(0 == total(stats.in_use));
+}
+
+int main(void)
+{
+    test_counting_allocator();
+    test_counting_realloc();
+    test_set_allocator();
+    test_allocator_failure();
+    test_parser_allocator();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+static char text[] = 
+    " {\"skip\":{\"id\":[1,\"}\",{\"id\":2}]}, \"id\":10, \"name\":\"jo\\\"hn\","
+    " \"ok\":true, \"none\":null, \"ratio\":-0.25, \"big\":1e2,"
+    " \"list\":[ 1 , [2,3] , {\"a\":4}, \"five\" ], \"empty\":[]} ";
+
+static void
+test_cursor_find_field(void)
+{
+    jscon_doc_t doc;
+    jscon_value_t *root = jscon_doc_init(&doc, text);
+    assert(JSCON_OBJECT == jscon_value_get_type(root));
+
+    jscon_value_t field;
+    assert(true == jscon_obj_find_field(root, "id", &field));
+    assert(JSCON_INTEGER == jscon_value_get_type(&field));
+    assert(10 == jscon_value_get_integer(&field));
+    assert(10.0 == jscon_value_get_double(&field));
+
+    /* strings are returned in place, escapes are kept */
+    size_t len;
+    assert(true == jscon_obj_find_field(root, "name", &field));
+    char *string = jscon_value_get_string(&field, &len);
+    assert(6 == len && 0 == strncmp(string, "jo\\\"hn", len));
+
+    assert(true == jscon_obj_find_field(root, "ok", &field));
+    assert(true == jscon_value_get_boolean(&field));
+
+    assert(true == jscon_obj_find_field(root, "none", &field));
+    assert(JSCON_NULL == jscon_value_get_type(&field));
+    assert(0 == jscon_value_get_integer(&field));
+
+    assert(true == jscon_obj_find_field(root, "ratio", &field));
+    assert(-0.25 == jscon_value_get_double(&field));
+
+    assert(true == jscon_obj_find_field(root, "big", &field));
+    assert(100 == jscon_value_get_integer(&field));
+}
+
+/* missing values return the same defaults as null, so that chained
+    lookups only need to be checked at the end */
+static void
+test_cursor_missing(void)
+{
+    jscon_doc_t doc;
+    jscon_value_t *root = jscon_doc_init(&doc, text);
+
+    jscon_value_t a, b;
+    assert(false == jscon_obj_find_field(root, "missing", &a));
+    assert(false == jscon_obj_find_field(&a, "b", &b));
+    assert(JSCON_UNDEFINED == jscon_value_get_type(&b));
+    assert(0 == jscon_value_get_integer(&b));
+    assert(0.0 == jscon_value_get_double(&b));
+    assert(false == jscon_value_get_boolean(&b));
+    size_t len = 1;
+    assert(NULL == jscon_value_get_string(&b, &len) && 0 == len);
+    assert(NULL == jscon_value_parse(&b));
+
+    /* keys of nested values aren't matched */
+    jscon_value_t skip, id;
+    assert(true == jscon_obj_find_field(root, "skip", &skip));
+    assert(true == jscon_obj_find_field(&skip, "id", &id));
+    assert(JSCON_ARRAY == jscon_value_get_type(&id));
+
+    jscon_doc_init(&doc, "   ");
+    assert(JSCON_UNDEFINED == jscon_value_get_type(&doc.root));
+}
+
+static void
+test_cursor_arr_next(void)
+{
+    jscon_doc_t doc;
+    jscon_value_t *root = jscon_doc_init(&doc, text);
+
+    jscon_value_t list, element;
+    assert(true == jscon_obj_find_field(root, "list", &list));
+
+    assert(true == jscon_arr_next(&list, &element));
+    assert(1 == jscon_value_get_integer(&element));
+
+    assert(true == jscon_arr_next(&list, &element));
+    assert(JSCON_ARRAY == jscon_value_get_type(&element));
+    jscon_value_t nested;
+    long long sum = 0;
+    while (jscon_arr_next(&element, &nested)){
+        sum += jscon_value_get_integer(&nested);
+    }
+    assert(5 == sum);
+
+    assert(true == jscon_arr_next(&list, &element));
+    jscon_value_t a;
+    assert(true == jscon_obj_find_field(&element, "a", &a));
+    assert(4 == jscon_value_get_integer(&a));
+
+    assert(true == jscon_arr_next(&list, &element));
+    size_t len;
+    char *string = jscon_value_get_string(&element, &len);
+    assert(4 == len && 0 == strncmp(string, "five", len));
+
+    /* once the end is reached, further calls keep returning false */
+    assert(false == jscon_arr_next(&list, &element));
+    assert(false == jscon_arr_next(&list, &element));
+    assert(JSCON_UNDEFINED == jscon_value_get_type(&element));
+
+    jscon_value_t empty;
+    assert(true == jscon_obj_find_field(root, "empty", &empty));
+    assert(false == jscon_arr_next(&empty, &element));
+}
+
+/* cursor reads the same values as the generic tree */
+static void
+test_cursor_vs_tree(void)
+{
+    jscon_doc_t doc;
+    jscon_value_t *root = jscon_doc_init(&doc, text);
+    jscon_item_t *tree = jscon_value_parse(root);
+
+    jscon_value_t list;
+    assert(true == jscon_obj_find_field(root, "list", &list));
+    jscon_item_t *item = jscon_value_parse(&list);
+    assert(true == jscon_equal(item, jscon_get_branch(tree, "list")));
+    jscon_destroy(item);
+
+    /* numbers are typed by their value, not by their text */
+    const char *keys[] = {"id", "ratio", "big", "ok", "none", "name"};
+    for (size_t i=0; i < sizeof(keys)/sizeof(keys[0]); ++i){
+        jscon_value_t field;
+        assert(true == jscon_obj_find_field(root, keys[i], &field));
+
+        jscon_item_t *branch = jscon_get_branch(tree, keys[i]);
+        assert(jscon_get_type(branch) == jscon_value_get_type(&field));
+        switch (jscon_get_type(branch)){
+        case JSCON_INTEGER:
+            assert(jscon_get_integer(branch) == jscon_value_get_integer(&field));
+            break;
+        case JSCON_DOUBLE:
+            assert(jscon_get_double(branch) == jscon_value_get_double(&field));
+            break;
+        default:
+            break;
+        }
+    }
+
+    jscon_destroy(tree);
+}
+
+int main(void)
+{
+    test_cursor_find_field();
+    test_cursor_missing();
+    test_cursor_arr_next();
+    test_cursor_vs_tree();
+
+    return EXIT_SUCCESS;
+}
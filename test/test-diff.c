@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <libjscon.h>
+
+
+static void
+test_equal(void)
+{
+    char buffer_a[] = "{\"a\":1,\"b\":[1,2.5,\"x\"],\"c\":{\"d\":null,\"e\":true}}";
+    char buffer_b[] = "{\"c\":{\"e\":true,\"d\":null},\"b\":[1.0,2.5,\"x\"],\"a\":1}";
+    char buffer_c[] = "{\"a\":1,\"b\":[2.5,1,\"x\"],\"c\":{\"d\":null,\"e\":true}}";
+    jscon_item_t *a = jscon_parse(buffer_a);
+    jscon_item_t *b = jscon_parse(buffer_b);
+    jscon_item_t *c = jscon_parse(buffer_c);
+
+    /* members order is ignored, array elements order isn't */
+    assert(jscon_equal(a, a));
+    assert(jscon_equal(a, b));
+    assert(jscon_hash(a) == jscon_hash(b));
+    assert(!jscon_equal(a, c));
+
+    /* keys are ignored */
+    assert(jscon_equal(jscon_get_branch(a, "c"), jscon_get_branch(b, "c")));
+    assert(!jscon_equal(jscon_get_branch(a, "a"), jscon_get_branch(a, "b")));
+
+    /* cached hashes follow changes */
+    jscon_set_boolean(jscon_get_branch(jscon_get_branch(b, "c"), "e"), false);
+    assert(!jscon_equal(a, b));
+    jscon_set_boolean(jscon_get_branch(jscon_get_branch(b, "c"), "e"), true);
+    assert(jscon_equal(a, b));
+    jscon_append(jscon_get_branch(b, "c"), jscon_null("f"));
+    assert(!jscon_equal(a, b));
+
+    jscon_destroy(a);
+    jscon_destroy(b);
+    jscon_destroy(c);
+
+    /* packed and generic arrays compare by value */
+    char packed_buffer[] = "[1,2,3]";
+    jscon_item_t *packed = jscon_parse(packed_buffer);
+    jscon_item_t *generic = jscon_array(NULL);
+    jscon_append(generic, jscon_integer("0", 1));
+    jscon_append(generic, jscon_double("1", 2.0));
+    jscon_append(generic, jscon_integer("2", 3));
+    assert(jscon_equal(packed, generic));
+    assert(jscon_equal(generic, packed));
+    jscon_set_integer(jscon_get_byindex(generic, 2), 4);
+    assert(!jscon_equal(packed, generic));
+    jscon_destroy(packed);
+    jscon_destroy(generic);
+}
+
+static unsigned long seed;
+
+static unsigned long
+next_random(void)
+{
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    return seed >> 33;
+}
+
+/* random JSON value, nested up to depth */
+static size_t
+random_text(char *text, int depth)
+{
+    switch (next_random() % ((depth > 0) ? 7 : 4)){
+    case 0: return sprintf(text, "%lu", next_random() % 10);
+    case 1: return sprintf(text, "\"s%lu\"", next_random() % 5);
+    case 2: return sprintf(text, "%s", (next_random() % 2) ? "true" : "null");
+    case 3: return sprintf(text, "%lu.5", next_random() % 10);
+    case 4: { //array of numbers, packed once parsed
+        size_t len = sprintf(text, "[");
+        const unsigned long size = next_random() % 6;
+        for (unsigned long i=0; i < size; ++i){
+            len += sprintf(text + len, "%s%lu", (0 != i) ? "," : "", next_random() % 4);
+        }
+        return len + sprintf(text + len, "]");
+    }
+    case 5: {
+        size_t len = sprintf(text, "[");
+        const unsigned long size = next_random() % 5;
+        for (unsigned long i=0; i < size; ++i){
+            len += sprintf(text + len, "%s", (0 != i) ? "," : "");
+            len += random_text(text + len, depth-1);
+        }
+        return len + sprintf(text + len, "]");
+    }
+    default: {
+        size_t len = sprintf(text, "{");
+        const unsigned long size = next_random() % 5;
+        for (unsigned long i=0; i < size; ++i){
+            len += sprintf(text + len, "%s\"k%lu\":", (0 != i) ? "," : "", i);
+            len += random_text(text + len, depth-1);
+        }
+        return len + sprintf(text + len, "}");
+    }
+    }
+}
+
+/* a patch from a to b turns a into b, for trees that are nearly the
+    same as well as for unrelated ones */
+static void
+test_diff_roundtrip(void)
+{
+    static char text_a[1 << 16], text_b[1 << 16];
+    for (int n=0; n < 500; ++n){
+        seed = n;
+        random_text(text_a, 4);
+        /* same seed, so b shares a's beginning half of the time */
+        seed = (n % 2) ? n : n + 1000;
+        random_text(text_b, 4);
+
+        jscon_item_t *a = jscon_parse(text_a);
+        jscon_item_t *b = jscon_parse(text_b);
+        assert(NULL != a && NULL != b);
+
+        jscon_item_t *patch = jscon_diff(a, b);
+        assert(NULL != patch);
+        assert((0 == jscon_size(patch)) == jscon_equal(a, b));
+
+        assert(jscon_patch(&a, patch));
+        if (!jscon_equal(a, b)){
+            fprintf(stderr, "a: %s\nb: %s\n", text_a, text_b);
+            abort();
+        }
+        assert(jscon_hash(a) == jscon_hash(b));
+
+        jscon_item_t *empty = jscon_diff(a, b);
+        assert(0 == jscon_size(empty));
+
+        jscon_destroy(empty);
+        jscon_destroy(patch);
+        jscon_destroy(a);
+        jscon_destroy(b);
+    }
+}
+
+/* a diff only lists what changed */
+static void
+test_diff_minimal(void)
+{
+    char buffer_a[] = "{\"name\":\"jscon\",\"tags\":[1,2,3],\"old\":{\"x\":[true]}}";
+    char buffer_b[] = "{\"tags\":[1,5,2,3],\"name\":\"jscon\",\"new\":true,\"old\":{\"x\":[false]}}";
+    jscon_item_t *a = jscon_parse(buffer_a);
+    jscon_item_t *b = jscon_parse(buffer_b);
+
+    jscon_item_t *patch = jscon_diff(a, b);
+    char *str = jscon_stringify(patch, JSCON_ANY);
+    assert(0 == strcmp(str, "[{\"op\":\"add\",\"path\":\"/tags/1\",\"value\":5},"
+                             "{\"op\":\"replace\",\"path\":\"/old/x/0\",\"value\":false},"
+                             "{\"op\":\"add\",\"path\":\"/new\",\"value\":true}]"));
+    free(str);
+
+    assert(jscon_patch(&a, patch));
+    assert(jscon_equal(a, b));
+
+    jscon_destroy(patch);
+    jscon_destroy(a);
+    jscon_destroy(b);
+}
+
+static jscon_item_t *shared_a, *shared_b;
+
+static void*
+equal_thread(void *arg)
+{
+    (void)arg;
+    for (int n=0; n < 200; ++n){
+        assert(jscon_equal(shared_a, shared_b));
+        assert(jscon_hash(shared_a) == jscon_hash(shared_b));
+    }
+    return NULL;
+}
+
+/* equal trees are compared from many threads, while their hashes
+    get cached */
+static void
+test_equal_threads(void)
+{
+    static char text_a[1 << 16], text_b[1 << 16];
+    seed = 42;
+    size_t len = sprintf(text_a, "{");
+    for (int i=0; i < 16; ++i){
+        len += sprintf(text_a + len, "%s\"m%d\":", (0 != i) ? "," : "", i);
+        len += random_text(text_a + len, 6);
+    }
+    sprintf(text_a + len, "}");
+    memcpy(text_b, text_a, sizeof(text_b));
+    shared_a = jscon_parse(text_a);
+    shared_b = jscon_parse(text_b);
+
+    pthread_t threads[8];
+    for (int i=0; i < 8; ++i){
+        assert(0 == pthread_create(&threads[i], NULL, &equal_thread, NULL));
+    }
+    for (int i=0; i < 8; ++i){
+        pthread_join(threads[i], NULL);
+    }
+
+    jscon_destroy(shared_a);
+    jscon_destroy(shared_b);
+}
+
+int main(void)
+{
+    test_equal();
+    test_diff_roundtrip();
+    test_diff_minimal();
+    test_equal_threads();
+
+    return EXIT_SUCCESS;
+}
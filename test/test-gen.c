@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "test-gen.h" /* generated by: ../tools/jscon-gen test-gen.json test-gen.h */
+
+
+/* keys that are C keywords or start with a digit are still valid members */
+static void
+test_gen_decode(void)
+{
+    char buffer[] = "{\"unknown\":[1,{\"id\":2}], \"id\":-5, \"long\":2.5, \"1st\":true,"
+                    " \"first-name\":\"johnathan\", \"default\":{\"int\":7, \"x\":null}}";
+
+    struct record rec = {0};
+    rec.default_.x = 1.0;
+    size_t len = record_decode(buffer, sizeof(buffer)-1, &rec);
+    assert(sizeof(buffer)-1 == len);
+
+    assert(-5 == rec.id);
+    assert(2.5 == rec.long_);
+    assert(true == rec._1st);
+    assert(0 == strcmp(rec.first_name, "johnath")); //truncated to maxLength
+    assert(7 == rec.default_.int_);
+    assert(0.0 == rec.default_.x);
+}
+
+/* decoding never reads past len */
+static void
+test_gen_decode_truncated(void)
+{
+    char text[] = "{\"id\":10, \"first-name\":\"jo\", \"default\":{\"int\":1}}";
+    for (size_t len=0; len < sizeof(text)-1; ++len){
+        char *buffer = malloc(len ? len : 1);
+        assert(NULL != buffer);
+        memcpy(buffer, text, len);
+
+        struct record rec = {0};
+        assert(0 == record_decode(buffer, len, &rec));
+
+        free(buffer);
+    }
+}
+
+static void
+test_gen_encode(void)
+{
+    struct record rec = {
+        .id = 42, .long_ = -0.5, ._1st = false, .first_name = "jo", .default_ = {3, 1.5}
+    };
+
+    char buffer[256];
+    size_t len = record_encode(&rec, buffer, sizeof(buffer));
+    assert(strlen(buffer) == len);
+    assert(0 == strcmp(buffer, "{\"id\":42,\"long\":-0.5,\"1st\":false,\"first-name\":\"jo\","
+                               "\"default\":{\"int\":3,\"x\":1.5}}"));
+
+    struct record copy = {0};
+    assert(len == record_decode(buffer, len, &copy));
+    assert(rec.id == copy.id);
+    assert(rec.long_ == copy.long_);
+    assert(rec._1st == copy._1st);
+    assert(0 == strcmp(rec.first_name, copy.first_name));
+    assert(rec.default_.int_ == copy.default_.int_);
+    assert(rec.default_.x == copy.default_.x);
+}
+
+/* keys that convert to the same member are rejected */
+static void
+test_gen_collision(void)
+{
+    const char *schemas[] = {
+        "{\"title\":\"t\", \"properties\":{\"a-b\":{\"type\":\"integer\"}, \"a_b\":{\"type\":\"integer\"}}}",
+        "{\"title\":\"t\", \"properties\":{\"long\":{\"type\":\"integer\"}, \"long_\":{\"type\":\"integer\"}}}",
+        "{\"title\":\"t\", \"properties\":{\"a_b\":{\"type\":\"object\", \"properties\":{}},"
+            " \"a\":{\"type\":\"object\", \"properties\":{\"b\":{\"type\":\"object\", \"properties\":{}}}}}}",
+    };
+
+    for (size_t i=0; i < sizeof(schemas)/sizeof(schemas[0]); ++i){
+        FILE *f = fopen("test-gen-collision.json", "w");
+        assert(NULL != f);
+        fputs(schemas[i], f);
+        fclose(f);
+
+        int status = system("../tools/jscon-gen test-gen-collision.json >/dev/null 2>&1");
+        assert(0 != status);
+    }
+    remove("test-gen-collision.json");
+}
+
+int main(void)
+{
+    test_gen_decode();
+    test_gen_decode_truncated();
+    test_gen_encode();
+    test_gen_collision();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+/* the element whose field is id, found by scanning the array */
+static jscon_item_t*
+scan_integer(jscon_item_t *array, const char *field, long long id)
+{
+    for (size_t i=0; i < jscon_size(array); ++i){
+        jscon_item_t *value = jscon_get_branch(jscon_get_byindex(array, i), field);
+        if (NULL != value && JSCON_INTEGER == jscon_get_type(value) && id == jscon_get_integer(value)){
+            return jscon_get_byindex(array, i);
+        }
+    }
+    return NULL;
+}
+
+static jscon_item_t*
+scan_string(jscon_item_t *array, const char *field, const char *name)
+{
+    for (size_t i=0; i < jscon_size(array); ++i){
+        jscon_item_t *value = jscon_get_branch(jscon_get_byindex(array, i), field);
+        if (NULL != value && JSCON_STRING == jscon_get_type(value) && 0 == strcmp(name, jscon_get_string(value))){
+            return jscon_get_byindex(array, i);
+        }
+    }
+    return NULL;
+}
+
+/* ids 0 to 19 and names "u0" to "u19" must be found as if scanned,
+    any element may be returned for repeated values */
+static void
+check(jscon_item_t *array, const jscon_index_t *by_id, const jscon_index_t *by_name)
+{
+    char name[16];
+    for (long long id=0; id < 20; ++id){
+        jscon_item_t *element = jscon_index_lookup_integer(by_id, id);
+        if (NULL == scan_integer(array, "id", id)){
+            assert(NULL == element);
+        } else {
+            assert(array == jscon_get_parent(element));
+            assert(id == jscon_get_integer(jscon_get_branch(element, "id")));
+        }
+
+        snprintf(name, sizeof(name), "u%lld", id);
+        element = jscon_index_lookup(by_name, name);
+        if (NULL == scan_string(array, "name", name)){
+            assert(NULL == element);
+        } else {
+            assert(array == jscon_get_parent(element));
+            assert(0 == strcmp(name, jscon_get_string(jscon_get_branch(element, "name"))));
+        }
+    }
+}
+
+static void
+test_index_lookup(void)
+{
+    char buffer[] = "{\"users\":[{\"id\":7,\"name\":\"ann\"},{\"id\":9,\"name\":\"bob\"},"
+                    "{\"id\":\"x\"},{\"name\":null},3,{\"id\":1.5}]}";
+    jscon_item_t *root = jscon_parse(buffer);
+    jscon_item_t *users = jscon_get_branch(root, "users");
+
+    jscon_index_t *by_id = jscon_index_by(users, "id");
+    jscon_index_t *by_name = jscon_index_by(users, "name");
+    assert(NULL != by_id && NULL != by_name);
+    assert(by_id == jscon_index_by(users, "id"));
+
+    assert(jscon_get_byindex(users, 1) == jscon_index_lookup_integer(by_id, 9));
+    assert(jscon_get_byindex(users, 2) == jscon_index_lookup(by_id, "x"));
+    assert(jscon_get_byindex(users, 0) == jscon_index_lookup(by_name, "ann"));
+    assert(NULL == jscon_index_lookup_integer(by_id, 8));
+    assert(NULL == jscon_index_lookup(by_id, "7"));
+    assert(NULL == jscon_index_lookup_integer(by_name, 0));
+
+    jscon_destroy(root);
+}
+
+/* lookups match a scan of the array after every change to it */
+static void
+test_index_mutation(void)
+{
+    jscon_item_t *array = jscon_array(NULL);
+    char key[16], name[16];
+    for (int i=0; i < 10; ++i){
+        snprintf(key, sizeof(key), "%d", i);
+        jscon_item_t *user = jscon_append(array, jscon_object(key));
+        jscon_append(user, jscon_integer("id", i));
+        snprintf(name, sizeof(name), "u%d", i);
+        jscon_append(user, jscon_string("name", name));
+    }
+
+    jscon_index_t *by_id = jscon_index_by(array, "id");
+    jscon_index_t *by_name = jscon_index_by(array, "name");
+    check(array, by_id, by_name);
+
+    /* appended elements, and fields appended to them later */
+    for (int i=10; i < 20; ++i){
+        snprintf(key, sizeof(key), "%d", i);
+        jscon_item_t *user = jscon_append(array, jscon_object(key));
+        check(array, by_id, by_name);
+        jscon_append(user, jscon_integer("id", i));
+        snprintf(name, sizeof(name), "u%d", i);
+        jscon_append(user, jscon_string("name", name));
+        check(array, by_id, by_name);
+    }
+
+    /* fields changed in place */
+    jscon_set_integer(jscon_get_branch(jscon_get_byindex(array, 3), "id"), 19);
+    jscon_set_string(jscon_get_branch(jscon_get_byindex(array, 3), "name"), "changed");
+    check(array, by_id, by_name);
+    assert(NULL == jscon_index_lookup(by_name, "u3"));
+    assert(jscon_get_byindex(array, 3) == jscon_index_lookup(by_name, "changed"));
+
+    /* fields and elements removed */
+    jscon_delete(jscon_get_byindex(array, 6), "id");
+    check(array, by_id, by_name);
+    jscon_destroy(jscon_dettach(jscon_get_byindex(array, 7)));
+    check(array, by_id, by_name);
+    jscon_destroy(jscon_dettach(jscon_get_byindex(array, 0)));
+    check(array, by_id, by_name);
+
+    /* elements moved to another array leave this one index */
+    jscon_item_t *other = jscon_array(NULL);
+    jscon_item_t *moved = jscon_dettach(jscon_get_byindex(array, 0));
+    jscon_append(other, moved);
+    check(array, by_id, by_name);
+    jscon_index_t *other_by_id = jscon_index_by(other, "id");
+    assert(moved == jscon_index_lookup_integer(other_by_id, jscon_get_integer(jscon_get_branch(moved, "id"))));
+    jscon_destroy(other);
+
+    jscon_destroy(array);
+}
+
+int main(void)
+{
+    test_index_lookup();
+    test_index_mutation();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+/* keys and strings are read the same whether kept inline or not */
+static void
+test_inline_parse(void)
+{
+    char buffer[] = "{\"id\":\"abc\", \"a key that is much longer than sixteen bytes\":"
+                    "\"a string that is much longer than sixteen bytes\", \"\":\"\"}";
+    jscon_item_t *root = jscon_parse(buffer);
+
+    jscon_item_t *id = jscon_get_branch(root, "id");
+    assert(0 == strcmp("id", jscon_get_key(id)));
+    assert(0 == strcmp("abc", jscon_get_string(id)));
+
+    jscon_item_t *item = jscon_get_branch(root, "a key that is much longer than sixteen bytes");
+    assert(NULL != item);
+    assert(0 == strcmp("a string that is much longer than sixteen bytes", jscon_get_string(item)));
+
+    jscon_item_t *empty = jscon_get_branch(root, "");
+    assert(NULL != empty && 0 == strcmp("", jscon_get_string(empty)));
+
+    jscon_item_t *clone = jscon_clone(root);
+    assert(true == jscon_equal(root, clone));
+    jscon_destroy(clone);
+
+    jscon_destroy(root);
+}
+
+/* a string that fits in place is overwritten, any other one is
+    allocated, with no leaks either way */
+static void
+test_inline_set_string(void)
+{
+    jscon_alloc_stats_t stats = {0};
+    jscon_allocator_t counting = jscon_counting_allocator(&stats);
+    const jscon_allocator_t *prev = jscon_set_allocator(&counting);
+
+    jscon_item_t *root = jscon_object(NULL);
+    jscon_item_t *status = jscon_append(root, jscon_string("status", "pending"));
+    const size_t num_string = stats.count[JSCON_ALLOC_STRING];
+
+    assert(0 == strcmp("done", jscon_set_string(status, "done")));
+    assert(0 == strcmp("done", jscon_get_string(status)));
+    assert(num_string == stats.count[JSCON_ALLOC_STRING]); //overwritten in place
+
+    char *long_string = "this string doesn't fit where the previous one was";
+    assert(0 == strcmp(long_string, jscon_set_string(status, long_string)));
+    assert(0 == strcmp(long_string, jscon_get_string(status)));
+
+    /* the item's own string may be given as the new one */
+    jscon_set_string(status, jscon_get_string(status) + 5);
+    assert(0 == strcmp("string doesn't fit where the previous one was", jscon_get_string(status)));
+
+    jscon_set_string(status, "ok");
+    assert(0 == strcmp("ok", jscon_get_string(jscon_get_branch(root, "status"))));
+
+    char *text = jscon_stringify(root, JSCON_ANY);
+    assert(0 == strcmp("{\"status\":\"ok\"}", text));
+    free(text);
+
+    jscon_destroy(root);
+
+    size_t in_use = 0;
+    for (int i=0; i < JSCON_ALLOC_NUM_CATEGORY; ++i){
+        in_use += stats.in_use[i];
+    }
+    assert(0 == in_use);
+
+    jscon_set_allocator(prev);
+}
+
+int main(void)
+{
+    test_inline_parse();
+    test_inline_set_string();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <libjscon.h>
+
+
+static const char records[] = "[{\"id\":1, \"name\":\"a\"}, {\"name\":\"b\", \"id\":2},"
+                              " {\"id\":3, \"extra\":{\"id\":4}}]";
+
+static void
+test_intern(void)
+{
+    jscon_intern_t *intern = jscon_intern_init(false);
+    assert(0 == jscon_intern_size(intern));
+
+    char key[] = "id";
+    const char *id = jscon_intern(intern, key);
+    assert(0 == strcmp(id, "id"));
+    assert(id != key); //pool keeps its own copy
+    assert(id == jscon_intern(intern, "id"));
+    assert(1 == jscon_intern_size(intern));
+
+    assert(id != jscon_intern(intern, "name"));
+    assert(jscon_intern(intern, "") == jscon_intern(intern, ""));
+    assert(3 == jscon_intern_size(intern));
+
+    /* keys outgrowing a single storage block are still kept */
+    char long_key[5000];
+    memset(long_key, 'k', sizeof(long_key)-1);
+    long_key[sizeof(long_key)-1] = '\0';
+    const char *stored = jscon_intern(intern, long_key);
+    assert(0 == strcmp(stored, long_key));
+    assert(stored == jscon_intern(intern, long_key));
+
+    for (int i=0; i < 1000; ++i){
+        char numbered[16];
+        snprintf(numbered, sizeof(numbered), "key%d", i);
+        assert(0 == strcmp(numbered, jscon_intern(intern, numbered)));
+    }
+    assert(1004 == jscon_intern_size(intern));
+    assert(id == jscon_intern(intern, "id"));
+
+    jscon_intern_destroy(intern);
+}
+
+/* items parsed with a pool share its keys, across documents */
+static void
+test_intern_parser(void)
+{
+    jscon_intern_t *intern = jscon_intern_init(false);
+    jscon_parser_t *parser = jscon_parser_init();
+    jscon_parser_set_intern(parser, intern);
+
+    char buffer[sizeof(records)];
+    memcpy(buffer, records, sizeof(records));
+    jscon_item_t *root = jscon_parser_parse(parser, buffer);
+    memcpy(buffer, records, sizeof(records));
+    jscon_item_t *other = jscon_parser_parse(parser, buffer);
+
+    const char *id = jscon_intern(intern, "id");
+    for (size_t i=0; i < jscon_size(root); ++i){
+        jscon_item_t *record = jscon_get_byindex(root, i);
+        jscon_item_t *branch = jscon_get_branch(record, id);
+        assert((long long)i+1 == jscon_get_integer(branch));
+        assert(id == jscon_get_key(branch));
+        assert(id == jscon_get_key(jscon_get_branch(jscon_get_byindex(other, i), "id")));
+    }
+    assert(4 == jscon_get_integer(jscon_get_branch(jscon_get_branch(jscon_get_byindex(root, 2), "extra"), id)));
+
+    /* "id", "name", "extra" and the array element keys "0" to "2" */
+    assert(6 == jscon_intern_size(intern));
+
+    /* same tree as if parsed without a pool */
+    memcpy(buffer, records, sizeof(records));
+    jscon_item_t *generic = jscon_parse(buffer);
+    assert(true == jscon_equal(root, generic));
+    jscon_destroy(generic);
+
+    jscon_parser_destroy(parser);
+    jscon_intern_destroy(intern);
+}
+
+static jscon_intern_t *shared;
+
+static void*
+intern_thread(void *arg)
+{
+    (void)arg;
+    jscon_parser_t *parser = jscon_parser_init();
+    jscon_parser_set_intern(parser, shared);
+
+    char buffer[sizeof(records)];
+    for (int n=0; n < 200; ++n){
+        memcpy(buffer, records, sizeof(records));
+        jscon_item_t *root = jscon_parser_parse(parser, buffer);
+        assert(jscon_intern(shared, "name") == jscon_get_key(jscon_get_branch(jscon_get_byindex(root, 0), "name")));
+
+        char key[32];
+        snprintf(key, sizeof(key), "key%d", n);
+        assert(0 == strcmp(key, jscon_intern(shared, key)));
+
+        jscon_parser_reset(parser);
+    }
+
+    jscon_parser_destroy(parser);
+    return NULL;
+}
+
+/* a shared pool may be used by many threads at once */
+static void
+test_intern_shared(void)
+{
+    shared = jscon_intern_init(true);
+
+    pthread_t threads[4];
+    for (int i=0; i < 4; ++i){
+        assert(0 == pthread_create(&threads[i], NULL, &intern_thread, NULL));
+    }
+    for (int i=0; i < 4; ++i){
+        pthread_join(threads[i], NULL);
+    }
+    assert(6 + 200 == jscon_intern_size(shared));
+
+    jscon_intern_destroy(shared);
+}
+
+int main(void)
+{
+    test_intern();
+    test_intern_parser();
+    test_intern_shared();
+
+    return EXIT_SUCCESS;
+}
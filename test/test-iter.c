@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <libjscon.h>
+
+
+/* writes the key of every item walked in order, "$" for the root */
+static void
+walk_keys(jscon_item_t *root, enum jscon_iter_order order, char *text, size_t size)
+{
+    size_t len = 0;
+    text[0] = '\0';
+
+    jscon_iter_t iter;
+    jscon_iter_init(&iter, root, order);
+    for (jscon_item_t *item; NULL != (item = jscon_iter_step(&iter)); ){
+        const char *key = jscon_get_key(item);
+        len += snprintf(text + len, size - len, "%s ", (NULL != key) ? key : "$");
+        assert(len < size);
+    }
+    jscon_iter_destroy(&iter);
+}
+
+static void
+test_iter_order(void)
+{
+    char buffer[] = "{\"a\":{\"b\":[true,{\"c\":null}]}, \"d\":\"e\", \"f\":{}}";
+    jscon_item_t *root = jscon_parse(buffer);
+
+    char text[256];
+    walk_keys(root, JSCON_ITER_PREORDER, text, sizeof(text));
+    assert(0 == strcmp(text, "$ a b 0 1 c d f "));
+    walk_keys(root, JSCON_ITER_POSTORDER, text, sizeof(text));
+    assert(0 == strcmp(text, "0 c 1 b a d f $ "));
+    walk_keys(root, JSCON_ITER_COMPOSITE, text, sizeof(text));
+    assert(0 == strcmp(text, "$ a b 1 f "));
+
+    /* a primitive root is walked alone, unless only composites are */
+    jscon_item_t *d = jscon_get_branch(root, "d");
+    walk_keys(d, JSCON_ITER_PREORDER, text, sizeof(text));
+    assert(0 == strcmp(text, "d "));
+    walk_keys(d, JSCON_ITER_POSTORDER, text, sizeof(text));
+    assert(0 == strcmp(text, "d "));
+    walk_keys(d, JSCON_ITER_COMPOSITE, text, sizeof(text));
+    assert(0 == strcmp(text, ""));
+
+    walk_keys(NULL, JSCON_ITER_PREORDER, text, sizeof(text));
+    assert(0 == strcmp(text, ""));
+
+    jscon_destroy(root);
+}
+
+/* walks deeper than JSCON_ITER_STACK move their frames to the heap */
+static void
+test_iter_deep(void)
+{
+    const size_t depth = 10 * JSCON_ITER_STACK;
+    char *buffer = malloc(2 * depth + 2);
+    assert(NULL != buffer);
+    memset(buffer, '[', depth);
+    buffer[depth] = '7';
+    memset(buffer + depth + 1, ']', depth);
+    buffer[2 * depth + 1] = '\0';
+
+    jscon_item_t *root = jscon_parse(buffer);
+
+    const enum jscon_iter_order orders[] = {JSCON_ITER_PREORDER, JSCON_ITER_POSTORDER, JSCON_ITER_COMPOSITE};
+    for (size_t i=0; i < sizeof(orders)/sizeof(orders[0]); ++i){
+        size_t num_items = 0;
+        jscon_iter_t iter;
+        jscon_iter_init(&iter, root, orders[i]);
+        for (jscon_item_t *item; NULL != (item = jscon_iter_step(&iter)); ++num_items){
+            if (JSCON_INTEGER == jscon_get_type(item)){
+                assert(7 == jscon_get_integer(item));
+            }
+        }
+        jscon_iter_destroy(&iter);
+
+        assert(((JSCON_ITER_COMPOSITE == orders[i]) ? depth : depth + 1) == num_items);
+    }
+
+    jscon_destroy(root);
+    free(buffer);
+}
+
+static jscon_item_t *shared;
+static long long expected_sum;
+static size_t expected_items;
+
+static void*
+iter_thread(void *arg)
+{
+    const enum jscon_iter_order order = *(enum jscon_iter_order*)arg;
+    for (int n=0; n < 50; ++n){
+        long long sum = 0;
+        size_t num_items = 0;
+
+        jscon_iter_t iter;
+        jscon_iter_init(&iter, shared, order);
+        for (jscon_item_t *item; NULL != (item = jscon_iter_step(&iter)); ++num_items){
+            if (JSCON_INTEGER == jscon_get_type(item)){
+                sum += jscon_get_integer(item);
+            }
+        }
+        jscon_iter_destroy(&iter);
+
+        assert(expected_sum == sum);
+        assert(expected_items == num_items);
+    }
+    return NULL;
+}
+
+/* many threads walk the same tree at once, the tree is only read from */
+static void
+test_iter_threads(void)
+{
+    /* records of mixed values, so that arrays hold items */
+    const size_t num_records = 500;
+    char *buffer = malloc(num_records * 64 + 3);
+    assert(NULL != buffer);
+    size_t len = 0;
+    buffer[len++] = '[';
+    for (size_t i=0; i < num_records; ++i){
+        len += sprintf(buffer + len, "%s{\"id\":%zu,\"name\":\"record\",\"tags\":[1,null]}",
+                        (0 != i) ? "," : "", i);
+    }
+    buffer[len++] = ']';
+    buffer[len] = '\0';
+
+    jscon_item_t *root = jscon_parse(buffer);
+    shared = root;
+    expected_sum = (long long)(num_records * (num_records - 1) / 2 + num_records);
+    expected_items = 1 + num_records * 6;
+
+    enum jscon_iter_order orders[] = {JSCON_ITER_PREORDER, JSCON_ITER_POSTORDER};
+    pthread_t threads[8];
+    for (int i=0; i < 8; ++i){
+        assert(0 == pthread_create(&threads[i], NULL, &iter_thread, &orders[i % 2]));
+    }
+    for (int i=0; i < 8; ++i){
+        pthread_join(threads[i], NULL);
+    }
+
+    jscon_destroy(root);
+    free(buffer);
+}
+
+int main(void)
+{
+    test_iter_order();
+    test_iter_deep();
+    test_iter_threads();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+/* find_all must list exactly the object members with key, as found
+    by walking the whole tree */
+static void
+check(jscon_item_t *root, const char *key)
+{
+    size_t count;
+    jscon_item_t* const *found = jscon_find_all(root, key, &count);
+    assert((0 == count) == (NULL == found));
+
+    size_t num_expected = 0;
+    jscon_iter_t iter;
+    jscon_iter_init(&iter, root, JSCON_ITER_PREORDER);
+    for (jscon_item_t *item; NULL != (item = jscon_iter_step(&iter)); ){
+        jscon_item_t *parent = jscon_get_parent(item);
+        if (NULL == parent || JSCON_OBJECT != jscon_get_type(parent)) continue;
+        if (0 != strcmp(key, jscon_get_key(item))) continue;
+
+        ++num_expected;
+
+        size_t i = 0;
+        while (i < count && found[i] != item){
+            ++i;
+        }
+        assert(i < count);
+    }
+    jscon_iter_destroy(&iter);
+
+    assert(num_expected == count);
+}
+
+static void
+test_keyindex_find(void)
+{
+    char buffer[] = "{\"obj1\":{\"n\":1},\"obj2\":{\"n\":3,\"m\":{\"n\":4}},\"obj3\":{\"n\":5},"
+                    "\"list\":[{\"n\":6},7,{\"x\":8}]}";
+    jscon_item_t *root = jscon_parse(buffer);
+
+    check(root, "n");
+    check(root, "x");
+    check(root, "m");
+    check(root, "missing");
+
+    size_t count;
+    jscon_find_all(root, "n", &count);
+    assert(5 == count);
+
+    /* array elements aren't members */
+    assert(NULL == jscon_find_all(root, "0", &count));
+    assert(0 == count);
+
+    /* any item of the tree searches the whole tree */
+    jscon_find_all(jscon_get_branch(root, "obj3"), "n", &count);
+    assert(5 == count);
+
+    jscon_destroy(root);
+}
+
+/* the index follows appends and removals made after it was built */
+static void
+test_keyindex_update(void)
+{
+    char buffer[] = "{\"a\":{\"n\":1},\"b\":[{\"n\":2}]}";
+    jscon_item_t *root = jscon_parse(buffer);
+    check(root, "n");
+
+    /* appended subtrees are indexed as a whole */
+    jscon_item_t *c = jscon_append(root, jscon_object("c"));
+    jscon_append(c, jscon_integer("n", 3));
+    jscon_item_t *d = jscon_append(c, jscon_object("d"));
+    jscon_append(d, jscon_integer("n", 4));
+    check(root, "n");
+    check(root, "c");
+    check(root, "d");
+
+    /* appending a tree with its own index drops it */
+    char other_buffer[] = "{\"n\":5,\"e\":{\"n\":6}}";
+    jscon_item_t *other = jscon_parse(other_buffer);
+    check(other, "n");
+    jscon_item_t *d_other = jscon_dettach(jscon_get_branch(other, "e"));
+    jscon_destroy(other);
+    jscon_append(root, d_other);
+    check(root, "n");
+    check(root, "e");
+
+    /* dettached subtrees leave the index, and index their own tree
+        once searched */
+    jscon_dettach(c);
+    check(root, "n");
+    check(root, "d");
+    check(c, "n");
+    jscon_destroy(c);
+
+    jscon_delete(root, "a");
+    check(root, "n");
+    check(root, "a");
+
+    jscon_item_t *b = jscon_get_branch(root, "b");
+    jscon_append(b, jscon_clone(jscon_get_byindex(b, 0)));
+    check(root, "n");
+
+    jscon_destroy(root);
+}
+
+/* patches go through the same appends and removals */
+static void
+test_keyindex_patch(void)
+{
+    char buffer[] = "{\"a\":{\"n\":1},\"b\":{\"n\":2}}";
+    jscon_item_t *root = jscon_parse(buffer);
+    check(root, "n");
+
+    char patch_buffer[] = "[{\"op\":\"add\",\"path\":\"/c\",\"value\":{\"n\":3}},"
+                          "{\"op\":\"remove\",\"path\":\"/a\"},"
+                          "{\"op\":\"move\",\"from\":\"/b/n\",\"path\":\"/c/m\"},"
+                          "{\"op\":\"copy\",\"from\":\"/c\",\"path\":\"/d\"}]";
+    jscon_item_t *patch = jscon_parse(patch_buffer);
+    assert(jscon_patch(&root, patch));
+    jscon_destroy(patch);
+
+    check(root, "n");
+    check(root, "m");
+    check(root, "a");
+    check(root, "c");
+
+    jscon_destroy(root);
+}
+
+int main(void)
+{
+    test_keyindex_find();
+    test_keyindex_update();
+    test_keyindex_patch();
+
+    return EXIT_SUCCESS;
+}
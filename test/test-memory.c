@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+/* memory benchmark of the node layout: heap bytes and allocations per
+    node of a parsed document, and the time taken to look up and to
+    walk through its nodes. heap bytes are those of the malloc chunks
+    holding the nodes, as every allocation takes a chunk header and is
+    rounded up to 16 bytes. the layout made of separate item,
+    composite, hashtable and key allocations took 162 heap bytes
+    (154 in chunks and 8 mmapped, as told by mallinfo2) and at least
+    2.5 allocations per node of this very document */
+#define NUM_RECORD 20000
+#define NUM_LOOKUP 20
+
+#define BASELINE_HEAP_BYTES 162.0
+#define BASELINE_ALLOCS 2.5
+
+/* malloc chunk size of a size bytes allocation, as made by glibc on
+    64-bit targets */
+#define CHUNK_SIZE(size) (((size) + 8 + 15 < 32) ? 32 : (((size) + 8 + 15) & ~(size_t)15))
+
+struct heap_stats_s {
+    size_t bytes; //requested bytes in use
+    size_t heap; //chunk bytes in use
+    size_t count; //allocations made
+};
+
+union heap_header_u {
+    size_t size;
+    max_align_t align;
+};
+
+static void*
+heap_alloc(void *context, size_t size, enum jscon_alloc_category category)
+{
+    (void)category;
+    struct heap_stats_s *stats = context;
+
+    union heap_header_u *header = malloc(sizeof *header + size);
+    if (NULL == header) return NULL;
+    header->size = size;
+
+    stats->bytes += size;
+    stats->heap += CHUNK_SIZE(size);
+    ++stats->count;
+
+    return header + 1;
+}
+
+static void
+heap_free(void *context, void *ptr)
+{
+    if (NULL == ptr) return;
+
+    struct heap_stats_s *stats = context;
+    union heap_header_u *header = (union heap_header_u*)ptr - 1;
+
+    stats->bytes -= header->size;
+    stats->heap -= CHUNK_SIZE(header->size);
+    free(header);
+}
+
+static void*
+heap_realloc(void *context, void *ptr, size_t size, enum jscon_alloc_category category)
+{
+    void *new_ptr = heap_alloc(context, size, category);
+    if (NULL == new_ptr || NULL == ptr) return new_ptr;
+
+    const size_t old_size = ((union heap_header_u*)ptr - 1)->size;
+    memcpy(new_ptr, ptr, (old_size < size) ? old_size : size);
+    heap_free(context, ptr);
+
+    return new_ptr;
+}
+
+/* array of records of 7 members, 8 nodes each */
+static char*
+make_records(void)
+{
+    char *buffer = malloc(NUM_RECORD * 128 + 3);
+    assert(NULL != buffer);
+
+    size_t len = sprintf(buffer, "[");
+    for (int i=0; i < NUM_RECORD; ++i){
+        len += sprintf(buffer + len,
+                       "%s{\"id\":%d,\"name\":\"user %d\",\"active\":%s,\"score\":%d.5,"
+                       "\"tags\":null,\"group\":\"g%d\",\"rank\":%d}",
+                       (0 != i) ? "," : "", i, i, (i % 2) ? "true" : "false", i, i % 16, i);
+    }
+    sprintf(buffer + len, "]");
+
+    return buffer;
+}
+
+static double
+elapsed_ms(clock_t start){
+    return 1000.0 * (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void
+bench_memory(void)
+{
+    struct heap_stats_s stats = {0};
+    jscon_allocator_t allocator = {
+        .alloc_cb = &heap_alloc,
+        .realloc_cb = &heap_realloc,
+        .free_cb = &heap_free,
+        .context = &stats,
+    };
+    const jscon_allocator_t *prev = jscon_set_allocator(&allocator);
+
+    char *buffer = make_records();
+    jscon_item_t *root = jscon_parse(buffer);
+    assert(NULL != root);
+
+    const size_t bytes = stats.bytes, heap = stats.heap, num_alloc = stats.count;
+
+    /* every node, counted by a walk through the tree */
+    clock_t start = clock();
+    size_t num_node = 0;
+    jscon_iter_t iter;
+    jscon_iter_init(&iter, root, JSCON_ITER_PREORDER);
+    while (NULL != jscon_iter_step(&iter)){
+        ++num_node;
+    }
+    jscon_iter_destroy(&iter);
+    const double traversal_ms = elapsed_ms(start);
+    assert(1 + 8 * NUM_RECORD == num_node);
+
+    static const char *keys[] = {"id", "name", "active", "score", "tags", "group", "rank"};
+    start = clock();
+    long long sum = 0;
+    for (int n=0; n < NUM_LOOKUP; ++n){
+        for (size_t i=0; i < jscon_size(root); ++i){
+            jscon_item_t *record = jscon_get_byindex(root, i);
+            for (size_t j=0; j < sizeof(keys)/sizeof(keys[0]); ++j){
+                assert(NULL != jscon_get_branch(record, keys[j]));
+            }
+            sum += jscon_get_integer(jscon_get_branch(record, "rank"));
+        }
+    }
+    const double lookup_ms = elapsed_ms(start);
+    assert((long long)NUM_LOOKUP * NUM_RECORD * (NUM_RECORD - 1) / 2 == sum);
+
+    const double heap_per_node = (double)heap / num_node;
+    const double allocs_per_node = (double)num_alloc / num_node;
+    printf("%zu nodes\n"
+           "  heap per node     %.1f B (%.1f B before)\n"
+           "  bytes per node    %.1f B\n"
+           "  allocs per node   %.2f (%.2f before)\n"
+           "  get_branch        %.0f ms\n"
+           "  traversal         %.0f ms\n",
+           num_node, heap_per_node, BASELINE_HEAP_BYTES, (double)bytes / num_node,
+           allocs_per_node, BASELINE_ALLOCS, lookup_ms, traversal_ms);
+
+    /* the layout takes at least 40% less memory */
+    assert(heap_per_node <= 0.6 * BASELINE_HEAP_BYTES);
+    assert(allocs_per_node < BASELINE_ALLOCS);
+
+    jscon_destroy(root);
+    free(buffer);
+    assert(0 == stats.bytes && 0 == stats.heap);
+
+    jscon_set_allocator(prev);
+}
+
+int main(void)
+{
+    bench_memory();
+
+    return EXIT_SUCCESS;
+}
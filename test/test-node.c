@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+/* large objects are looked up through their key index, small ones
+    by a linear scan, both must find every key */
+static void
+test_node_lookup(void)
+{
+    for (size_t num_branch = 1; num_branch <= 300; num_branch *= 3){
+        jscon_item_t *root = jscon_object(NULL);
+        for (size_t i=0; i < num_branch; ++i){
+            char key[32];
+            snprintf(key, sizeof(key), "key%zu", i);
+            assert(NULL != jscon_append(root, jscon_integer(key, (long long)i)));
+        }
+        assert(num_branch == jscon_size(root));
+
+        for (size_t i=0; i < num_branch; ++i){
+            char key[32];
+            snprintf(key, sizeof(key), "key%zu", i);
+            jscon_item_t *branch = jscon_get_branch(root, key);
+            assert(NULL != branch);
+            assert((long long)i == jscon_get_integer(branch));
+            assert((long)i == jscon_get_index(root, key));
+            assert(branch == jscon_get_byindex(root, i));
+            assert(root == jscon_get_parent(branch));
+        }
+        assert(NULL == jscon_get_branch(root, "missing"));
+        assert(-1 == jscon_get_index(root, "missing"));
+        assert(NULL == jscon_get_byindex(root, num_branch));
+
+        jscon_destroy(root);
+    }
+}
+
+/* lookups keep working as branches are removed */
+static void
+test_node_delete(void)
+{
+    char buffer[] = "{\"a\":1, \"b\":2, \"c\":{\"d\":[1,2,3]}, \"e\":\"x\", \"f\":null,"
+                    " \"g\":1, \"h\":2, \"i\":3, \"j\":4, \"k\":5, \"l\":6, \"m\":7}";
+    jscon_item_t *root = jscon_parse(buffer);
+    assert(12 == jscon_size(root));
+
+    jscon_item_t *b = jscon_dettach(jscon_get_branch(root, "b"));
+    assert(NULL != b && 2 == jscon_get_integer(b));
+    assert(NULL == jscon_get_parent(b));
+    jscon_destroy(b);
+
+    jscon_delete(root, "c");
+    jscon_delete(root, "missing");
+    assert(10 == jscon_size(root));
+    assert(NULL == jscon_get_branch(root, "b"));
+    assert(NULL == jscon_get_branch(root, "c"));
+
+    const char *keys[] = {"a", "e", "f", "g", "h", "i", "j", "k", "l", "m"};
+    for (size_t i=0; i < sizeof(keys)/sizeof(keys[0]); ++i){
+        jscon_item_t *branch = jscon_get_branch(root, keys[i]);
+        assert(NULL != branch);
+        assert(0 == strcmp(keys[i], jscon_get_key(branch)));
+        assert(branch == jscon_get_byindex(root, jscon_get_index(root, keys[i])));
+    }
+
+    jscon_item_t *a = jscon_get_branch(root, "a");
+    assert(jscon_get_branch(root, "e") == jscon_get_sibling(a, 1));
+
+    char *text = jscon_stringify(root, JSCON_ANY);
+    jscon_item_t *reparsed = jscon_parse(text);
+    assert(true == jscon_equal(root, reparsed));
+    jscon_destroy(reparsed);
+    free(text);
+
+    jscon_destroy(root);
+}
+
+/* every item is visited once, in the same order as the text */
+static void
+test_node_traversal(void)
+{
+    char buffer[] = "{\"a\":{\"b\":[true,{\"c\":null}]}, \"d\":\"e\", \"f\":{}}";
+    jscon_item_t *root = jscon_parse(buffer);
+
+    const char *keys[] = {NULL, "a", "b", "0", "1", "c", "d", "f"};
+    size_t i = 0;
+    jscon_iter_t iter;
+    jscon_iter_init(&iter, root, JSCON_ITER_PREORDER);
+    for (jscon_item_t *item; NULL != (item = jscon_iter_step(&iter)); ++i){
+        assert(i < sizeof(keys)/sizeof(keys[0]));
+        if (NULL == keys[i]){
+            assert(NULL == jscon_get_key(item));
+        } else {
+            assert(0 == strcmp(keys[i], jscon_get_key(item)));
+        }
+    }
+    jscon_iter_destroy(&iter);
+    assert(sizeof(keys)/sizeof(keys[0]) == i);
+
+    jscon_item_t *clone = jscon_clone(root);
+    assert(true == jscon_equal(root, clone));
+    jscon_destroy(clone);
+
+    jscon_destroy(root);
+}
+
+int main(void)
+{
+    test_node_lookup();
+    test_node_delete();
+    test_node_traversal();
+
+    return EXIT_SUCCESS;
+}
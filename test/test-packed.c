@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <libjscon.h>
+
+
+static char text[] = "{\"ints\":[3,-5,8,0],\"doubles\":[0.5,2,-1.25e1],\"mixed\":[1,\"a\"],"
+                     "\"nested\":[[1,2],[],[3.5]]}";
+
+static jscon_item_t*
+keep_cb(jscon_item_t *item){
+    return item;
+}
+
+/* parsed with a callback installed, so that no array is packed */
+static jscon_item_t*
+parse_generic(char *buffer)
+{
+    jscon_cb *old_cb = jscon_parse_cb(&keep_cb);
+    jscon_item_t *root = jscon_parse(buffer);
+    jscon_parse_cb(old_cb);
+
+    return root;
+}
+
+/* packed arrays read the same as generic ones */
+static void
+test_packed_vs_generic(void)
+{
+    char buffer[sizeof(text)];
+    memcpy(buffer, text, sizeof(text));
+    jscon_item_t *packed = jscon_parse(buffer);
+    memcpy(buffer, text, sizeof(text));
+    jscon_item_t *generic = parse_generic(buffer);
+
+    size_t size;
+    assert(NULL != jscon_get_int_array(jscon_get_branch(packed, "ints"), &size));
+    assert(NULL == jscon_get_int_array(jscon_get_branch(generic, "ints"), &size));
+    assert(0 == size);
+
+    assert(jscon_equal(packed, generic));
+    assert(jscon_hash(packed) == jscon_hash(generic));
+
+    char *packed_str = jscon_stringify(packed, JSCON_ANY);
+    char *generic_str = jscon_stringify(generic, JSCON_ANY);
+    assert(0 == strcmp(packed_str, generic_str));
+    free(packed_str);
+    free(generic_str);
+
+    /* items are typed and keyed the same, in the same walk order */
+    jscon_iter_t packed_iter, generic_iter;
+    jscon_iter_init(&packed_iter, packed, JSCON_ITER_PREORDER);
+    jscon_iter_init(&generic_iter, generic, JSCON_ITER_PREORDER);
+    jscon_item_t *packed_item, *generic_item;
+    do {
+        packed_item = jscon_iter_step(&packed_iter);
+        generic_item = jscon_iter_step(&generic_iter);
+        assert((NULL == packed_item) == (NULL == generic_item));
+        if (NULL == packed_item) break;
+
+        assert(jscon_get_type(packed_item) == jscon_get_type(generic_item));
+        assert(jscon_equal(packed_item, generic_item));
+        if (NULL != jscon_get_parent(packed_item)){
+            assert(0 == strcmp(jscon_get_key(packed_item), jscon_get_key(generic_item)));
+        }
+    } while (1);
+    jscon_iter_destroy(&packed_iter);
+    jscon_iter_destroy(&generic_iter);
+
+    jscon_item_t *doubles = jscon_get_branch(packed, "doubles");
+    assert(JSCON_INTEGER == jscon_get_type(jscon_get_byindex(doubles, 1)));
+    assert(2 == jscon_get_integer(jscon_get_byindex(doubles, 1)));
+    assert(-12.5 == jscon_get_double(jscon_get_byindex(doubles, 2)));
+
+    /* no diff between them */
+    jscon_item_t *patch = jscon_diff(packed, generic);
+    assert(0 == jscon_size(patch));
+    jscon_destroy(patch);
+
+    jscon_destroy(packed);
+    jscon_destroy(generic);
+}
+
+/* reading the elements as items keeps the array packed */
+static void
+test_packed_read(void)
+{
+    char buffer[sizeof(text)];
+    memcpy(buffer, text, sizeof(text));
+    jscon_item_t *root = jscon_parse(buffer);
+    jscon_item_t *ints = jscon_get_branch(root, "ints");
+
+    size_t size;
+    const long long *numbers = jscon_get_int_array(ints, &size);
+    assert(NULL != numbers && 4 == size);
+
+    jscon_item_t *third = jscon_get_byindex(ints, 2);
+    assert(8 == jscon_get_integer(third));
+    assert(third == jscon_get_branch(ints, "2"));
+    assert(2 == jscon_get_index(ints, "2"));
+    assert(ints == jscon_get_parent(third));
+    assert(0 == strcmp("2", jscon_get_key(third)));
+    assert(NULL == jscon_get_byindex(ints, 4));
+    assert(NULL == jscon_get_branch(ints, "02"));
+    assert(NULL == jscon_get_branch(ints, "4"));
+    assert(NULL == jscon_get_branch(ints, "x"));
+
+    size_t num_items = 0;
+    jscon_iter_t iter;
+    jscon_iter_init(&iter, root, JSCON_ITER_POSTORDER);
+    while (NULL != jscon_iter_step(&iter)){
+        ++num_items;
+    }
+    jscon_iter_destroy(&iter);
+    assert(20 == num_items);
+
+    jscon_iter_init(&iter, root, JSCON_ITER_COMPOSITE);
+    for (num_items = 0; NULL != jscon_iter_step(&iter); ++num_items)
+        continue;
+    jscon_iter_destroy(&iter);
+    assert(8 == num_items);
+
+    jscon_query_t *query = jscon_query_compile("$.ints[*]");
+    assert(4 == jscon_query_exec(query, root, NULL, NULL));
+    assert(jscon_get_byindex(ints, 0) == jscon_query_first(query, root));
+    jscon_query_destroy(query);
+
+    jscon_item_t *copy = jscon_clone(root);
+    jscon_set_integer(jscon_get_byindex(jscon_get_branch(copy, "ints"), 0), 4);
+    jscon_item_t *patch = jscon_diff(root, copy);
+    assert(1 == jscon_size(patch));
+    jscon_destroy(patch);
+    jscon_destroy(copy);
+
+    /* the same numbers, still packed */
+    assert(numbers == jscon_get_int_array(ints, &size));
+    assert(4 == size && 8 == numbers[2]);
+
+    jscon_destroy(root);
+}
+
+/* a full jscon_iter_next() walk reads every element, and keeps every
+    array packed */
+static void
+test_packed_iter_next(void)
+{
+    char buffer[sizeof(text)];
+    memcpy(buffer, text, sizeof(text));
+    jscon_item_t *root = jscon_parse(buffer);
+    jscon_item_t *ints = jscon_get_branch(root, "ints");
+    jscon_item_t *doubles = jscon_get_branch(root, "doubles");
+
+    size_t size;
+    const long long *numbers = jscon_get_int_array(ints, &size);
+    assert(NULL != numbers && 4 == size);
+
+    size_t num_items = 0;
+    long long sum = 0;
+    for (jscon_item_t *item = jscon_iter_next(root); NULL != item; item = jscon_iter_next(item)){
+        if (ints == jscon_get_parent(item)){
+            sum += jscon_get_integer(item);
+        }
+        ++num_items;
+    }
+    assert(19 == num_items);
+    assert(6 == sum);
+
+    assert(numbers == jscon_get_int_array(ints, &size));
+    assert(4 == size);
+    assert(NULL != jscon_get_double_array(doubles, &size));
+    assert(3 == size);
+
+    jscon_destroy(root);
+}
+
+/* reading one element makes an item for it alone */
+static void
+test_packed_lazy(void)
+{
+    jscon_alloc_stats_t stats;
+    memset(&stats, 0, sizeof stats);
+    jscon_allocator_t allocator = jscon_counting_allocator(&stats);
+    const jscon_allocator_t *old_allocator = jscon_set_allocator(&allocator);
+
+    const size_t num_element = 1000;
+    char *buffer = malloc(num_element * 8 + 3);
+    assert(NULL != buffer);
+    size_t len = sprintf(buffer, "[");
+    for (size_t i=0; i < num_element; ++i){
+        len += sprintf(buffer + len, "%s%zu", (0 != i) ? "," : "", i);
+    }
+    sprintf(buffer + len, "]");
+
+    jscon_item_t *root = jscon_parse(buffer);
+    const size_t num_alloc = stats.count[JSCON_ALLOC_NODE] + stats.count[JSCON_ALLOC_KEY];
+
+    /* the element list and a single item */
+    assert(500 == jscon_get_integer(jscon_get_byindex(root, 500)));
+    assert(num_alloc + 2 >= stats.count[JSCON_ALLOC_NODE] + stats.count[JSCON_ALLOC_KEY]);
+    assert(jscon_get_byindex(root, 500) == jscon_get_branch(root, "500"));
+    assert(num_alloc + 2 >= stats.count[JSCON_ALLOC_NODE] + stats.count[JSCON_ALLOC_KEY]);
+
+    /* items made of the elements are freed along with the array */
+    assert(999 == jscon_get_integer(jscon_get_byindex(root, 999)));
+    jscon_destroy(root);
+    free(buffer);
+    for (int i=0; i < JSCON_ALLOC_NUM_CATEGORY; ++i){
+        assert(0 == stats.in_use[i]);
+    }
+
+    jscon_set_allocator(old_allocator);
+}
+
+/* modifying the array or its elements unpacks it, element items read
+    before stay valid */
+static void
+test_packed_write(void)
+{
+    char buffer[] = "{\"a\":[1,2,3],\"b\":[1.5,2.5],\"c\":[1,2,3],\"d\":[4,5,6]}";
+    jscon_item_t *root = jscon_parse(buffer);
+    size_t size;
+
+    jscon_item_t *a = jscon_get_branch(root, "a");
+    jscon_item_t *second = jscon_get_byindex(a, 1);
+    jscon_append(a, jscon_string("3", "x"));
+    assert(NULL == jscon_get_int_array(a, &size));
+    assert(second == jscon_get_byindex(a, 1));
+    assert(2 == jscon_get_integer(second));
+    assert(4 == jscon_size(a));
+
+    jscon_item_t *b = jscon_get_branch(root, "b");
+    jscon_set_double(jscon_get_byindex(b, 0), 9.5);
+    assert(NULL == jscon_get_double_array(b, &size));
+    assert(9.5 == jscon_get_double(jscon_get_byindex(b, 0)));
+
+    jscon_item_t *c = jscon_get_branch(root, "c");
+    jscon_delete(c, "1");
+    assert(NULL == jscon_get_int_array(c, &size));
+    assert(2 == jscon_size(c));
+
+    /* never read as items, unpacked by the write alone */
+    jscon_item_t *d = jscon_get_branch(root, "d");
+    jscon_append(d, jscon_integer("3", 7));
+    assert(7 == jscon_get_integer(jscon_get_byindex(d, 3)));
+
+    char expected_buffer[] = "{\"a\":[1,2,3,\"x\"],\"b\":[9.5,2.5],\"c\":[1,3],\"d\":[4,5,6,7]}";
+    jscon_item_t *expected = parse_generic(expected_buffer);
+    assert(jscon_equal(expected, root));
+    jscon_destroy(expected);
+
+    jscon_destroy(root);
+}
+
+static jscon_item_t *shared;
+static long long expected_sum;
+
+static void*
+reader_thread(void *arg)
+{
+    const enum jscon_iter_order order = *(enum jscon_iter_order*)arg;
+    for (int n=0; n < 20; ++n){
+        long long sum = 0;
+
+        jscon_iter_t iter;
+        jscon_iter_init(&iter, shared, order);
+        for (jscon_item_t *item; NULL != (item = jscon_iter_step(&iter)); ){
+            if (JSCON_INTEGER == jscon_get_type(item)){
+                sum += jscon_get_integer(item);
+            }
+        }
+        jscon_iter_destroy(&iter);
+        assert(expected_sum == sum);
+
+        /* random access races the walks that make the items */
+        jscon_item_t *row = jscon_get_byindex(shared, (size_t)n % jscon_size(shared));
+        assert(n % (long long)jscon_size(shared) == jscon_get_integer(jscon_get_byindex(row, 1)));
+    }
+    return NULL;
+}
+
+/* many threads read the same packed arrays as items at once */
+static void
+test_packed_threads(void)
+{
+    const size_t num_rows = 64, num_columns = 100;
+    char *buffer = malloc(num_rows * (num_columns * 8 + 4) + 3);
+    assert(NULL != buffer);
+
+    size_t len = sprintf(buffer, "[");
+    expected_sum = 0;
+    for (size_t i=0; i < num_rows; ++i){
+        len += sprintf(buffer + len, "%s[", (0 != i) ? "," : "");
+        for (size_t j=0; j < num_columns; ++j){
+            const long long value = (long long)(i * j);
+            len += sprintf(buffer + len, "%s%lld", (0 != j) ? "," : "", value);
+            expected_sum += value;
+        }
+        len += sprintf(buffer + len, "]");
+    }
+    sprintf(buffer + len, "]");
+
+    shared = jscon_parse(buffer);
+
+    enum jscon_iter_order orders[] = {JSCON_ITER_PREORDER, JSCON_ITER_POSTORDER};
+    pthread_t threads[8];
+    for (int i=0; i < 8; ++i){
+        assert(0 == pthread_create(&threads[i], NULL, &reader_thread, &orders[i % 2]));
+    }
+    for (int i=0; i < 8; ++i){
+        pthread_join(threads[i], NULL);
+    }
+
+    /* every row is still packed */
+    for (size_t i=0; i < num_rows; ++i){
+        size_t size;
+        assert(NULL != jscon_get_int_array(jscon_get_byindex(shared, i), &size));
+        assert(num_columns == size);
+    }
+
+    jscon_destroy(shared);
+    free(buffer);
+}
+
+int main(void)
+{
+    test_packed_vs_generic();
+    test_packed_read();
+    test_packed_iter_next();
+    test_packed_lazy();
+    test_packed_write();
+    test_packed_threads();
+
+    return EXIT_SUCCESS;
+}
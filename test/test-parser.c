@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <libjscon.h>
+
+
+static const char text[] = "{\"id\":10, \"name\":\"john\", \"tags\":[\"a\",\"b\"],"
+                           " \"pos\":{\"lat\":-23.5, \"lon\":-46.5}, \"ok\":true}";
+
+static void
+check_tree(jscon_item_t *root)
+{
+    assert(NULL != root);
+    assert(5 == jscon_size(root));
+    assert(10 == jscon_get_integer(jscon_get_branch(root, "id")));
+    assert(0 == strcmp("john", jscon_get_string(jscon_get_branch(root, "name"))));
+    assert(-46.5 == jscon_get_double(jscon_get_branch(jscon_get_branch(root, "pos"), "lon")));
+    assert(true == jscon_get_boolean(jscon_get_branch(root, "ok")));
+}
+
+/* parser trees hold the same values as jscon_parse() ones */
+static void
+test_parser_parse(void)
+{
+    char buffer[sizeof(text)];
+    jscon_parser_t *parser = jscon_parser_init();
+    assert(NULL != parser);
+
+    for (int i=0; i < 3; ++i){
+        memcpy(buffer, text, sizeof(text));
+        jscon_item_t *root = jscon_parser_parse(parser, buffer);
+        check_tree(root);
+
+        memcpy(buffer, text, sizeof(text));
+        jscon_item_t *generic = jscon_parse(buffer);
+        assert(true == jscon_equal(root, generic));
+        jscon_destroy(generic);
+
+        jscon_destroy(root); //no-op, tree is owned by the parser
+        jscon_parser_reset(parser);
+    }
+
+    jscon_parser_destroy(parser);
+}
+
+/* once reset, parsing a similar document takes no allocation */
+static void
+test_parser_recycle(void)
+{
+    jscon_alloc_stats_t stats = {0};
+    jscon_allocator_t counting = jscon_counting_allocator(&stats);
+
+    jscon_parser_t *parser = jscon_parser_init();
+    jscon_parser_set_allocator(parser, &counting);
+
+    char buffer[sizeof(text)];
+    memcpy(buffer, text, sizeof(text));
+    check_tree(jscon_parser_parse(parser, buffer));
+    jscon_parser_reset(parser);
+
+    size_t count = 0;
+    for (int i=0; i < JSCON_ALLOC_NUM_CATEGORY; ++i){
+        count += stats.count[i];
+    }
+    assert(0 != count);
+
+    for (int n=0; n < 10; ++n){
+        memcpy(buffer, text, sizeof(text));
+        check_tree(jscon_parser_parse(parser, buffer));
+        jscon_parser_reset(parser);
+    }
+
+    size_t new_count = 0;
+    for (int i=0; i < JSCON_ALLOC_NUM_CATEGORY; ++i){
+        new_count += stats.count[i];
+    }
+    assert(count == new_count);
+
+    jscon_parser_destroy(parser);
+    for (int i=0; i < JSCON_ALLOC_NUM_CATEGORY; ++i){
+        assert(0 == stats.in_use[i]);
+    }
+}
+
+static size_t num_callbacks;
+
+static jscon_item_t*
+count_callback(jscon_item_t *item)
+{
+    ++num_callbacks;
+    return item;
+}
+
+/* parser callback is its own, the global one isn't touched */
+static void
+test_parser_cb(void)
+{
+    jscon_parser_t *parser = jscon_parser_init();
+    jscon_cb *default_cb = jscon_parser_set_cb(parser, &count_callback);
+    assert(&count_callback == jscon_parser_set_cb(parser, &count_callback));
+
+    char buffer[sizeof(text)];
+    memcpy(buffer, text, sizeof(text));
+    check_tree(jscon_parser_parse(parser, buffer));
+    assert(0 != num_callbacks);
+
+    num_callbacks = 0;
+    memcpy(buffer, text, sizeof(text));
+    jscon_destroy(jscon_parse(buffer));
+    assert(0 == num_callbacks);
+
+    assert(&count_callback == jscon_parser_set_cb(parser, NULL));
+    assert(default_cb == jscon_parser_set_cb(parser, NULL));
+
+    jscon_parser_destroy(parser);
+}
+
+/* writes depth nested arrays around a number */
+static char*
+nested_text(size_t depth)
+{
+    char *buffer = malloc(2 * depth + 2);
+    assert(NULL != buffer);
+    memset(buffer, '[', depth);
+    buffer[depth] = '0';
+    memset(buffer + depth + 1, ']', depth);
+    buffer[2 * depth + 1] = '\0';
+    return buffer;
+}
+
+/* exceeding the parser limit returns NULL, jscon_parse() has none */
+static void
+test_parser_max_depth(void)
+{
+    jscon_parser_t *parser = jscon_parser_init();
+
+    char *buffer = nested_text(1024);
+    assert(NULL != jscon_parser_parse(parser, buffer));
+    free(buffer);
+
+    buffer = nested_text(1025);
+    assert(NULL == jscon_parser_parse(parser, buffer));
+    free(buffer);
+
+    jscon_parser_set_max_depth(parser, 2);
+    char shallow[] = "{\"a\":[1, {\"b\":\"c\"}]}";
+    assert(NULL == jscon_parser_parse(parser, shallow));
+    char object[] = "{\"a\":{\"b\":[]}}";
+    assert(NULL == jscon_parser_parse(parser, object));
+    char fits[] = "{\"a\":[1, \"b\"], \"c\":{}}";
+    assert(NULL != jscon_parser_parse(parser, fits));
+
+    jscon_parser_set_max_depth(parser, 0);
+    char root[] = "{}";
+    assert(NULL == jscon_parser_parse(parser, root));
+    char primitive[] = "10";
+    assert(10 == jscon_get_integer(jscon_parser_parse(parser, primitive)));
+
+    jscon_parser_destroy(parser);
+
+    /* no limit for jscon_parse() */
+    buffer = nested_text(5000);
+    jscon_item_t *deep = jscon_parse(buffer);
+    assert(NULL != deep);
+    jscon_destroy(deep);
+    free(buffer);
+}
+
+/* each thread keeps its own parser, with no shared mutable state */
+static void*
+parse_thread(void *arg)
+{
+    (void)arg;
+    jscon_parser_t *parser = jscon_parser_init();
+    char buffer[sizeof(text)];
+    for (int n=0; n < 200; ++n){
+        memcpy(buffer, text, sizeof(text));
+        check_tree(jscon_parser_parse(parser, buffer));
+        jscon_parser_reset(parser);
+    }
+    jscon_parser_destroy(parser);
+    return NULL;
+}
+
+static void
+test_parser_threads(void)
+{
+    pthread_t threads[4];
+    for (int i=0; i < 4; ++i){
+        assert(0 == pthread_create(&threads[i], NULL, &parse_thread, NULL));
+    }
+    for (int i=0; i < 4; ++i){
+        pthread_join(threads[i], NULL);
+    }
+}
+
+int main(void)
+{
+    test_parser_parse();
+    test_parser_recycle();
+    test_parser_cb();
+    test_parser_max_depth();
+    test_parser_threads();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+/* keys of array elements must match their position, and every
+    member must be found by its key */
+static void
+check_keys(jscon_item_t *item)
+{
+    jscon_iter_t iter;
+    jscon_iter_init(&iter, item, JSCON_ITER_COMPOSITE);
+    for (jscon_item_t *composite; NULL != (composite = jscon_iter_step(&iter)); ){
+        for (size_t i=0; i < jscon_size(composite); ++i){
+            jscon_item_t *branch = jscon_get_byindex(composite, i);
+            if (JSCON_ARRAY == jscon_get_type(composite)){
+                char key[32];
+                snprintf(key, sizeof(key), "%zu", i);
+                assert(0 == strcmp(key, jscon_get_key(branch)));
+            } else {
+                assert(NULL != jscon_get_branch(composite, jscon_get_key(branch)));
+            }
+        }
+    }
+    jscon_iter_destroy(&iter);
+}
+
+/* applies patch to doc, and compares the result against expected, or
+    checks that it fails if expected is NULL */
+static void
+check_patch(const char *doc, const char *patch_text, const char *expected)
+{
+    char *doc_buffer = strdup(doc);
+    char *patch_buffer = strdup(patch_text);
+    jscon_item_t *root = jscon_parse(doc_buffer);
+    jscon_item_t *patch = jscon_parse(patch_buffer);
+
+    const bool applied = jscon_patch(&root, patch);
+    if (NULL == expected){
+        assert(!applied);
+    } else {
+        assert(applied);
+        char *str = jscon_stringify(root, JSCON_ANY);
+        if (0 != strcmp(expected, str)){
+            fprintf(stderr, "%s\nexpected: %s\ngot: %s\n", patch_text, expected, str);
+            abort();
+        }
+        free(str);
+        check_keys(root);
+    }
+
+    jscon_destroy(patch);
+    jscon_destroy(root);
+    free(patch_buffer);
+    free(doc_buffer);
+}
+
+static void
+test_patch_operations(void)
+{
+    const char *doc = "{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":\"x\"}}";
+
+    check_patch(doc, "[{\"op\":\"add\",\"path\":\"/e\",\"value\":null}]",
+                "{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":\"x\"},\"e\":null}");
+    check_patch(doc, "[{\"op\":\"add\",\"path\":\"/a\",\"value\":[true]}]",
+                "{\"a\":[true],\"b\":[1,2,3],\"c\":{\"d\":\"x\"}}");
+    check_patch(doc, "[{\"op\":\"add\",\"path\":\"/b/0\",\"value\":0},{\"op\":\"add\",\"path\":\"/b/-\",\"value\":4}]",
+                "{\"a\":1,\"b\":[0,1,2,3,4],\"c\":{\"d\":\"x\"}}");
+    check_patch(doc, "[{\"op\":\"remove\",\"path\":\"/b/1\"},{\"op\":\"remove\",\"path\":\"/a\"}]",
+                "{\"b\":[1,3],\"c\":{\"d\":\"x\"}}");
+    check_patch(doc, "[{\"op\":\"replace\",\"path\":\"/c/d\",\"value\":{\"y\":2}}]",
+                "{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":{\"y\":2}}}");
+    check_patch(doc, "[{\"op\":\"move\",\"from\":\"/c/d\",\"path\":\"/b/1\"}]",
+                "{\"a\":1,\"b\":[1,\"x\",2,3],\"c\":{}}");
+    check_patch(doc, "[{\"op\":\"move\",\"from\":\"/b/0\",\"path\":\"/b/-\"}]",
+                "{\"a\":1,\"b\":[2,3,1],\"c\":{\"d\":\"x\"}}");
+    check_patch(doc, "[{\"op\":\"copy\",\"from\":\"/c\",\"path\":\"/f\"}]",
+                "{\"a\":1,\"b\":[1,2,3],\"c\":{\"d\":\"x\"},\"f\":{\"d\":\"x\"}}");
+    check_patch(doc, "[{\"op\":\"test\",\"path\":\"/b\",\"value\":[1,2,3.0]},{\"op\":\"remove\",\"path\":\"/b\"}]",
+                "{\"a\":1,\"c\":{\"d\":\"x\"}}");
+    check_patch(doc, "[]", doc);
+
+    /* the root itself */
+    check_patch(doc, "[{\"op\":\"replace\",\"path\":\"\",\"value\":[1]}]", "[1]");
+    check_patch(doc, "[{\"op\":\"add\",\"path\":\"\",\"value\":{\"z\":0}}]", "{\"z\":0}");
+}
+
+/* failing operations stop the patch, those before it stay applied */
+static void
+test_patch_errors(void)
+{
+    const char *doc = "{\"a\":1,\"b\":[1,2,3]}";
+
+    check_patch(doc, "[{\"op\":\"test\",\"path\":\"/a\",\"value\":2}]", NULL);
+    check_patch(doc, "[{\"op\":\"remove\",\"path\":\"/missing\"}]", NULL);
+    check_patch(doc, "[{\"op\":\"add\",\"path\":\"/b/4\",\"value\":0}]", NULL);
+    check_patch(doc, "[{\"op\":\"add\",\"path\":\"/b/01\",\"value\":0}]", NULL);
+    check_patch(doc, "[{\"op\":\"add\",\"path\":\"/x/y\",\"value\":0}]", NULL);
+    check_patch(doc, "[{\"op\":\"replace\",\"path\":\"/b/-\",\"value\":0}]", NULL);
+    check_patch(doc, "[{\"op\":\"move\",\"from\":\"/b\",\"path\":\"/b/0\"}]", NULL);
+    check_patch(doc, "[{\"op\":\"unknown\",\"path\":\"/a\"}]", NULL);
+    check_patch(doc, "[{\"op\":\"add\",\"path\":\"/a\"}]", NULL);
+    check_patch(doc, "[{\"path\":\"/a\",\"value\":0}]", NULL);
+
+    char doc_buffer[] = "{\"a\":1,\"b\":[1,2,3]}";
+    char patch_buffer[] = "[{\"op\":\"remove\",\"path\":\"/a\"},{\"op\":\"test\",\"path\":\"/b/0\",\"value\":9},"
+                          "{\"op\":\"remove\",\"path\":\"/b\"}]";
+    jscon_item_t *root = jscon_parse(doc_buffer);
+    jscon_item_t *patch = jscon_parse(patch_buffer);
+    assert(!jscon_patch(&root, patch));
+    char *str = jscon_stringify(root, JSCON_ANY);
+    assert(0 == strcmp(str, "{\"b\":[1,2,3]}"));
+    free(str);
+    check_keys(root);
+
+    jscon_destroy(patch);
+    jscon_destroy(root);
+}
+
+/* many operations on the same composite, the result must be indexed
+    as if it was parsed */
+static void
+test_patch_batch(void)
+{
+    jscon_item_t *root = jscon_object(NULL);
+    jscon_item_t *list = jscon_append(root, jscon_array("list"));
+    char key[16];
+    for (int i=0; i < 100; ++i){
+        snprintf(key, sizeof(key), "%d", i);
+        jscon_append(list, jscon_integer(key, i));
+    }
+
+    /* removes the even elements, starting from the end, then inserts
+        them back at the front in descending order */
+    char *patch_text = malloc(100 * 128);
+    size_t len = sprintf(patch_text, "[");
+    for (int i=98; i >= 0; i -= 2){
+        len += sprintf(patch_text + len, "{\"op\":\"remove\",\"path\":\"/list/%d\"},", i);
+    }
+    for (int i=0; i < 100; i += 2){
+        len += sprintf(patch_text + len, "%s{\"op\":\"add\",\"path\":\"/list/0\",\"value\":%d}", (0 != i) ? "," : "", i);
+    }
+    sprintf(patch_text + len, "]");
+
+    jscon_item_t *patch = jscon_parse(patch_text);
+    assert(jscon_patch(&root, patch));
+    check_keys(root);
+
+    assert(100 == jscon_size(list));
+    for (int i=0; i < 50; ++i){
+        assert(98 - 2*i == jscon_get_integer(jscon_get_byindex(list, i)));
+        assert(2*i + 1 == jscon_get_integer(jscon_get_byindex(list, 50 + i)));
+    }
+    assert(98 == jscon_get_integer(jscon_get_branch(list, "0")));
+
+    jscon_destroy(patch);
+    free(patch_text);
+    jscon_destroy(root);
+}
+
+static void
+check_merge(const char *doc, const char *merge_text, const char *expected)
+{
+    char *doc_buffer = strdup(doc);
+    char *merge_buffer = strdup(merge_text);
+    jscon_item_t *root = jscon_parse(doc_buffer);
+    jscon_item_t *merge = jscon_parse(merge_buffer);
+
+    jscon_merge_patch(&root, merge);
+
+    char *str = jscon_stringify(root, JSCON_ANY);
+    if (0 != strcmp(expected, str)){
+        fprintf(stderr, "%s\nexpected: %s\ngot: %s\n", merge_text, expected, str);
+        abort();
+    }
+    free(str);
+    check_keys(root);
+
+    jscon_destroy(merge);
+    jscon_destroy(root);
+    free(merge_buffer);
+    free(doc_buffer);
+}
+
+/* examples from RFC 7386 appendix A */
+static void
+test_merge_patch(void)
+{
+    check_merge("{\"a\":\"b\"}", "{\"a\":\"c\"}", "{\"a\":\"c\"}");
+    check_merge("{\"a\":\"b\"}", "{\"b\":\"c\"}", "{\"a\":\"b\",\"b\":\"c\"}");
+    check_merge("{\"a\":\"b\"}", "{\"a\":null}", "{}");
+    check_merge("{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}", "{\"b\":\"c\"}");
+    check_merge("{\"a\":[\"b\"]}", "{\"a\":\"c\"}", "{\"a\":\"c\"}");
+    check_merge("{\"a\":\"c\"}", "{\"a\":[\"b\"]}", "{\"a\":[\"b\"]}");
+    check_merge("{\"a\":{\"b\":\"c\"}}", "{\"a\":{\"b\":\"d\",\"c\":null}}", "{\"a\":{\"b\":\"d\"}}");
+    check_merge("{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}", "{\"a\":[1]}");
+    check_merge("[\"a\",\"b\"]", "[\"c\",\"d\"]", "[\"c\",\"d\"]");
+    check_merge("{\"a\":\"b\"}", "[\"c\"]", "[\"c\"]");
+    check_merge("{\"a\":\"foo\"}", "null", "null");
+    check_merge("{\"a\":\"foo\"}", "\"bar\"", "\"bar\"");
+    check_merge("{\"e\":null}", "{\"a\":1}", "{\"e\":null,\"a\":1}");
+    check_merge("[1,2]", "{\"a\":\"b\",\"c\":null}", "{\"a\":\"b\"}");
+    check_merge("{}", "{\"a\":{\"bb\":{\"ccc\":null}}}", "{\"a\":{\"bb\":{}}}");
+}
+
+int main(void)
+{
+    test_patch_operations();
+    test_patch_errors();
+    test_patch_batch();
+    test_merge_patch();
+
+    return EXIT_SUCCESS;
+}
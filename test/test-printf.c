@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <libjscon.h>
+
+
+static void
+test_snprintf(void)
+{
+    char buffer[256];
+    size_t len = jscon_snprintf(buffer, sizeof(buffer), "{%d[id], %s[name], \"tags\":[%s[], %s[]]}", 10, "john", "a", "b");
+    assert(0 == strcmp(buffer, "{\"id\":10,\"name\":\"john\",\"tags\":[\"a\",\"b\"]}"));
+    assert(strlen(buffer) == len);
+
+    jscon_snprintf(buffer, sizeof(buffer), "[%ld[], %lld[], %c[], %b[], %b[], %s[]]", 7L, -9LL, 'x', true, false, NULL);
+    assert(0 == strcmp(buffer, "[7,-9,\"x\",true,false,null]"));
+
+    jscon_snprintf(buffer, sizeof(buffer), "{%lf[d]}", 0.5);
+    jscon_item_t *root = jscon_parse(buffer);
+    assert(0.5 == jscon_get_double(jscon_get_branch(root, "d")));
+    jscon_destroy(root);
+}
+
+/* the returned length doesn't depend on the buffer size, and the
+    buffer is always nul terminated */
+static void
+test_snprintf_truncate(void)
+{
+    const size_t len = jscon_snprintf(NULL, 0, "{%s[name]}", "john");
+    assert(len == strlen("{\"name\":\"john\"}"));
+
+    char buffer[6];
+    assert(len == jscon_snprintf(buffer, sizeof(buffer), "{%s[name]}", "john"));
+    assert(0 == strcmp(buffer, "{\"nam"));
+}
+
+static void
+test_snprintf_item(void)
+{
+    char text[] = "{\"a\":[1,true,null]}";
+    jscon_item_t *root = jscon_parse(text);
+
+    char buffer[64];
+    jscon_snprintf(buffer, sizeof(buffer), "{%ji[doc], %ji[none]}", root, NULL);
+    assert(0 == strcmp(buffer, "{\"doc\":{\"a\":[1,true,null]},\"none\":null}"));
+
+    jscon_destroy(root);
+}
+
+static void
+test_printf_plan(void)
+{
+    jscon_printf_plan_t *plan = jscon_printf_compile("{%d[id], %s[name]}");
+    assert(NULL != plan);
+
+    char buffer[64], expected[64];
+    for (int i=0; i < 10; ++i){
+        jscon_printf_exec(plan, buffer, sizeof(buffer), i, "x");
+        jscon_snprintf(expected, sizeof(expected), "{%d[id], %s[name]}", i, "x");
+        assert(0 == strcmp(buffer, expected));
+    }
+
+    jscon_printf_destroy(plan);
+}
+
+/* C strings are escaped, so that the output is always valid json */
+static void
+test_snprintf_escape(void)
+{
+    char buffer[128];
+    jscon_snprintf(buffer, sizeof(buffer), "{%s[s], %c[c], %c[q]}", "x\"y\\z\n\x01", '\t', '\"');
+    assert(0 == strcmp(buffer, "{\"s\":\"x\\\"y\\\\z\\n\\u0001\",\"c\":\"\\t\",\"q\":\"\\\"\"}"));
+
+    jscon_item_t *root = jscon_parse(buffer);
+    assert(3 == jscon_size(root));
+    assert(0 == strcmp("x\\\"y\\\\z\\n\\u0001", jscon_get_string(jscon_get_branch(root, "s"))));
+    jscon_destroy(root);
+}
+
+/* doubles read back as the same value */
+static void
+test_snprintf_double(void)
+{
+    const double values[] = {1.5, 123456789.0, 0.1, -2.5e-300, 1.7976931348623157e308, 3.0000000000000004, 1.0/3.0};
+
+    char buffer[64];
+    jscon_snprintf(buffer, sizeof(buffer), "[%lf[], %lf[], %f[]]", 1.5, 123456789.0, 0.25f);
+    assert(0 == strcmp(buffer, "[1.5,123456789,0.25]"));
+
+    for (size_t i=0; i < sizeof(values)/sizeof(values[0]); ++i){
+        jscon_snprintf(buffer, sizeof(buffer), "%lf[]", values[i]);
+        assert(values[i] == strtod(buffer, NULL));
+    }
+}
+
+/* malformed formats are rejected, rather than aborting */
+static void
+test_printf_malformed(void)
+{
+    char *formats[] = {"{%d}", "{%x[a]}", "{%d[a}", "{%s[a], \"b"};
+    for (size_t i=0; i < sizeof(formats)/sizeof(formats[0]); ++i){
+        assert(NULL == jscon_printf_compile(formats[i]));
+    }
+
+    char buffer[16] = "untouched";
+    assert(0 == jscon_snprintf(buffer, sizeof(buffer), "{%d[a}", 1));
+    assert('\0' == *buffer);
+}
+
+static jscon_printf_plan_t *shared_plan;
+
+static void*
+printf_thread(void *arg)
+{
+    const double base = *(double*)arg;
+    char buffer[64], expected[64];
+    for (int i=0; i < 1000; ++i){
+        const double d_number = base + i / 7.0;
+        jscon_printf_exec(shared_plan, buffer, sizeof(buffer), i, d_number);
+        snprintf(expected, sizeof(expected), "{\"id\":%d,\"d\":", i);
+        assert(0 == strncmp(buffer, expected, strlen(expected)));
+        assert(d_number == strtod(buffer + strlen(expected), NULL));
+    }
+    return NULL;
+}
+
+/* a plan is shared by many threads at once */
+static void
+test_printf_threads(void)
+{
+    shared_plan = jscon_printf_compile("{%d[id], %lf[d]}");
+    assert(NULL != shared_plan);
+
+    double bases[8];
+    pthread_t threads[8];
+    for (int i=0; i < 8; ++i){
+        bases[i] = i * 1000.125;
+        assert(0 == pthread_create(&threads[i], NULL, &printf_thread, &bases[i]));
+    }
+    for (int i=0; i < 8; ++i){
+        pthread_join(threads[i], NULL);
+    }
+
+    jscon_printf_destroy(shared_plan);
+}
+
+int main(void)
+{
+    test_snprintf();
+    test_snprintf_truncate();
+    test_snprintf_item();
+    test_printf_plan();
+    test_snprintf_escape();
+    test_snprintf_double();
+    test_printf_malformed();
+    test_printf_threads();
+
+    return EXIT_SUCCESS;
+}
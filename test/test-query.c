@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+static char text[] = "{\"store\":{\"book\":["
+                        "{\"author\":\"Rees\",\"price\":8},"
+                        "{\"author\":\"Waugh\",\"price\":12},"
+                        "{\"author\":\"Melville\",\"price\":9},"
+                        "{\"author\":\"Tolkien\",\"price\":22}],"
+                     "\"bicycle\":{\"color\":\"red\",\"price\":19}},"
+                     "\"a/b\":1,\"m~n\":2,\"\":3,\"nums\":[0,1,2,3,4,5]}";
+
+/* concatenates matched strings and integers, comma separated */
+static bool
+join_cb(jscon_item_t *item, void *context)
+{
+    char *joined = context;
+    if (JSCON_STRING == jscon_get_type(item)){
+        strcat(joined, jscon_get_string(item));
+    } else if (JSCON_INTEGER == jscon_get_type(item)){
+        sprintf(joined + strlen(joined), "%lld", jscon_get_integer(item));
+    } else {
+        strcat(joined, jscon_typeof(item));
+    }
+    strcat(joined, ",");
+    return true;
+}
+
+/* query matches, joined by join_cb */
+static void
+check(jscon_item_t *root, const char *query_text, const char *expected)
+{
+    jscon_query_t *query = jscon_query_compile(query_text);
+    assert(NULL != query);
+
+    char joined[512] = "";
+    size_t num_match = jscon_query_exec(query, root, &join_cb, joined);
+    if (0 != strcmp(expected, joined)){
+        fprintf(stderr, "%s: expected '%s', got '%s'\n", query_text, expected, joined);
+        abort();
+    }
+
+    size_t num_expected = 0;
+    for (const char *c = expected; '\0' != *c; ++c){
+        num_expected += (',' == *c);
+    }
+    assert(num_expected == num_match);
+    assert(num_match == jscon_query_exec(query, root, NULL, NULL));
+
+    jscon_query_destroy(query);
+}
+
+static void
+test_query_path(void)
+{
+    jscon_item_t *root = jscon_parse(text);
+
+    check(root, "$.store.book[*].author", "Rees,Waugh,Melville,Tolkien,");
+    check(root, "$['store'][\"book\"][0].author", "Rees,");
+    check(root, "$.store.book[-1].author", "Tolkien,");
+    check(root, "$.store.book[ 1 , 2 ].price", "12,9,");
+    check(root, "$.store.book[1:3].author", "Waugh,Melville,");
+    check(root, "$.store.book[::-2].author", "Tolkien,Waugh,");
+    check(root, "$.store.book[:0].author", "");
+    check(root, "$.store..price", "8,12,9,22,19,");
+    check(root, "$..color", "red,");
+    check(root, "$.store.bicycle.*", "red,19,");
+    check(root, "$.nums[4:]", "4,5,");
+    check(root, "$.nums[10]", "");
+    check(root, "$.missing.book", "");
+    check(root, "$", "JSCON_OBJECT,");
+
+    /* the same query runs against other documents */
+    char other[] = "{\"store\":{\"book\":[{\"author\":\"Austen\"}]}}";
+    jscon_item_t *other_root = jscon_parse(other);
+    jscon_query_t *query = jscon_query_compile("$.store.book[*].author");
+    assert(0 == strcmp("Austen", jscon_get_string(jscon_query_first(query, other_root))));
+    assert(0 == strcmp("Rees", jscon_get_string(jscon_query_first(query, root))));
+    jscon_query_destroy(query);
+    jscon_destroy(other_root);
+
+    jscon_destroy(root);
+}
+
+static bool
+stop_cb(jscon_item_t *item, void *context)
+{
+    (void)item;
+    return 0 != --*(int*)context;
+}
+
+/* matching stops once the callback returns false */
+static void
+test_query_stop(void)
+{
+    jscon_item_t *root = jscon_parse(text);
+
+    jscon_query_t *query = jscon_query_compile("$..price");
+    int remaining = 2;
+    assert(2 == jscon_query_exec(query, root, &stop_cb, &remaining));
+    jscon_query_destroy(query);
+
+    jscon_destroy(root);
+}
+
+static void
+test_query_pointer(void)
+{
+    jscon_item_t *root = jscon_parse(text);
+
+    assert(root == jscon_get_pointer(root, ""));
+    assert(0 == strcmp("Waugh", jscon_get_string(jscon_get_pointer(root, "/store/book/1/author"))));
+    assert(1 == jscon_get_integer(jscon_get_pointer(root, "/a~1b")));
+    assert(2 == jscon_get_integer(jscon_get_pointer(root, "/m~0n")));
+    assert(3 == jscon_get_integer(jscon_get_pointer(root, "/")));
+
+    /* array indexes are plain decimals */
+    assert(NULL == jscon_get_pointer(root, "/store/book/01"));
+    assert(NULL == jscon_get_pointer(root, "/store/book/-1"));
+    assert(NULL == jscon_get_pointer(root, "/store/book/4"));
+    assert(NULL == jscon_get_pointer(root, "/store/missing"));
+
+    jscon_destroy(root);
+}
+
+/* malformed queries aren't compiled, and no char past the end of the
+    query is read */
+static void
+test_query_malformed(void)
+{
+    const char *malformed[] = {
+        "a", "$.", "$..", "$x", "$.a[", "$[", "$[*", "$[1", "$[1:", "$[1:2:",
+        "$[1,", "$['a", "$[\"a\\", "$[x]", "$[ ", "$.a.", "/~", "/a~2", "/~x/b",
+    };
+
+    for (size_t i=0; i < sizeof(malformed)/sizeof(malformed[0]); ++i){
+        /* copied to the heap, so that reading past it is caught */
+        const size_t len = strlen(malformed[i]);
+        char *query_text = malloc(len + 1);
+        assert(NULL != query_text);
+        memcpy(query_text, malformed[i], len + 1);
+
+        if (NULL != jscon_query_compile(query_text)){
+            fprintf(stderr, "%s: should not compile\n", query_text);
+            abort();
+        }
+        free(query_text);
+    }
+
+    jscon_item_t *root = jscon_parse(text);
+    assert(NULL == jscon_get_pointer(root, "/store~"));
+    jscon_destroy(root);
+}
+
+int main(void)
+{
+    test_query_path();
+    test_query_stop();
+    test_query_pointer();
+    test_query_malformed();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+/* every event is written to a text, in the order they are fired */
+struct events {
+    char text[1024];
+    size_t len;
+    size_t stop_at; //callback returns false at this event, if not 0
+    size_t num_events;
+};
+
+static bool
+record(struct events *ev, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    ev->len += vsnprintf(ev->text + ev->len, sizeof(ev->text) - ev->len, fmt, args);
+    va_end(args);
+    assert(ev->len < sizeof(ev->text));
+
+    return ++ev->num_events != ev->stop_at;
+}
+
+static bool on_object_begin(void *context){ return record(context, "{"); }
+static bool on_object_end(void *context){ return record(context, "}"); }
+static bool on_array_begin(void *context){ return record(context, "["); }
+static bool on_array_end(void *context){ return record(context, "]"); }
+static bool on_key(void *context, const char *key, size_t len){ return record(context, "k:%.*s ", (int)len, key); }
+static bool on_string(void *context, const char *string, size_t len){ return record(context, "s:%.*s ", (int)len, string); }
+static bool on_integer(void *context, long long i_number){ return record(context, "i:%lld ", i_number); }
+static bool on_double(void *context, double d_number){ return record(context, "d:%g ", d_number); }
+static bool on_boolean(void *context, bool boolean){ return record(context, "b:%d ", boolean); }
+static bool on_null(void *context){ return record(context, "n "); }
+
+static const jscon_sax_t sax = {
+    on_object_begin, on_object_end, on_array_begin, on_array_end,
+    on_key, on_string, on_integer, on_double, on_boolean, on_null
+};
+
+static void
+test_sax_events(void)
+{
+    char buffer[] = " {\"a\" : [1, -2.5, \"x\", true, false, null, {}, []], \"b\":{\"c\":\"\"}} ";
+
+    struct events ev = {0};
+    assert(true == jscon_sax_parse(buffer, &sax, &ev));
+    assert(0 == strcmp(ev.text, "{k:a [i:1 d:-2.5 s:x b:1 b:0 n {}[]]k:b {k:c s: }}"));
+
+    /* primitive root */
+    char primitive[] = "\"root\"";
+    ev = (struct events){0};
+    assert(true == jscon_sax_parse(primitive, &sax, &ev));
+    assert(0 == strcmp(ev.text, "s:root "));
+
+    /* NULL callbacks are ignored */
+    jscon_sax_t only_keys = {0};
+    only_keys.on_key = &on_key;
+    ev = (struct events){0};
+    assert(true == jscon_sax_parse(buffer, &only_keys, &ev));
+    assert(0 == strcmp(ev.text, "k:a k:b k:c "));
+}
+
+/* numbers are typed by their value, same as the generic tree */
+static void
+test_sax_numbers(void)
+{
+    char buffer[] = "[1.0, 1e2, -3E0, 0.5, 12345678901, 2.5e-1]";
+
+    struct events ev = {0};
+    assert(true == jscon_sax_parse(buffer, &sax, &ev));
+    assert(0 == strcmp(ev.text, "[i:1 i:100 i:-3 d:0.5 i:12345678901 d:0.25 ]"));
+
+    jscon_item_t *root = jscon_parse(buffer);
+    assert(JSCON_INTEGER == jscon_get_type(jscon_get_byindex(root, 0)));
+    assert(JSCON_INTEGER == jscon_get_type(jscon_get_byindex(root, 1)));
+    assert(JSCON_DOUBLE == jscon_get_type(jscon_get_byindex(root, 3)));
+    jscon_destroy(root);
+}
+
+/* a callback returning false stops parsing right away */
+static void
+test_sax_stop(void)
+{
+    char buffer[] = "{\"a\":[1,2,3], \"b\":4}";
+
+    struct events ev = {.stop_at = 4};
+    assert(false == jscon_sax_parse(buffer, &sax, &ev));
+    assert(4 == ev.num_events);
+    assert(0 == strcmp(ev.text, "{k:a [i:1 "));
+}
+
+/* nesting deeper than the limit is reported, instead of aborting */
+static void
+test_sax_depth(void)
+{
+    const size_t max_depth = 1024;
+    char *buffer = malloc(2 * (max_depth + 1) + 2);
+    assert(NULL != buffer);
+
+    for (size_t depth = max_depth; depth <= max_depth + 1; ++depth){
+        memset(buffer, '[', depth);
+        buffer[depth] = '0';
+        memset(buffer + depth + 1, ']', depth);
+        buffer[2 * depth + 1] = '\0';
+
+        assert((depth <= max_depth) == jscon_sax_parse(buffer, &(jscon_sax_t){0}, NULL));
+    }
+
+    free(buffer);
+}
+
+static size_t num_callbacks;
+
+static jscon_item_t*
+count_callback(jscon_item_t *item)
+{
+    ++num_callbacks;
+    return item;
+}
+
+/* the previous callback is returned, so that it can be restored */
+static void
+test_parse_cb(void)
+{
+    char buffer[] = "{\"a\":[1,2,3]}";
+
+    jscon_cb *default_cb = jscon_parse_cb(&count_callback);
+    assert(&count_callback != default_cb);
+
+    size_t len;
+    jscon_item_t *root = jscon_parse(buffer);
+    assert(num_callbacks >= 4); //every item is given to the callback
+    assert(NULL == jscon_get_int_array(jscon_get_branch(root, "a"), &len));
+    jscon_destroy(root);
+
+    assert(&count_callback == jscon_parse_cb(default_cb));
+
+    /* default callback is restored, arrays are packed again */
+    num_callbacks = 0;
+    root = jscon_parse(buffer);
+    assert(0 == num_callbacks);
+    assert(NULL != jscon_get_int_array(jscon_get_branch(root, "a"), &len));
+    assert(3 == len);
+    jscon_destroy(root);
+
+    /* NULL restores the default one as well */
+    jscon_parse_cb(&count_callback);
+    assert(&count_callback == jscon_parse_cb(NULL));
+    assert(default_cb == jscon_parse_cb(NULL));
+}
+
+int main(void)
+{
+    test_sax_events();
+    test_sax_numbers();
+    test_sax_stop();
+    test_sax_depth();
+    test_parse_cb();
+
+    return EXIT_SUCCESS;
+}
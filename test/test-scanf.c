@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libjscon.h>
+
+
+static void
+test_scanf(void)
+{
+    char buffer[] = "{\"alpha\":[1,2,3,4], \"beta\":\"a string\", \"gamma\":true, \"delta\":null, \"pi\":3.5}";
+
+    jscon_item_t *item = NULL;
+    char string[32] = {0};
+    bool boolean = false;
+    int delta = -1;
+    double pi = 0.0;
+    /* order of arguments doesn't have to be the same as the json string */
+    jscon_scanf(buffer, "%s[beta] %b[gamma] %ji[alpha] %d[delta] %lf[pi]", string, &boolean, &item, &delta, &pi);
+
+    assert(0 == strcmp(string, "a string"));
+    assert(true == boolean);
+    assert(0 == delta);
+    assert(3.5 == pi);
+    assert(NULL != item && 4 == jscon_size(item));
+    assert(3 == jscon_get_integer(jscon_get_byindex(item, 2)));
+    jscon_destroy(item);
+}
+
+static void
+test_scanf_plan(void)
+{
+    jscon_scanf_plan_t *plan = jscon_scanf_compile("%d[id] %lf[score]");
+    assert(NULL != plan);
+
+    char *buffers[] = {
+        "{\"id\":1, \"score\":0.5}",
+        "{\"score\":1.5, \"id\":2}",
+        "{\"other\":{\"id\":9}, \"id\":3, \"score\":2.5}",
+    };
+    for (int i=0; i < 3; ++i){
+        char buffer[64];
+        strcpy(buffer, buffers[i]);
+
+        int id = 0;
+        double score = 0.0;
+        jscon_scanf_exec(plan, buffer, &id, &score);
+        assert(i+1 == id);
+        assert(0.5 + i == score);
+    }
+
+    jscon_scanf_destroy(plan);
+}
+
+static void
+test_scanf_path(void)
+{
+    char buffer[] = "{\"data\":{\"metrics\":{\"latency\":1.5, \"count\":7}}, "
+                    "\"items\":[{\"name\":\"first\"}, {\"name\":\"second\"}], "
+                    "\"metrics\":{\"latency\":9.5}}";
+
+    double latency = 0.0, top_latency = 0.0;
+    int count = 0;
+    char name[16] = {0};
+    jscon_scanf(buffer, "%lf[data.metrics.latency] %d[data.metrics.count] %s[items.1.name] %lf[metrics.latency]",
+                &latency, &count, name, &top_latency);
+
+    assert(1.5 == latency);
+    assert(7 == count);
+    assert(0 == strcmp(name, "second"));
+    assert(9.5 == top_latency);
+
+    /* paths that don't match the document layout are left untouched */
+    int missing = -1, wrong_type = -1;
+    jscon_scanf(buffer, "%d[data.none.count] %d[items.name]", &missing, &wrong_type);
+    assert(-1 == missing);
+    assert(-1 == wrong_type);
+}
+
+/* scanning stops once every key is assigned, whatever follows is
+    never read */
+static void
+test_scanf_early_exit(void)
+{
+    char buffer[] = "{\"id\":42, \"name\":\"x\", \"rest\":[1, 2,";
+
+    int id = 0;
+    char name[8] = {0};
+    jscon_scanf(buffer, "%d[id] %s[name]", &id, name);
+    assert(42 == id);
+    assert(0 == strcmp(name, "x"));
+}
+
+/* keys are matched in place, so keys sharing a prefix and escaped
+    keys must not be confused */
+static void
+test_scanf_key_match(void)
+{
+    char buffer[] = "{\"ab\":1, \"a\":2, \"abc\":3, \"a\\\"b\":4}";
+
+    int a = 0, ab = 0, abc = 0;
+    jscon_scanf(buffer, "%d[abc] %d[a] %d[ab]", &abc, &a, &ab);
+    assert(2 == a);
+    assert(1 == ab);
+    assert(3 == abc);
+}
+
+/* skipped values hold delimiters inside strings, escapes and deep
+    nests, at every offset from the 64 bytes blocks they're read by */
+static void
+test_scanf_skip(void)
+{
+    const char skipped[] = "{\"s\":\"}]{[\\\"\\\\\", \"n\":[[[{\"k\":\"]\"}]], {}, []], "
+                           "\"long\":\"0123456789012345678901234567890123456789012345678901234567890123456789\"}";
+
+    for (size_t pad=0; pad < 128; ++pad){
+        char buffer[512];
+        size_t len = 0;
+        len += sprintf(buffer + len, "{\"%*s\":1, \"skip\":", (int)pad, "");
+        len += sprintf(buffer + len, "%s, \"str\":\"\\\"}\", \"target\":%zu}", skipped, pad);
+
+        long long target = -1;
+        jscon_scanf(buffer, "%lld[target]", &target);
+        assert((long long)pad == target);
+    }
+}
+
+static void
+test_scanf_array(void)
+{
+    char buffer[] = "{\"samples\":[0.5, 1.25, 2], \"ids\":[3,5,8,13,21], "
+                    "\"names\":[\"ann\", \"bob\"], \"none\":null, \"empty\":[]}";
+
+    double samples[8];
+    size_t num_samples = 0;
+    int ids[3];
+    size_t num_ids = 0;
+    char name_buf[2][8];
+    char *names[2] = {name_buf[0], name_buf[1]};
+    size_t num_names = 0;
+    int none[1];
+    size_t num_none = 99;
+    long long empty[1];
+    size_t num_empty = 99;
+    jscon_scanf(buffer, "%lf*[samples] %d*[ids] %s*[names] %d*[none] %lld*[empty]",
+                samples, (size_t)8, &num_samples,
+                ids, (size_t)3, &num_ids,
+                names, (size_t)2, &num_names,
+                none, (size_t)1, &num_none,
+                empty, (size_t)1, &num_empty);
+
+    assert(3 == num_samples);
+    assert(0.5 == samples[0] && 1.25 == samples[1] && 2.0 == samples[2]);
+
+    /* truncated, though every element is counted */
+    assert(5 == num_ids);
+    assert(3 == ids[0] && 5 == ids[1] && 8 == ids[2]);
+
+    assert(2 == num_names);
+    assert(0 == strcmp(names[0], "ann") && 0 == strcmp(names[1], "bob"));
+
+    assert(0 == num_none);
+    assert(0 == num_empty);
+}
+
+/* malformed formats are rejected, and no argument is assigned */
+static void
+test_scanf_malformed(void)
+{
+    char *formats[] = {
+        "",
+        "no specifiers",
+        "%d",
+        "%d[id",
+        "%d[id] %s",
+        "%q[id]",
+        "%[id]",
+        "%d[id] %d[id]",
+        "%d[a] %d[a.b]",
+        "%d[a.b] %d[a]",
+        "]%d[id]",
+    };
+    for (size_t i=0; i < sizeof(formats)/sizeof *formats; ++i){
+        assert(NULL == jscon_scanf_compile(formats[i]));
+    }
+
+    char buffer[] = "{\"id\":10}";
+    int id = -1;
+    jscon_scanf(buffer, "%d[id", &id);
+    assert(-1 == id);
+}
+
+int main(void)
+{
+    test_scanf();
+    test_scanf_plan();
+    test_scanf_path();
+    test_scanf_early_exit();
+    test_scanf_key_match();
+    test_scanf_skip();
+    test_scanf_array();
+    test_scanf_malformed();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <libjscon.h>
+
+
+static long long
+version_counter(const jscon_version_t *version)
+{
+    const jscon_tape_t *tape = jscon_version_get_tape(version);
+    return jscon_tape_get_integer(tape, jscon_tape_get_branch(tape, 0, "counter"));
+}
+
+/* a version keeps the tree as it was published, edits made after it
+    are only seen by later versions */
+static void
+test_store_versions(void)
+{
+    char buffer[] = "{\"counter\":0}";
+    jscon_store_t *store = jscon_store_init(jscon_parse(buffer));
+    assert(NULL != store);
+
+    jscon_version_t *first = jscon_store_acquire(store);
+    assert(1 == jscon_version_get_number(first));
+
+    jscon_item_t *counter = jscon_get_branch(jscon_store_get_root(store), "counter");
+    jscon_set_integer(counter, 1);
+
+    jscon_version_t *same = jscon_store_acquire(store);
+    assert(first == same);
+    assert(0 == version_counter(same));
+    jscon_version_release(same);
+
+    assert(2 == jscon_store_publish(store));
+    jscon_version_t *second = jscon_store_acquire(store);
+    assert(2 == jscon_version_get_number(second));
+    assert(1 == version_counter(second));
+    assert(0 == version_counter(first));
+
+    /* held versions outlive the store */
+    jscon_store_destroy(store);
+    assert(0 == version_counter(first));
+    assert(1 == version_counter(second));
+    jscon_version_release(first);
+    jscon_version_release(second);
+}
+
+/* a tree that can't be frozen isn't published, the latest version is
+    kept */
+static void
+test_store_publish_fail(void)
+{
+    jscon_item_t *root = jscon_object(NULL);
+    jscon_append(root, jscon_integer("counter", 0));
+    jscon_store_t *store = jscon_store_init(root);
+    assert(NULL != store);
+
+    jscon_item_t *item = root;
+    for (int i=0; i < 1025; ++i){
+        item = jscon_append(item, jscon_array("a"));
+    }
+    assert(0 == jscon_store_publish(store));
+
+    jscon_version_t *version = jscon_store_acquire(store);
+    assert(1 == jscon_version_get_number(version));
+    jscon_version_release(version);
+
+    jscon_delete(root, "a");
+    assert(2 == jscon_store_publish(store));
+
+    jscon_store_destroy(store);
+
+    /* the caller keeps the tree when the store can't be made */
+    root = jscon_object(NULL);
+    item = root;
+    for (int i=0; i < 1025; ++i){
+        item = jscon_append(item, jscon_array("a"));
+    }
+    assert(NULL == jscon_store_init(root));
+    jscon_destroy(root);
+}
+
+#define NUM_PUBLISH 2000
+
+static jscon_store_t *shared;
+
+static void*
+reader_thread(void *arg)
+{
+    (void)arg;
+
+    size_t last_number = 0;
+    while (last_number < NUM_PUBLISH + 1){
+        jscon_version_t *version = jscon_store_acquire(shared);
+
+        const size_t number = jscon_version_get_number(version);
+        assert(number >= last_number);
+        assert((long long)number - 1 == version_counter(version));
+        last_number = number;
+
+        jscon_version_release(version);
+    }
+    return NULL;
+}
+
+/* readers never see a version freed, or one older than the last they
+    acquired, while the writer keeps publishing */
+static void
+test_store_threads(void)
+{
+    char buffer[] = "{\"counter\":0, \"name\":\"config\"}";
+    shared = jscon_store_init(jscon_parse(buffer));
+
+    pthread_t threads[8];
+    for (int i=0; i < 8; ++i){
+        assert(0 == pthread_create(&threads[i], NULL, &reader_thread, NULL));
+    }
+
+    jscon_item_t *counter = jscon_get_branch(jscon_store_get_root(shared), "counter");
+    for (long long i=1; i <= NUM_PUBLISH; ++i){
+        jscon_set_integer(counter, i);
+        assert((size_t)i + 1 == jscon_store_publish(shared));
+    }
+
+    for (int i=0; i < 8; ++i){
+        pthread_join(threads[i], NULL);
+    }
+
+    jscon_store_destroy(shared);
+}
+
+int main(void)
+{
+    test_store_versions();
+    test_store_publish_fail();
+    test_store_threads();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <libjscon.h>
+
+
+struct position {
+    double lat;
+    double lon;
+};
+
+struct message {
+    int id;
+    long long stamp;
+    float ratio;
+    bool active;
+    char initial;
+    char name[8];
+    struct position pos;
+};
+
+static const jscon_field_t position_desc[] = {
+    JSCON_FIELD("lat", JSCON_FIELD_DOUBLE, struct position, lat),
+    JSCON_FIELD("lon", JSCON_FIELD_DOUBLE, struct position, lon),
+    {NULL}
+};
+
+static const jscon_field_t message_desc[] = {
+    JSCON_FIELD("id", JSCON_FIELD_INT, struct message, id),
+    JSCON_FIELD("stamp", JSCON_FIELD_LLONG, struct message, stamp),
+    JSCON_FIELD("ratio", JSCON_FIELD_FLOAT, struct message, ratio),
+    JSCON_FIELD("active", JSCON_FIELD_BOOLEAN, struct message, active),
+    JSCON_FIELD("initial", JSCON_FIELD_CHAR, struct message, initial),
+    JSCON_FIELD("name", JSCON_FIELD_STRING, struct message, name),
+    JSCON_FIELD_NESTED("pos", position_desc, struct message, pos),
+    {NULL}
+};
+
+/* copy text to a buffer of its exact size, so that any read past the
+    nul char is caught by the address sanitizer */
+static char*
+exact_copy(const char *text)
+{
+    const size_t size = strlen(text) + 1;
+    char *buffer = malloc(size);
+    assert(NULL != buffer);
+    memcpy(buffer, text, size);
+    return buffer;
+}
+
+static void
+test_decode_struct(void)
+{
+    char *buffer = exact_copy("  {\"extra\":[1,{\"id\":2}], \"id\":10, \"stamp\":-9000000000, \"ratio\":0.5,"
+                              " \"active\":true, \"initial\":\"jk\", \"name\":\"john doe\","
+                              " \"pos\":{\"lon\":-46.5, \"lat\":-23.5}} trailing");
+
+    struct message msg = {0};
+    size_t len = jscon_decode_struct(message_desc, buffer, &msg);
+    assert(0 == strcmp(buffer + len, " trailing"));
+
+    assert(10 == msg.id);
+    assert(-9000000000LL == msg.stamp);
+    assert(0.5f == msg.ratio);
+    assert(true == msg.active);
+    assert('j' == msg.initial);
+    assert(0 == strcmp(msg.name, "john do")); //truncated to member size
+    assert(-23.5 == msg.pos.lat);
+    assert(-46.5 == msg.pos.lon);
+
+    free(buffer);
+}
+
+/* missing keys are left untouched, null zeroes the member */
+static void
+test_decode_struct_missing(void)
+{
+    char *buffer = exact_copy("{\"name\":null, \"pos\":null, \"id\":1e2}");
+
+    struct message msg = {.stamp = 7, .name = "x", .pos = {1.0, 2.0}};
+    jscon_decode_struct(message_desc, buffer, &msg);
+    assert(100 == msg.id);
+    assert(7 == msg.stamp);
+    assert('\0' == *msg.name);
+    assert(0.0 == msg.pos.lat && 0.0 == msg.pos.lon);
+
+    free(buffer);
+}
+
+/* decoding of unclosed objects stops at the nul char, the error is
+    reported (an abort while in debug mode) with nothing read past it */
+static void
+test_decode_struct_truncated(void)
+{
+    const char *texts[] = {
+        "", "   ", "{", "{\"id\"", "{\"id\":", "{\"id\":10", "{\"id\":10,",
+        "{\"name\":\"jo", "{\"name\":\"jo\\", "{\"name\":\"jo\"", "{\"name\":\"",
+        "{\"pos\":{\"lat\":1.5", "{\"extra\":[1,2", "{\"extra\":tru", "{\"ext",
+    };
+
+    for (size_t i=0; i < sizeof(texts)/sizeof(texts[0]); ++i){
+        pid_t pid = fork();
+        assert(-1 != pid);
+        if (0 == pid){
+            freopen("/dev/null", "w", stderr);
+
+            char *buffer = exact_copy(texts[i]);
+            struct message msg = {0};
+            size_t len = jscon_decode_struct(message_desc, buffer, &msg);
+            free(buffer);
+            _exit(len <= strlen(texts[i]) ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+
+        int status;
+        assert(pid == waitpid(pid, &status, 0));
+        assert((WIFEXITED(status) && EXIT_SUCCESS == WEXITSTATUS(status))
+                || (WIFSIGNALED(status) && SIGABRT == WTERMSIG(status)));
+    }
+}
+
+static void
+test_encode_struct(void)
+{
+    struct message msg = {
+        .id = 10, .stamp = -9000000000LL, .ratio = 0.25f, .active = false,
+        .initial = 'j', .name = "john", .pos = {-23.5, -46.5}
+    };
+
+    char buffer[256];
+    size_t len = jscon_encode_struct(message_desc, &msg, buffer, sizeof(buffer));
+    assert(strlen(buffer) == len);
+
+    struct message copy = {0};
+    assert(len == jscon_decode_struct(message_desc, buffer, &copy));
+    assert(msg.id == copy.id);
+    assert(msg.stamp == copy.stamp);
+    assert(msg.ratio == copy.ratio);
+    assert(msg.active == copy.active);
+    assert(msg.initial == copy.initial);
+    assert(0 == strcmp(msg.name, copy.name));
+    assert(msg.pos.lat == copy.pos.lat);
+    assert(msg.pos.lon == copy.pos.lon);
+
+    /* encoded text is a valid json object */
+    jscon_item_t *root = jscon_parse(buffer);
+    assert(10 == jscon_get_integer(jscon_get_branch(root, "id")));
+    jscon_destroy(root);
+
+    /* same length is returned when the text doesn't fit */
+    char small[8];
+    assert(len == jscon_encode_struct(message_desc, &msg, small, sizeof(small)));
+    assert(strlen(small) < sizeof(small));
+}
+
+/* escaped strings and doubles read back as the very same members */
+static void
+test_struct_roundtrip(void)
+{
+    struct message msg = {
+        .id = INT_MIN, .stamp = LLONG_MAX, .ratio = 0.1f, .active = true,
+        .initial = '\"', .name = "a\"b\\\n\x01", .pos = {0.1, -123456.789012345}
+    };
+
+    char buffer[256];
+    size_t len = jscon_encode_struct(message_desc, &msg, buffer, sizeof(buffer));
+    assert(strlen(buffer) == len);
+
+    /* valid json, with escaped strings */
+    jscon_item_t *root = jscon_parse(buffer);
+    assert(7 == jscon_size(root));
+    assert(0 == strcmp("a\\\"b\\\\\\n\\u0001", jscon_get_string(jscon_get_branch(root, "name"))));
+    assert(0 == strcmp("\\\"", jscon_get_string(jscon_get_branch(root, "initial"))));
+    jscon_destroy(root);
+
+    struct message copy = {0};
+    assert(len == jscon_decode_struct(message_desc, buffer, &copy));
+    assert(msg.id == copy.id);
+    assert(msg.stamp == copy.stamp);
+    assert(msg.ratio == copy.ratio);
+    assert(msg.initial == copy.initial);
+    assert(0 == strcmp(msg.name, copy.name));
+    assert(msg.pos.lat == copy.pos.lat);
+    assert(msg.pos.lon == copy.pos.lon);
+
+    /* escapes are decoded, unicode ones as utf-8 */
+    char *text = exact_copy("{\"initial\":\"\\t\", \"name\":\"\\u00e9\\/\\ud83d\\ude00x\"}");
+    jscon_decode_struct(message_desc, text, &copy);
+    assert('\t' == copy.initial);
+    assert(0 == strcmp("\xc3\xa9/\xf0\x9f\x98\x80", copy.name)); //'x' doesn't fit
+    free(text);
+}
+
+/* integers that don't fit their member are a type error (an abort
+    while in debug mode), rather than being narrowed */
+static void
+test_decode_struct_range(void)
+{
+    char *buffer = exact_copy("{\"id\":2147483647}");
+    struct message msg = {0};
+    jscon_decode_struct(message_desc, buffer, &msg);
+    assert(INT_MAX == msg.id);
+    free(buffer);
+
+    const char *texts[] = {"{\"id\":2147483648}", "{\"id\":-2147483649}", "{\"id\":9000000000}"};
+    for (size_t i=0; i < sizeof(texts)/sizeof(texts[0]); ++i){
+        pid_t pid = fork();
+        assert(-1 != pid);
+        if (0 == pid){
+            freopen("/dev/null", "w", stderr);
+
+            char *text = exact_copy(texts[i]);
+            struct message copy = {0};
+            jscon_decode_struct(message_desc, text, &copy);
+            free(text);
+            _exit((0 == copy.id) ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+
+        int status;
+        assert(pid == waitpid(pid, &status, 0));
+        assert((WIFEXITED(status) && EXIT_SUCCESS == WEXITSTATUS(status))
+                || (WIFSIGNALED(status) && SIGABRT == WTERMSIG(status)));
+    }
+}
+
+int main(void)
+{
+    test_decode_struct();
+    test_decode_struct_missing();
+    test_decode_struct_truncated();
+    test_encode_struct();
+    test_struct_roundtrip();
+    test_decode_struct_range();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <libjscon.h>
+
+
+static char text[] = "{\"id\":10,\"name\":\"john\",\"ok\":true,\"no\":false,\"none\":null,"
+                     "\"whole\":1.0,\"exp\":1e2,\"ratio\":-0.25,\"ints\":[1,2,3],"
+                     "\"doubles\":[0.5,1.5],\"mixed\":[1,\"a\",[],{}],\"empty\":{},"
+                     "\"nested\":{\"b\":[{\"c\":[[1]]}],\"a\":\"x\"}}";
+
+/* tape value at index must be the same as item, recursively */
+static void
+compare(const jscon_tape_t *tape, size_t index, jscon_item_t *item)
+{
+    const enum jscon_type type = jscon_get_type(item);
+    assert(type == jscon_tape_get_type(tape, index));
+
+    switch (type){
+    case JSCON_INTEGER:
+        assert(jscon_get_integer(item) == jscon_tape_get_integer(tape, index));
+        return;
+    case JSCON_DOUBLE:
+        assert(jscon_get_double(item) == jscon_tape_get_double(tape, index));
+        return;
+    case JSCON_BOOLEAN:
+        assert(jscon_get_boolean(item) == jscon_tape_get_boolean(tape, index));
+        return;
+    case JSCON_STRING:
+        assert(0 == strcmp(jscon_get_string(item), jscon_tape_get_string(tape, index)));
+        return;
+    case JSCON_OBJECT:
+    case JSCON_ARRAY:
+        break;
+    default:
+        return;
+    }
+
+    assert(jscon_size(item) == jscon_tape_size(tape, index));
+    for (size_t i=0; i < jscon_size(item); ++i){
+        jscon_item_t *branch = jscon_get_byindex(item, i);
+        size_t tape_branch = jscon_tape_get_byindex(tape, index, i);
+        assert(0 != tape_branch);
+
+        if (JSCON_OBJECT == type){
+            assert(0 == strcmp(jscon_get_key(branch), jscon_tape_get_key(tape, tape_branch)));
+            assert(tape_branch == jscon_tape_get_branch(tape, index, jscon_get_key(branch)));
+        }
+        compare(tape, tape_branch, branch);
+    }
+    assert(0 == jscon_tape_get_byindex(tape, index, jscon_size(item)));
+}
+
+/* a tape reads the same values as the tree, numbers included */
+static void
+test_tape_vs_tree(void)
+{
+    char buffer[sizeof(text)];
+    memcpy(buffer, text, sizeof(text));
+    jscon_tape_t *tape = jscon_tape_parse(buffer);
+    assert(NULL != tape);
+
+    memcpy(buffer, text, sizeof(text));
+    jscon_item_t *root = jscon_parse(buffer);
+
+    compare(tape, 0, root);
+
+    size_t whole = jscon_tape_get_branch(tape, 0, "whole");
+    assert(JSCON_INTEGER == jscon_tape_get_type(tape, whole));
+    assert(1 == jscon_tape_get_integer(tape, whole));
+    assert(100 == jscon_tape_get_integer(tape, jscon_tape_get_branch(tape, 0, "exp")));
+
+    /* freezing the tree gives the same tape */
+    jscon_tape_t *frozen = jscon_freeze(root);
+    assert(NULL != frozen);
+    compare(frozen, 0, root);
+
+    jscon_tape_destroy(frozen);
+    jscon_tape_destroy(tape);
+    jscon_destroy(root);
+}
+
+static void
+test_tape_branch(void)
+{
+    char buffer[] = "{\"b\":1, \"a\":2, \"c\":{}, \"a\":3}";
+    jscon_tape_t *tape = jscon_tape_parse(buffer);
+
+    assert(4 == jscon_tape_size(tape, 0));
+    assert(3 == jscon_tape_get_integer(tape, jscon_tape_get_branch(tape, 0, "a"))); //last one
+    assert(1 == jscon_tape_get_integer(tape, jscon_tape_get_branch(tape, 0, "b")));
+    assert(0 == jscon_tape_get_branch(tape, 0, "d"));
+    assert(0 == jscon_tape_get_branch(tape, 0, ""));
+
+    size_t c = jscon_tape_get_branch(tape, 0, "c");
+    assert(0 == jscon_tape_size(tape, c));
+    assert(0 == jscon_tape_get_branch(tape, c, "a"));
+    assert(0 == strcmp("c", jscon_tape_get_key(tape, c)));
+
+    /* every value is visited, in the same order as the text */
+    size_t num_values = 0;
+    size_t index = 0;
+    do {
+        ++num_values;
+    } while (0 != (index = jscon_tape_iter_next(tape, index)));
+    assert(5 == num_values);
+
+    jscon_tape_destroy(tape);
+
+    char empty[] = "{}";
+    tape = jscon_tape_parse(empty);
+    assert(JSCON_OBJECT == jscon_tape_get_type(tape, 0));
+    assert(0 == jscon_tape_size(tape, 0));
+    jscon_tape_destroy(tape);
+}
+
+/* only object members have keys, whatever the entry before a value
+    holds */
+static void
+test_tape_key(void)
+{
+    /* number bits that look like a key entry */
+    char buffer[] = "[7710162562058289152, 5, {\"a\":7710162562058289152, \"b\":[1]}]";
+    jscon_tape_t *tape = jscon_tape_parse(buffer);
+    assert(NULL != tape);
+
+    assert(NULL == jscon_tape_get_key(tape, 0));
+    assert(NULL == jscon_tape_get_key(tape, jscon_tape_get_byindex(tape, 0, 0)));
+    assert(NULL == jscon_tape_get_key(tape, jscon_tape_get_byindex(tape, 0, 1)));
+    assert(5 == jscon_tape_get_integer(tape, jscon_tape_get_byindex(tape, 0, 1)));
+
+    size_t object = jscon_tape_get_byindex(tape, 0, 2);
+    assert(NULL == jscon_tape_get_key(tape, object));
+    assert(0 == strcmp("b", jscon_tape_get_key(tape, jscon_tape_get_byindex(tape, object, 1))));
+
+    size_t list = jscon_tape_get_branch(tape, object, "b");
+    assert(NULL == jscon_tape_get_key(tape, jscon_tape_get_byindex(tape, list, 0)));
+
+    jscon_tape_destroy(tape);
+}
+
+/* branches are reached by position through composites of any size,
+    with nested composites in between */
+static void
+test_tape_byindex(void)
+{
+    const size_t num_branch = 100;
+    char *buffer = malloc(num_branch * 32 + 16);
+    assert(NULL != buffer);
+
+    size_t len = sprintf(buffer, "{\"list\":[");
+    for (size_t i=0; i < num_branch; ++i){
+        len += sprintf(buffer + len, (0 == i % 3) ? "%s[%zu,{}]" : "%s%zu", (0 != i) ? "," : "", i);
+    }
+    len += sprintf(buffer + len, "],\"object\":{");
+    for (size_t i=0; i < num_branch; ++i){
+        len += sprintf(buffer + len, (0 == i % 3) ? "%s\"k%zu\":{\"v\":%zu}" : "%s\"k%zu\":%zu", (0 != i) ? "," : "", i, i);
+    }
+    sprintf(buffer + len, "}}");
+
+    jscon_item_t *root = jscon_parse(buffer);
+    jscon_tape_t *tape = jscon_freeze(root);
+    assert(NULL != tape);
+    compare(tape, 0, root);
+
+    size_t list = jscon_tape_get_branch(tape, 0, "list");
+    size_t object = jscon_tape_get_branch(tape, 0, "object");
+    for (size_t i=0; i < num_branch; ++i){
+        size_t element = jscon_tape_get_byindex(tape, list, i);
+        size_t member = jscon_tape_get_byindex(tape, object, i);
+        if (0 == i % 3){
+            element = jscon_tape_get_byindex(tape, element, 0);
+            member = jscon_tape_get_branch(tape, member, "v");
+        }
+        assert((long long)i == jscon_tape_get_integer(tape, element));
+        assert((long long)i == jscon_tape_get_integer(tape, member));
+    }
+    assert(0 == jscon_tape_get_byindex(tape, list, num_branch));
+    assert(0 == jscon_tape_get_byindex(tape, object, num_branch));
+
+    /* every value is still visited */
+    size_t num_values = 0;
+    size_t index = 0;
+    do {
+        ++num_values;
+    } while (0 != (index = jscon_tape_iter_next(tape, index)));
+    const size_t num_nested = (num_branch + 2) / 3;
+    assert(3 + 2 * num_branch + 3 * num_nested == num_values);
+
+    jscon_tape_destroy(tape);
+    jscon_destroy(root);
+    free(buffer);
+}
+
+/* documents nested deeper than the tape allows aren't parsed */
+static void
+test_tape_depth(void)
+{
+    const size_t max_depth = 1024;
+    char *buffer = malloc(2 * (max_depth + 1) + 2);
+    assert(NULL != buffer);
+
+    for (size_t depth = max_depth; depth <= max_depth + 1; ++depth){
+        memset(buffer, '[', depth);
+        buffer[depth] = '0';
+        memset(buffer + depth + 1, ']', depth);
+        buffer[2 * depth + 1] = '\0';
+
+        jscon_tape_t *tape = jscon_tape_parse(buffer);
+        assert((depth <= max_depth) == (NULL != tape));
+        jscon_tape_destroy(tape);
+    }
+
+    free(buffer);
+}
+
+/* a frozen tree keeps the changes made to it, and its keys are found
+    no matter how many there are */
+static void
+test_freeze_lookup(void)
+{
+    char buffer[] = "{\"name\":\"john\",\"list\":[1,2]}";
+    jscon_item_t *root = jscon_parse(buffer);
+    jscon_set_string(jscon_get_branch(root, "name"), "a longer name than the one parsed");
+    jscon_append(root, jscon_double("pi", 3.5));
+
+    char key[16];
+    for (int i=0; i < 300; ++i){
+        snprintf(key, sizeof(key), "k%d", i);
+        jscon_append(root, jscon_integer(key, i));
+    }
+
+    jscon_tape_t *tape = jscon_freeze(root);
+    assert(NULL != tape);
+    compare(tape, 0, root);
+
+    assert(0 == strcmp("a longer name than the one parsed",
+                        jscon_tape_get_string(tape, jscon_tape_get_branch(tape, 0, "name"))));
+    assert(3.5 == jscon_tape_get_double(tape, jscon_tape_get_branch(tape, 0, "pi")));
+    for (int i=0; i < 300; ++i){
+        snprintf(key, sizeof(key), "k%d", i);
+        assert(i == jscon_tape_get_integer(tape, jscon_tape_get_branch(tape, 0, key)));
+    }
+    assert(0 == jscon_tape_get_branch(tape, 0, "k300"));
+
+    /* the tape doesn't depend on the tree once frozen */
+    jscon_destroy(root);
+    assert(303 == jscon_tape_size(tape, 0));
+    assert(2 == jscon_tape_size(tape, jscon_tape_get_branch(tape, 0, "list")));
+    jscon_tape_destroy(tape);
+}
+
+/* trees nested deeper than a tape allows aren't frozen */
+static void
+test_freeze_depth(void)
+{
+    const size_t depth = 1025;
+    char *buffer = malloc(2 * depth + 2);
+    assert(NULL != buffer);
+    memset(buffer, '[', depth);
+    buffer[depth] = '0';
+    memset(buffer + depth + 1, ']', depth);
+    buffer[2 * depth + 1] = '\0';
+
+    jscon_item_t *root = jscon_parse(buffer);
+    assert(NULL != root);
+    assert(NULL == jscon_freeze(root));
+
+    jscon_destroy(root);
+    free(buffer);
+}
+
+static void*
+freeze_thread(void *tape)
+{
+    for (int n=0; n < 1000; ++n){
+        char key[16];
+        snprintf(key, sizeof(key), "k%d", n % 100);
+        size_t index = jscon_tape_get_branch(tape, 0, key);
+        assert(0 != index);
+        assert(n % 100 == jscon_tape_get_integer(tape, index));
+    }
+    return NULL;
+}
+
+/* a frozen tree is read from many threads with no locks */
+static void
+test_freeze_threads(void)
+{
+    jscon_item_t *root = jscon_object(NULL);
+    char key[16];
+    for (int i=0; i < 100; ++i){
+        snprintf(key, sizeof(key), "k%d", i);
+        jscon_append(root, jscon_integer(key, i));
+    }
+    jscon_tape_t *tape = jscon_freeze(root);
+    jscon_destroy(root);
+
+    pthread_t threads[8];
+    for (int i=0; i < 8; ++i){
+        assert(0 == pthread_create(&threads[i], NULL, &freeze_thread, tape));
+    }
+    for (int i=0; i < 8; ++i){
+        pthread_join(threads[i], NULL);
+    }
+
+    jscon_tape_destroy(tape);
+}
+
+int main(void)
+{
+    test_tape_vs_tree();
+    test_tape_branch();
+    test_tape_key();
+    test_tape_byindex();
+    test_tape_depth();
+    test_freeze_lookup();
+    test_freeze_depth();
+    test_freeze_threads();
+
+    return EXIT_SUCCESS;
+}
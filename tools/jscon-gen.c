@@ -0,0 +1,742 @@
+/*
+ * Copyright (c) 2020 Lucas Müller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* jscon-gen: generates specialized decode/encode functions from a
+ * JSON Schema subset, check doc/jscon-gen.md for usage */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <libjscon.h>
+
+
+#define MAX_STRUCTS 256
+#define MAX_NAME_LEN 256
+#define DEFAULT_MAX_LENGTH 63
+
+enum field_kind {
+    FIELD_INTEGER,
+    FIELD_NUMBER,
+    FIELD_BOOLEAN,
+    FIELD_STRING,
+    FIELD_OBJECT,
+};
+
+/* a struct to be generated, nested structs come before their parent */
+struct gen_struct {
+    char name[MAX_NAME_LEN];
+    jscon_item_t *properties;
+};
+
+static struct gen_struct structs[MAX_STRUCTS];
+static size_t num_structs;
+
+/* helpers shared by every generated header, guarded so that multiple
+    generated headers may be included by the same translation unit */
+static const char *helpers[] = {
+    "#ifndef JSCON_GEN_HELPERS_",
+    "#define JSCON_GEN_HELPERS_",
+    "",
+    "#include <stdio.h>",
+    "#include <stdlib.h>",
+    "#include <stddef.h>",
+    "#include <stdbool.h>",
+    "#include <string.h>",
+    "#include <math.h>",
+    "",
+    "/* bounded output, behaves like snprintf */",
+    "struct jscon_gen_out_s {",
+    "    char *base;",
+    "    size_t size;",
+    "    size_t offset;",
+    "};",
+    "",
+    "static inline void",
+    "jscon_gen_write(struct jscon_gen_out_s *out, const char *str, size_t len)",
+    "{",
+    "    if (out->offset + len < out->size){",
+    "        memcpy(out->base + out->offset, str, len);",
+    "    } else if (out->offset + 1 < out->size){",
+    "        memcpy(out->base + out->offset, str, out->size - out->offset - 1);",
+    "    }",
+    "    out->offset += len;",
+    "}",
+    "",
+    "static inline size_t",
+    "jscon_gen_end(struct jscon_gen_out_s *out)",
+    "{",
+    "    if (0 != out->size){",
+    "        out->base[(out->offset < out->size) ? out->offset : out->size-1] = '\\0';",
+    "    }",
+    "    return out->offset;",
+    "}",
+    "",
+    "static inline void",
+    "jscon_gen_encode_integer(struct jscon_gen_out_s *out, long long i_number)",
+    "{",
+    "    char numstr[32];",
+    "    int len = snprintf(numstr, sizeof(numstr), \"%lld\", i_number);",
+    "    jscon_gen_write(out, numstr, (size_t)len);",
+    "}",
+    "",
+    "static inline void",
+    "jscon_gen_encode_double(struct jscon_gen_out_s *out, double d_number)",
+    "{",
+    "    if (!isfinite(d_number)){ /* json has no inf or nan */",
+    "        jscon_gen_write(out, \"null\", 4);",
+    "        return;",
+    "    }",
+    "    char numstr[32];",
+    "    int len = snprintf(numstr, sizeof(numstr), \"%.17g\", d_number);",
+    "    jscon_gen_write(out, numstr, (size_t)len);",
+    "}",
+    "",
+    "static inline void",
+    "jscon_gen_encode_boolean(struct jscon_gen_out_s *out, bool boolean)",
+    "{",
+    "    if (boolean){",
+    "        jscon_gen_write(out, \"true\", 4);",
+    "    } else {",
+    "        jscon_gen_write(out, \"false\", 5);",
+    "    }",
+    "}",
+    "",
+    "static inline void",
+    "jscon_gen_encode_string(struct jscon_gen_out_s *out, const char *string, size_t size)",
+    "{",
+    "    jscon_gen_write(out, \"\\\"\", 1);",
+    "    jscon_gen_write(out, string, strnlen(string, size));",
+    "    jscon_gen_write(out, \"\\\"\", 1);",
+    "}",
+    "",
+    "static inline char*",
+    "jscon_gen_blank(char *buffer, char *end)",
+    "{",
+    "    while (buffer < end && (' ' == *buffer || '\\t' == *buffer",
+    "                            || '\\n' == *buffer || '\\r' == *buffer))",
+    "    {",
+    "        ++buffer;",
+    "    }",
+    "    return buffer;",
+    "}",
+    "",
+    "static inline bool",
+    "jscon_gen_null(char **p_buffer, char *end)",
+    "{",
+    "    if (end - *p_buffer >= 4 && 0 == memcmp(*p_buffer, \"null\", 4)){",
+    "        *p_buffer += 4;",
+    "        return true;",
+    "    }",
+    "    return false;",
+    "}",
+    "",
+    "/* buffer must be right after the opening double quotes, returns the",
+    "    position of the closing double quotes */",
+    "static inline char*",
+    "jscon_gen_string_end(char *buffer, char *end)",
+    "{",
+    "    for ( ; buffer < end; ++buffer){",
+    "        if ('\\\\' == *buffer){",
+    "            ++buffer; /* skips escaped char */",
+    "        } else if ('\\\"' == *buffer){",
+    "            return buffer;",
+    "        }",
+    "    }",
+    "    return NULL;",
+    "}",
+    "",
+    "/* skips any json value */",
+    "static inline char*",
+    "jscon_gen_skip(char *buffer, char *end)",
+    "{",
+    "    int depth = 0;",
+    "    while (buffer < end){",
+    "        switch (*buffer){",
+    "        case '\\\"':",
+    "            buffer = jscon_gen_string_end(buffer + 1, end);",
+    "            if (NULL == buffer) return NULL;",
+    "            ++buffer;",
+    "            if (0 == depth) return buffer;",
+    "            continue;",
+    "        case '{':",
+    "        case '[':",
+    "            ++depth;",
+    "            break;",
+    "        case '}':",
+    "        case ']':",
+    "            if (0 == depth) return buffer;",
+    "            if (0 == --depth) return buffer + 1;",
+    "            break;",
+    "        case ',':",
+    "            if (0 == depth) return buffer;",
+    "            break;",
+    "        default:",
+    "            break;",
+    "        }",
+    "        ++buffer;",
+    "    }",
+    "    return NULL;",
+    "}",
+    "",
+    "static inline char*",
+    "jscon_gen_integer(char *buffer, char *end, long long *p_value)",
+    "{",
+    "    if (jscon_gen_null(&buffer, end)){",
+    "        *p_value = 0;",
+    "        return buffer;",
+    "    }",
+    "",
+    "    bool negative = (buffer < end && '-' == *buffer);",
+    "    if (negative) ++buffer;",
+    "    if (buffer >= end || (unsigned)(*buffer - '0') >= 10) return NULL;",
+    "",
+    "    unsigned long long value = 0;",
+    "    for ( ; buffer < end && (unsigned)(*buffer - '0') < 10; ++buffer){",
+    "        value = value * 10 + (unsigned)(*buffer - '0');",
+    "    }",
+    "    /* not an integer */",
+    "    if (buffer < end && ('.' == *buffer || 'e' == *buffer || 'E' == *buffer)){",
+    "        return NULL;",
+    "    }",
+    "",
+    "    *p_value = negative ? (long long)(0 - value) : (long long)value;",
+    "    return buffer;",
+    "}",
+    "",
+    "static inline char*",
+    "jscon_gen_double(char *buffer, char *end, double *p_value)",
+    "{",
+    "    if (jscon_gen_null(&buffer, end)){",
+    "        *p_value = 0.0;",
+    "        return buffer;",
+    "    }",
+    "    if (buffer >= end || ('-' != *buffer && (unsigned)(*buffer - '0') >= 10)){",
+    "        return NULL;",
+    "    }",
+    "",
+    "    /* strtod() is given a bounded copy, so it never reads past end */",
+    "    char numstr[64];",
+    "    size_t len = 0;",
+    "    while (buffer + len < end && len < sizeof(numstr) - 1",
+    "           && '\\0' != buffer[len] && NULL != strchr(\"+-.0123456789eE\", buffer[len]))",
+    "    {",
+    "        numstr[len] = buffer[len];",
+    "        ++len;",
+    "    }",
+    "    numstr[len] = '\\0';",
+    "",
+    "    char *num_end;",
+    "    *p_value = strtod(numstr, &num_end);",
+    "    return buffer + (num_end - numstr);",
+    "}",
+    "",
+    "static inline char*",
+    "jscon_gen_boolean(char *buffer, char *end, bool *p_value)",
+    "{",
+    "    if (end - buffer >= 4 && 0 == memcmp(buffer, \"true\", 4)){",
+    "        *p_value = true;",
+    "        return buffer + 4;",
+    "    }",
+    "    if (end - buffer >= 5 && 0 == memcmp(buffer, \"false\", 5)){",
+    "        *p_value = false;",
+    "        return buffer + 5;",
+    "    }",
+    "    if (jscon_gen_null(&buffer, end)){",
+    "        *p_value = false;",
+    "        return buffer;",
+    "    }",
+    "    return NULL;",
+    "}",
+    "",
+    "/* strings that don't fit dest are truncated */",
+    "static inline char*",
+    "jscon_gen_string(char *buffer, char *end, char *dest, size_t size)",
+    "{",
+    "    if (jscon_gen_null(&buffer, end)){",
+    "        *dest = '\\0';",
+    "        return buffer;",
+    "    }",
+    "    if (buffer >= end || '\\\"' != *buffer) return NULL;",
+    "",
+    "    char *string = buffer + 1;",
+    "    buffer = jscon_gen_string_end(string, end);",
+    "    if (NULL == buffer) return NULL;",
+    "",
+    "    size_t len = buffer - string;",
+    "    if (len >= size){",
+    "        len = size - 1;",
+    "    }",
+    "    memcpy(dest, string, len);",
+    "    dest[len] = '\\0';",
+    "",
+    "    return buffer + 1;",
+    "}",
+    "",
+    "#endif /* JSCON_GEN_HELPERS_ */",
+    NULL
+};
+
+
+static void
+die(const char *msg, const char *detail)
+{
+    fprintf(stderr, "jscon-gen: %s%s\n", msg, detail);
+    exit(EXIT_FAILURE);
+}
+
+static char*
+read_file(const char *filename)
+{
+    FILE *f = fopen(filename, "rb");
+    if (NULL == f) die("can't open ", filename);
+
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *buffer = malloc(len + 1);
+    if (NULL == buffer) die("out of memory", "");
+
+    if ((size_t)len != fread(buffer, 1, len, f)) die("can't read ", filename);
+    buffer[len] = '\0';
+
+    fclose(f);
+
+    return buffer;
+}
+
+/* C keywords, along with the macros of the headers included by the
+    generated code, can't be used as identifiers */
+static const char *reserved[] = {
+    "auto", "break", "case", "char", "const", "continue", "default", "do",
+    "double", "else", "enum", "extern", "float", "for", "goto", "if",
+    "inline", "int", "long", "register", "restrict", "return", "short",
+    "signed", "sizeof", "static", "struct", "switch", "typedef", "union",
+    "unsigned", "void", "volatile", "while", "_Alignas", "_Alignof",
+    "_Atomic", "_Bool", "_Complex", "_Generic", "_Imaginary", "_Noreturn",
+    "_Static_assert", "_Thread_local", "bool", "true", "false", "NULL",
+    "offsetof", "errno", "assert", NULL
+};
+
+/* converts a json key to a valid C identifier, characters that aren't
+    valid are replaced by '_' and reserved words get a '_' suffix */
+static void
+to_identifier(char *dest, size_t size, const char *src)
+{
+    size_t i = 0;
+    if (isdigit((unsigned char)*src) && i + 1 < size){
+        dest[i++] = '_';
+    }
+    for ( ; '\0' != *src && i + 1 < size; ++src){
+        dest[i++] = isalnum((unsigned char)*src) ? *src : '_';
+    }
+    dest[i] = '\0';
+
+    for (size_t j=0; NULL != reserved[j]; ++j){
+        if (0 == strcmp(dest, reserved[j]) && i + 1 < size){
+            dest[i++] = '_';
+            dest[i] = '\0';
+            break;
+        }
+    }
+}
+
+/* writes str escaped as the contents of a C string literal */
+static void
+emit_c_string(FILE *out, const char *str)
+{
+    for ( ; '\0' != *str; ++str){
+        if ('\\' == *str || '\"' == *str){
+            fputc('\\', out);
+        }
+        fputc(*str, out);
+    }
+}
+
+static enum field_kind
+property_kind(jscon_item_t *property)
+{
+    jscon_item_t *type = jscon_get_branch(property, "type");
+    if (NULL == type || JSCON_STRING != jscon_get_type(type)){
+        die("missing \"type\" for property ", jscon_get_key(property));
+    }
+
+    char *string = jscon_get_string(type);
+    if (0 == strcmp(string, "integer")) return FIELD_INTEGER;
+    if (0 == strcmp(string, "number")) return FIELD_NUMBER;
+    if (0 == strcmp(string, "boolean")) return FIELD_BOOLEAN;
+    if (0 == strcmp(string, "string")) return FIELD_STRING;
+    if (0 == strcmp(string, "object")) return FIELD_OBJECT;
+
+    die("unsupported type ", string);
+    return FIELD_INTEGER;
+}
+
+/* string members are char arrays of maxLength+1 */
+static long long
+property_max_length(jscon_item_t *property)
+{
+    jscon_item_t *max_length = jscon_get_branch(property, "maxLength");
+    if (NULL == max_length) return DEFAULT_MAX_LENGTH;
+
+    if (JSCON_INTEGER != jscon_get_type(max_length) || jscon_get_integer(max_length) < 0){
+        die("bad \"maxLength\" for property ", jscon_get_key(property));
+    }
+    return jscon_get_integer(max_length);
+}
+
+static jscon_item_t*
+schema_properties(jscon_item_t *schema, const char *name)
+{
+    jscon_item_t *properties = jscon_get_branch(schema, "properties");
+    if (NULL == properties || JSCON_OBJECT != jscon_get_type(properties)){
+        die("missing \"properties\" object for ", name);
+    }
+    return properties;
+}
+
+/* different keys may convert to the same identifier (ex: "a-b" and
+    "a_b"), which would give a struct with duplicate members */
+static void
+check_members(jscon_item_t *properties, const char *name)
+{
+    const size_t num_properties = jscon_size(properties);
+    for (size_t i=0; i < num_properties; ++i){
+        char member[MAX_NAME_LEN];
+        to_identifier(member, sizeof(member), jscon_get_key(jscon_get_byindex(properties, i)));
+
+        for (size_t j=i+1; j < num_properties; ++j){
+            char other[MAX_NAME_LEN];
+            to_identifier(other, sizeof(other), jscon_get_key(jscon_get_byindex(properties, j)));
+            if (0 == strcmp(member, other)){
+                fprintf(stderr, "jscon-gen: keys \"%s\" and \"%s\" of %s both convert to member %s\n",
+                        jscon_get_key(jscon_get_byindex(properties, i)),
+                        jscon_get_key(jscon_get_byindex(properties, j)),
+                        name, member);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+}
+
+/* gathers nested object schemas first, so that every struct is
+    declared before its parent */
+static void
+collect_structs(jscon_item_t *schema, const char *name)
+{
+    jscon_item_t *properties = schema_properties(schema, name);
+    check_members(properties, name);
+
+    for (size_t i=0; i < jscon_size(properties); ++i){
+        jscon_item_t *property = jscon_get_byindex(properties, i);
+        if (FIELD_OBJECT != property_kind(property)) continue;
+
+        char member[MAX_NAME_LEN];
+        to_identifier(member, sizeof(member), jscon_get_key(property));
+
+        char nested[MAX_NAME_LEN];
+        if ((int)sizeof(nested) <= snprintf(nested, sizeof(nested), "%s_%s", name, member)){
+            die("name too long for nested object ", member);
+        }
+        collect_structs(property, nested);
+    }
+
+    if (MAX_STRUCTS == num_structs) die("too many nested objects at ", name);
+
+    /* nested struct names are joined by '_', so they may collide as
+        well (ex: {"a_b":{}} and {"a":{"b":{}}}) */
+    for (size_t i=0; i < num_structs; ++i){
+        if (0 == strcmp(structs[i].name, name)) die("struct name collides: ", name);
+    }
+
+    snprintf(structs[num_structs].name, MAX_NAME_LEN, "%s", name);
+    structs[num_structs].properties = properties;
+    ++num_structs;
+}
+
+static void
+emit_struct(FILE *out, const struct gen_struct *st)
+{
+    fprintf(out, "struct %s {\n", st->name);
+    for (size_t i=0; i < jscon_size(st->properties); ++i){
+        jscon_item_t *property = jscon_get_byindex(st->properties, i);
+
+        char member[MAX_NAME_LEN];
+        to_identifier(member, sizeof(member), jscon_get_key(property));
+
+        switch (property_kind(property)){
+        case FIELD_INTEGER:
+            fprintf(out, "    long long %s;\n", member);
+            break;
+        case FIELD_NUMBER:
+            fprintf(out, "    double %s;\n", member);
+            break;
+        case FIELD_BOOLEAN:
+            fprintf(out, "    bool %s;\n", member);
+            break;
+        case FIELD_STRING:
+            fprintf(out, "    char %s[%lld];\n", member, property_max_length(property) + 1);
+            break;
+        case FIELD_OBJECT:
+            fprintf(out, "    struct %s_%s %s;\n", st->name, member, member);
+            break;
+        }
+    }
+    fprintf(out, "};\n\n");
+}
+
+static void
+emit_field_decode(FILE *out, const struct gen_struct *st, jscon_item_t *property)
+{
+    char member[MAX_NAME_LEN];
+    to_identifier(member, sizeof(member), jscon_get_key(property));
+
+    switch (property_kind(property)){
+    case FIELD_INTEGER:
+        fprintf(out, "                buffer = jscon_gen_integer(buffer, end, &p_struct->%s);\n", member);
+        break;
+    case FIELD_NUMBER:
+        fprintf(out, "                buffer = jscon_gen_double(buffer, end, &p_struct->%s);\n", member);
+        break;
+    case FIELD_BOOLEAN:
+        fprintf(out, "                buffer = jscon_gen_boolean(buffer, end, &p_struct->%s);\n", member);
+        break;
+    case FIELD_STRING:
+        fprintf(out, "                buffer = jscon_gen_string(buffer, end, p_struct->%s, sizeof(p_struct->%s));\n", member, member);
+        break;
+    case FIELD_OBJECT:
+        fprintf(out, "                buffer = %s_%s_decode_r(buffer, end, &p_struct->%s);\n", st->name, member, member);
+        break;
+    }
+}
+
+/* keys are dispatched by their length, then matched by memcmp() */
+static void
+emit_decoder(FILE *out, const struct gen_struct *st)
+{
+    fprintf(out,
+        "static inline char*\n"
+        "%s_decode_r(char *buffer, char *end, struct %s *p_struct)\n"
+        "{\n"
+        "    if (jscon_gen_null(&buffer, end)){\n"
+        "        memset(p_struct, 0, sizeof(*p_struct));\n"
+        "        return buffer;\n"
+        "    }\n"
+        "    if (buffer >= end || '{' != *buffer) return NULL;\n"
+        "    ++buffer;\n"
+        "\n"
+        "    while (true){\n"
+        "        buffer = jscon_gen_blank(buffer, end);\n"
+        "        if (buffer >= end) return NULL;\n"
+        "        if ('}' == *buffer) return buffer + 1;\n"
+        "        if (',' == *buffer){\n"
+        "            ++buffer;\n"
+        "            continue;\n"
+        "        }\n"
+        "        if ('\\\"' != *buffer) return NULL;\n"
+        "\n"
+        "        char *key = buffer + 1;\n"
+        "        buffer = jscon_gen_string_end(key, end);\n"
+        "        if (NULL == buffer) return NULL;\n"
+        "        size_t len = buffer - key;\n"
+        "\n"
+        "        buffer = jscon_gen_blank(buffer + 1, end);\n"
+        "        if (buffer >= end || ':' != *buffer) return NULL;\n"
+        "        buffer = jscon_gen_blank(buffer + 1, end);\n"
+        "\n"
+        "        switch (len){\n",
+        st->name, st->name);
+
+    size_t num_properties = jscon_size(st->properties);
+    for (size_t i=0; i < num_properties; ++i){
+        size_t len = strlen(jscon_get_key(jscon_get_byindex(st->properties, i)));
+
+        /* skip lengths that already have a case */
+        size_t j;
+        for (j=0; j < i; ++j){
+            if (len == strlen(jscon_get_key(jscon_get_byindex(st->properties, j)))) break;
+        }
+        if (j != i) continue;
+
+        fprintf(out, "        case %zu:\n", len);
+        for (j=i; j < num_properties; ++j){
+            jscon_item_t *property = jscon_get_byindex(st->properties, j);
+            char *key = jscon_get_key(property);
+            if (len != strlen(key)) continue;
+
+            fprintf(out, "            if (0 == memcmp(key, \"");
+            emit_c_string(out, key);
+            fprintf(out, "\", %zu)){\n", len);
+            emit_field_decode(out, st, property);
+            fprintf(out, "                break;\n");
+            fprintf(out, "            }\n");
+        }
+        fprintf(out, "            buffer = jscon_gen_skip(buffer, end);\n");
+        fprintf(out, "            break;\n");
+    }
+
+    fprintf(out,
+        "        default:\n"
+        "            buffer = jscon_gen_skip(buffer, end);\n"
+        "            break;\n"
+        "        }\n"
+        "        if (NULL == buffer) return NULL;\n"
+        "    }\n"
+        "}\n"
+        "\n"
+        "/* fills p_struct from the json object at buffer, returns the amount\n"
+        "    of chars read, or 0 if it doesn't match the schema */\n"
+        "static inline size_t\n"
+        "%s_decode(char *buffer, size_t len, struct %s *p_struct)\n"
+        "{\n"
+        "    char *end = buffer + len;\n"
+        "    char *stop = %s_decode_r(jscon_gen_blank(buffer, end), end, p_struct);\n"
+        "    return (NULL != stop) ? (size_t)(stop - buffer) : 0;\n"
+        "}\n"
+        "\n",
+        st->name, st->name, st->name);
+}
+
+static void
+emit_encoder(FILE *out, const struct gen_struct *st)
+{
+    fprintf(out,
+        "static inline void\n"
+        "%s_encode_r(const struct %s *p_struct, struct jscon_gen_out_s *out)\n"
+        "{\n",
+        st->name, st->name);
+
+    size_t num_properties = jscon_size(st->properties);
+    for (size_t i=0; i < num_properties; ++i){
+        jscon_item_t *property = jscon_get_byindex(st->properties, i);
+        char *key = jscon_get_key(property);
+
+        char member[MAX_NAME_LEN];
+        to_identifier(member, sizeof(member), key);
+
+        /* separator and key are written by a single literal */
+        fprintf(out, "    jscon_gen_write(out, \"%s\\\"", (0 == i) ? "{" : ",");
+        emit_c_string(out, key);
+        fprintf(out, "\\\":\", %zu);\n", strlen(key) + 4);
+
+        switch (property_kind(property)){
+        case FIELD_INTEGER:
+            fprintf(out, "    jscon_gen_encode_integer(out, p_struct->%s);\n", member);
+            break;
+        case FIELD_NUMBER:
+            fprintf(out, "    jscon_gen_encode_double(out, p_struct->%s);\n", member);
+            break;
+        case FIELD_BOOLEAN:
+            fprintf(out, "    jscon_gen_encode_boolean(out, p_struct->%s);\n", member);
+            break;
+        case FIELD_STRING:
+            fprintf(out, "    jscon_gen_encode_string(out, p_struct->%s, sizeof(p_struct->%s));\n", member, member);
+            break;
+        case FIELD_OBJECT:
+            fprintf(out, "    %s_%s_encode_r(&p_struct->%s, out);\n", st->name, member, member);
+            break;
+        }
+    }
+    if (0 == num_properties){
+        fprintf(out, "    jscon_gen_write(out, \"{\", 1);\n");
+    }
+
+    fprintf(out,
+        "    jscon_gen_write(out, \"}\", 1);\n"
+        "}\n"
+        "\n"
+        "/* works like snprintf, returns the length the json text would have\n"
+        "    if size was big enough (excluding nul char) */\n"
+        "static inline size_t\n"
+        "%s_encode(const struct %s *p_struct, char *buffer, size_t size)\n"
+        "{\n"
+        "    struct jscon_gen_out_s out = { buffer, size, 0 };\n"
+        "    %s_encode_r(p_struct, &out);\n"
+        "    return jscon_gen_end(&out);\n"
+        "}\n"
+        "\n",
+        st->name, st->name, st->name);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2){
+        fprintf(stderr, "Usage: %s <schema.json> [output.h]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char *json_text = read_file(argv[1]);
+    jscon_item_t *schema = jscon_parse(json_text);
+    if (NULL == schema || JSCON_OBJECT != jscon_get_type(schema)){
+        die("schema must be an object: ", argv[1]);
+    }
+
+    jscon_item_t *title = jscon_get_branch(schema, "title");
+    if (NULL == title || JSCON_STRING != jscon_get_type(title)){
+        die("missing \"title\" string at ", argv[1]);
+    }
+
+    char name[MAX_NAME_LEN];
+    to_identifier(name, sizeof(name), jscon_get_string(title));
+    collect_structs(schema, name);
+
+    FILE *out = stdout;
+    if (argc > 2){
+        out = fopen(argv[2], "w");
+        if (NULL == out) die("can't open ", argv[2]);
+    }
+
+    char guard[MAX_NAME_LEN];
+    size_t i;
+    for (i=0; '\0' != name[i]; ++i){
+        guard[i] = toupper((unsigned char)name[i]);
+    }
+    guard[i] = '\0';
+
+    fprintf(out, "/* generated by jscon-gen from %s, do not edit */\n\n", argv[1]);
+    fprintf(out, "#ifndef %s_JSCON_GEN_H_\n#define %s_JSCON_GEN_H_\n\n", guard, guard);
+    for (i=0; NULL != helpers[i]; ++i){
+        fprintf(out, "%s\n", helpers[i]);
+    }
+    fputc('\n', out);
+
+    for (i=0; i < num_structs; ++i){
+        emit_struct(out, &structs[i]);
+    }
+    for (i=0; i < num_structs; ++i){
+        emit_decoder(out, &structs[i]);
+        emit_encoder(out, &structs[i]);
+    }
+
+    fprintf(out, "#endif /* %s_JSCON_GEN_H_ */\n", guard);
+
+    if (stdout != out){
+        fclose(out);
+    }
+
+    jscon_destroy(schema);
+    free(json_text);
+
+    return EXIT_SUCCESS;
+}